@@ -0,0 +1,85 @@
+#include "benchmark.h"
+
+#include "bas/array_ref.h"
+#include "bas/vector.h"
+
+namespace bas {
+
+/* Args: number of elements. The searched value is not in the array, so
+ * that every element is compared. */
+template<typename T> static void array_ref_contains(BenchmarkState &state)
+{
+    size_t amount = (size_t)state.arg(0);
+    Vector<T> values;
+    for (size_t i = 0; i < amount; i++) {
+        values.append((T)i);
+    }
+    ArrayRef<T> array = values;
+    T missing = (T)amount;
+    for (auto _ : state) {
+        do_not_optimize(array.contains(missing));
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static void array_ref_contains_int32(BenchmarkState &state)
+{
+    array_ref_contains<int32_t>(state);
+}
+
+static void array_ref_contains_uint64(BenchmarkState &state)
+{
+    array_ref_contains<uint64_t>(state);
+}
+
+static void array_ref_count_int32(BenchmarkState &state)
+{
+    size_t amount = (size_t)state.arg(0);
+    Vector<int32_t> values;
+    for (size_t i = 0; i < amount; i++) {
+        values.append((int32_t)(i % 7));
+    }
+    ArrayRef<int32_t> array = values;
+    for (auto _ : state) {
+        do_not_optimize(array.count(3));
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static void array_ref_max_int32(BenchmarkState &state)
+{
+    size_t amount = (size_t)state.arg(0);
+    Vector<int32_t> values;
+    for (size_t i = 0; i < amount; i++) {
+        values.append((int32_t)((i * 7919) % 100003));
+    }
+    ArrayRef<int32_t> array = values;
+    for (auto _ : state) {
+        do_not_optimize(array.max());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+/* Args: number of appended elements, of which only a few are distinct. */
+static void vector_append_non_duplicates(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        Vector<uint32_t> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.append_non_duplicates(i % 64);
+        }
+        do_not_optimize(vector.begin());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static const Vector<Vector<int64_t>> search_args = {
+    {16}, {256}, {4096}, {65536}};
+BAS_BENCHMARK(array_ref_contains_int32, search_args);
+BAS_BENCHMARK(array_ref_contains_uint64, search_args);
+BAS_BENCHMARK(array_ref_count_int32, search_args);
+BAS_BENCHMARK(array_ref_max_int32, search_args);
+BAS_BENCHMARK(vector_append_non_duplicates, {{1000}, {100000}});
+
+}  // namespace bas
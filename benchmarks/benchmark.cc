@@ -0,0 +1,222 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "benchmark.h"
+
+namespace bas {
+
+struct RegisteredBenchmark {
+    const char *name;
+    BenchmarkFunction function;
+    Vector<Vector<int64_t>> arg_lists;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    uint64_t iterations;
+    double seconds_per_iteration;
+    double items_per_second;
+};
+
+static Vector<RegisteredBenchmark> &registered_benchmarks()
+{
+    static Vector<RegisteredBenchmark> benchmarks;
+    return benchmarks;
+}
+
+bool register_benchmark(const char *name,
+                        BenchmarkFunction function,
+                        Vector<Vector<int64_t>> arg_lists)
+{
+    if (arg_lists.size() == 0) {
+        arg_lists.append({});
+    }
+    registered_benchmarks().append({name, function, std::move(arg_lists)});
+    return true;
+}
+
+Vector<Vector<int64_t>> cross_product(
+    const Vector<Vector<int64_t>> &values_per_arg)
+{
+    Vector<Vector<int64_t>> result;
+    result.append({});
+    for (const Vector<int64_t> &values : values_per_arg) {
+        Vector<Vector<int64_t>> extended;
+        for (const Vector<int64_t> &prefix : result) {
+            for (int64_t value : values) {
+                Vector<int64_t> args = prefix;
+                args.append(value);
+                extended.append(std::move(args));
+            }
+        }
+        result = std::move(extended);
+    }
+    return result;
+}
+
+static std::string run_name(const char *name,
+                            const Vector<int64_t> &args,
+                            const std::string &label)
+{
+    std::stringstream ss;
+    ss << name;
+    for (int64_t arg : args) {
+        ss << '/' << arg;
+    }
+    if (!label.empty()) {
+        ss << '/' << label;
+    }
+    return ss.str();
+}
+
+/**
+ * Run the benchmark with an increasing number of iterations until it takes
+ * at least min_seconds.
+ */
+static BenchmarkResult run_benchmark(const RegisteredBenchmark &benchmark,
+                                     const Vector<int64_t> &args,
+                                     double min_seconds)
+{
+    uint64_t iterations = 1;
+    while (true) {
+        BenchmarkState state(args, iterations);
+        benchmark.function(state);
+        double seconds = state.elapsed_seconds();
+        if (seconds >= min_seconds || iterations >= ((uint64_t)1 << 40)) {
+            BenchmarkResult result;
+            result.name = run_name(benchmark.name, args, state.label());
+            result.iterations = iterations;
+            result.seconds_per_iteration = seconds / (double)iterations;
+            result.items_per_second =
+                (seconds > 0.0) ? (double)state.items_processed() / seconds :
+                                  0.0;
+            return result;
+        }
+        /* Aim for a bit more than the min time based on the last run. */
+        double factor = (seconds > 0.0) ? min_seconds * 1.4 / seconds : 10.0;
+        factor = std::min(std::max(factor, 2.0), 10.0);
+        iterations = (uint64_t)((double)iterations * factor);
+    }
+}
+
+static void print_result(const BenchmarkResult &result)
+{
+    char line[256];
+    snprintf(line,
+             sizeof(line),
+             "%-60s %14.1f ns %12llu",
+             result.name.c_str(),
+             result.seconds_per_iteration * 1e9,
+             (unsigned long long)result.iterations);
+    std::cout << line;
+    if (result.items_per_second > 0.0) {
+        std::cout << "  " << result.items_per_second / 1e6 << " M items/s";
+    }
+    std::cout << std::endl;
+}
+
+static void write_json(std::ostream &stream,
+                       const Vector<BenchmarkResult> &results)
+{
+    stream << "{\n";
+    stream << "  \"context\": {\n";
+#ifdef NDEBUG
+    stream << "    \"library_build_type\": \"release\"\n";
+#else
+    stream << "    \"library_build_type\": \"debug\"\n";
+#endif
+    stream << "  },\n";
+    stream << "  \"benchmarks\": [";
+    for (uint32_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &result = results[i];
+        stream << (i == 0 ? "\n" : ",\n");
+        stream << "    {\n";
+        stream << "      \"name\": \"" << result.name << "\",\n";
+        stream << "      \"iterations\": " << result.iterations << ",\n";
+        stream << "      \"real_time\": "
+               << result.seconds_per_iteration * 1e9 << ",\n";
+        stream << "      \"time_unit\": \"ns\",\n";
+        stream << "      \"items_per_second\": " << result.items_per_second
+               << "\n";
+        stream << "    }";
+    }
+    stream << "\n  ]\n}\n";
+}
+
+static void print_usage()
+{
+    std::cout << "Usage: benchmarks [options]\n"
+                 "  --filter=TEXT     Only run benchmarks whose name contains "
+                 "TEXT.\n"
+                 "  --min-time=SEC    Minimum time per benchmark run, "
+                 "default 0.2.\n"
+                 "  --json=PATH       Write the results as JSON to PATH.\n"
+                 "  --list            Only print the benchmark names.\n";
+}
+
+static bool starts_with(const char *str, const char *prefix)
+{
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+}  // namespace bas
+
+int main(int argc, char **argv)
+{
+    using namespace bas;
+
+    std::string filter;
+    std::string json_path;
+    double min_seconds = 0.2;
+    bool only_list = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (starts_with(arg, "--filter=")) {
+            filter = arg + strlen("--filter=");
+        }
+        else if (starts_with(arg, "--min-time=")) {
+            min_seconds = atof(arg + strlen("--min-time="));
+        }
+        else if (starts_with(arg, "--json=")) {
+            json_path = arg + strlen("--json=");
+        }
+        else if (strcmp(arg, "--list") == 0) {
+            only_list = true;
+        }
+        else {
+            print_usage();
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    Vector<BenchmarkResult> results;
+    for (const RegisteredBenchmark &benchmark : registered_benchmarks()) {
+        if (std::string(benchmark.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        if (only_list) {
+            std::cout << benchmark.name << '\n';
+            continue;
+        }
+        for (const Vector<int64_t> &args : benchmark.arg_lists) {
+            BenchmarkResult result = run_benchmark(
+                benchmark, args, min_seconds);
+            print_result(result);
+            results.append(std::move(result));
+        }
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream stream(json_path);
+        if (!stream) {
+            std::cerr << "Cannot write to " << json_path << '\n';
+            return 1;
+        }
+        write_json(stream, results);
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+/**
+ * A minimal micro benchmark harness, modelled after Google Benchmark.
+ *
+ * A benchmark is a function that takes a BenchmarkState. The code that should
+ * be measured is put into a loop over the state. Everything before the loop is
+ * setup and is not measured:
+ *
+ *   static void map_lookup(BenchmarkState &state)
+ *   {
+ *       Map<int, int> map = ...;
+ *       for (auto _ : state) {
+ *           do_not_optimize(map.lookup(42));
+ *       }
+ *   }
+ *   BAS_BENCHMARK(map_lookup, {{1024}, {65536}});
+ *
+ * The runner increases the number of iterations until the measured time is
+ * long enough. Every benchmark is run once for every list of arguments.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "bas/vector.h"
+
+namespace bas {
+
+class BenchmarkState {
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    Vector<int64_t> m_args;
+    uint64_t m_iterations;
+    uint64_t m_items_processed = 0;
+    std::string m_label;
+    Clock::time_point m_start;
+    Clock::time_point m_end;
+
+  public:
+    BenchmarkState(Vector<int64_t> args, uint64_t iterations)
+        : m_args(std::move(args)), m_iterations(iterations)
+    {
+    }
+
+    /**
+     * Get an argument of the current run.
+     */
+    int64_t arg(uint32_t index) const
+    {
+        return m_args[index];
+    }
+
+    uint64_t iterations() const
+    {
+        return m_iterations;
+    }
+
+    /**
+     * Set how many items have been processed in total over all iterations.
+     * This is used to report a throughput.
+     */
+    void set_items_processed(uint64_t amount)
+    {
+        m_items_processed = amount;
+    }
+
+    uint64_t items_processed() const
+    {
+        return m_items_processed;
+    }
+
+    /**
+     * Add a human readable suffix to the name of this run, e.g. the name of a
+     * key distribution.
+     */
+    void set_label(std::string label)
+    {
+        m_label = std::move(label);
+    }
+
+    const std::string &label() const
+    {
+        return m_label;
+    }
+
+    double elapsed_seconds() const
+    {
+        return std::chrono::duration<double>(m_end - m_start).count();
+    }
+
+    /* The loop variable is never used. The attribute avoids warnings. */
+    struct [[maybe_unused]] IterationValue {
+    };
+
+    class Iterator {
+      private:
+        BenchmarkState *m_state;
+        uint64_t m_remaining;
+
+      public:
+        Iterator(BenchmarkState *state, uint64_t remaining)
+            : m_state(state), m_remaining(remaining)
+        {
+        }
+
+        Iterator &operator++()
+        {
+            m_remaining--;
+            return *this;
+        }
+
+        bool operator!=(const Iterator &iterator) const
+        {
+            if (m_remaining != iterator.m_remaining) {
+                return true;
+            }
+            m_state->m_end = Clock::now();
+            return false;
+        }
+
+        IterationValue operator*() const
+        {
+            return {};
+        }
+    };
+
+    Iterator begin()
+    {
+        m_start = Clock::now();
+        return Iterator(this, m_iterations);
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, 0);
+    }
+};
+
+using BenchmarkFunction = void (*)(BenchmarkState &state);
+
+/**
+ * Register a benchmark that is run once for every list of arguments. Returns
+ * a dummy value so that it can be used in static initializers.
+ */
+bool register_benchmark(const char *name,
+                        BenchmarkFunction function,
+                        Vector<Vector<int64_t>> arg_lists);
+
+/**
+ * Build all combinations of the given argument values.
+ */
+Vector<Vector<int64_t>> cross_product(
+    const Vector<Vector<int64_t>> &values_per_arg);
+
+/**
+ * Prevent the compiler from removing the computation of a value that is not
+ * used otherwise.
+ */
+template<typename T> inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Call func(thread_index) in the given amount of threads and wait until all
+ * of them are done. Used by benchmarks of thread-safe containers.
+ */
+template<typename FuncT>
+inline void run_in_threads(uint32_t thread_amount, const FuncT &func)
+{
+    Vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_amount; i++) {
+        threads.append(std::thread([&func, i]() { func(i); }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace bas
+
+#define BAS_BENCHMARK(FUNCTION, ...) \
+    static bool FUNCTION##_is_registered = ::bas::register_benchmark( \
+        #FUNCTION, FUNCTION, __VA_ARGS__)
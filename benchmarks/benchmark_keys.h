@@ -0,0 +1,131 @@
+#pragma once
+
+/**
+ * Key generators that are shared by the container benchmarks. All generators
+ * are deterministic, so that results of different runs can be compared.
+ */
+
+#include <random>
+#include <string>
+
+#include "bas/vector.h"
+
+namespace bas {
+
+enum class KeyDistribution {
+    /* 0, 1, 2, ... */
+    Sequential = 0,
+    /* Uniformly distributed 64 bit integers. */
+    Random = 1,
+    /* Addresses of small heap objects: 16 byte aligned and in clusters. */
+    ClusteredPointers = 2,
+};
+
+/* Argument values that select a distribution in benchmarks. */
+static const Vector<int64_t> all_key_distributions = {
+    (int64_t)KeyDistribution::Sequential,
+    (int64_t)KeyDistribution::Random,
+    (int64_t)KeyDistribution::ClusteredPointers,
+};
+
+/* Element counts that roughly fit into L1, L2, L3 and main memory. */
+static const Vector<int64_t> table_sizes = {
+    1 << 10, 1 << 14, 1 << 18, 1 << 22};
+
+/* Percentage of lookups that find the key. */
+static const Vector<int64_t> hit_percentages = {0, 50, 100};
+
+inline const char *key_distribution_name(KeyDistribution distribution)
+{
+    switch (distribution) {
+        case KeyDistribution::Sequential:
+            return "sequential";
+        case KeyDistribution::Random:
+            return "random";
+        case KeyDistribution::ClusteredPointers:
+            return "clustered_pointers";
+    }
+    return "";
+}
+
+/**
+ * Generate distinct keys. Generating more keys with the same distribution
+ * and seed always extends the previous result, so the keys after the first n
+ * ones can be used for lookups that miss.
+ */
+inline Vector<uint64_t> make_int_keys(KeyDistribution distribution,
+                                      uint32_t amount,
+                                      uint64_t seed = 0)
+{
+    Vector<uint64_t> keys;
+    keys.reserve(amount);
+    std::mt19937_64 rng(seed);
+    switch (distribution) {
+        case KeyDistribution::Sequential:
+            for (uint32_t i = 0; i < amount; i++) {
+                keys.append(i);
+            }
+            break;
+        case KeyDistribution::Random:
+            /* Duplicates are so unlikely that they are ignored. */
+            for (uint32_t i = 0; i < amount; i++) {
+                keys.append(rng());
+            }
+            break;
+        case KeyDistribution::ClusteredPointers: {
+            const uint64_t base = 0x7f0000000000ull;
+            const uint32_t objects_per_cluster = 64;
+            for (uint32_t i = 0; i < amount; i++) {
+                uint64_t cluster = i / objects_per_cluster;
+                uint64_t index = i % objects_per_cluster;
+                keys.append(base + cluster * (1 << 20) + index * 16);
+            }
+            break;
+        }
+    }
+    return keys;
+}
+
+/**
+ * Generate distinct strings that share a long prefix, like urls or paths.
+ */
+inline Vector<std::string> make_string_keys(uint32_t amount,
+                                            uint32_t length,
+                                            uint64_t seed = 0)
+{
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    Vector<std::string> keys;
+    keys.reserve(amount);
+    std::mt19937_64 rng(seed);
+    for (uint32_t i = 0; i < amount; i++) {
+        std::string key = "https://example.com/" + std::to_string(i) + "/";
+        while (key.size() < length) {
+            key += chars[rng() % (sizeof(chars) - 1)];
+        }
+        keys.append(std::move(key));
+    }
+    return keys;
+}
+
+/**
+ * Build the sequence of keys that is used for lookups. The first half of
+ * `keys` is assumed to be in the container, the second half is not.
+ */
+template<typename T>
+inline Vector<T> make_lookup_keys(const Vector<T> &keys,
+                                  int64_t hit_percentage,
+                                  uint64_t seed = 1)
+{
+    uint32_t half = (uint32_t)keys.size() / 2;
+    Vector<T> lookups;
+    lookups.reserve(half);
+    std::mt19937_64 rng(seed);
+    for (uint32_t i = 0; i < half; i++) {
+        bool hit = (int64_t)(rng() % 100) < hit_percentage;
+        uint32_t index = (uint32_t)(rng() % half);
+        lookups.append(keys[hit ? index : half + index]);
+    }
+    return lookups;
+}
+
+}  // namespace bas
@@ -0,0 +1,95 @@
+#include <mutex>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/concurrent_map.h"
+#include "bas/map.h"
+
+namespace bas {
+
+static const uint32_t lookups_per_thread = 1 << 16;
+
+/* Args: thread amount, size. */
+static void concurrent_map_lookup(BenchmarkState &state)
+{
+    uint32_t thread_amount = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, 50);
+
+    ConcurrentMap<uint64_t, uint32_t> map;
+    for (uint32_t i = 0; i < size; i++) {
+        map.add(keys[i], i);
+    }
+
+    for (auto _ : state) {
+        run_in_threads(thread_amount, [&](uint32_t thread_index) {
+            uint32_t found = 0;
+            for (uint32_t i = 0; i < lookups_per_thread; i++) {
+                uint64_t key = lookups[(i + thread_index * 997) & (size - 1)];
+                found += map.contains(key) ? 1 : 0;
+            }
+            do_not_optimize(found);
+        });
+    }
+    state.set_items_processed(state.iterations() * thread_amount *
+                              lookups_per_thread);
+}
+
+/* Args: thread amount, size. The baseline that puts a mutex around a map. */
+static void mutex_map_lookup(BenchmarkState &state)
+{
+    uint32_t thread_amount = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, 50);
+
+    Map<uint64_t, uint32_t> map;
+    std::mutex mutex;
+    for (uint32_t i = 0; i < size; i++) {
+        map.add(keys[i], i);
+    }
+
+    for (auto _ : state) {
+        run_in_threads(thread_amount, [&](uint32_t thread_index) {
+            uint32_t found = 0;
+            for (uint32_t i = 0; i < lookups_per_thread; i++) {
+                uint64_t key = lookups[(i + thread_index * 997) & (size - 1)];
+                std::lock_guard<std::mutex> lock(mutex);
+                found += map.contains(key) ? 1 : 0;
+            }
+            do_not_optimize(found);
+        });
+    }
+    state.set_items_processed(state.iterations() * thread_amount *
+                              lookups_per_thread);
+}
+
+/* Args: thread amount, size. All threads add the same keys. */
+static void concurrent_map_add(BenchmarkState &state)
+{
+    uint32_t thread_amount = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size);
+
+    for (auto _ : state) {
+        ConcurrentMap<uint64_t, uint32_t> map;
+        run_in_threads(thread_amount, [&](uint32_t thread_index) {
+            for (uint32_t i = 0; i < size; i++) {
+                map.add(keys[(i + thread_index * 997) & (size - 1)], i);
+            }
+        });
+        do_not_optimize(map.size());
+    }
+    state.set_items_processed(state.iterations() * thread_amount * size);
+}
+
+static const Vector<Vector<int64_t>> thread_args = cross_product(
+    {{1, 2, 4, 8}, {1 << 10, 1 << 16, 1 << 20}});
+
+BAS_BENCHMARK(concurrent_map_lookup, thread_args);
+BAS_BENCHMARK(mutex_map_lookup, thread_args);
+BAS_BENCHMARK(concurrent_map_add, thread_args);
+
+}  // namespace bas
@@ -0,0 +1,63 @@
+#include <functional>
+#include <string_view>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/hash.h"
+
+namespace bas {
+
+/* Args: string length. */
+static void hash_bytes_string(BenchmarkState &state)
+{
+    Vector<std::string> keys = make_string_keys(1024, (uint32_t)state.arg(0));
+    uint32_t index = 0;
+    for (auto _ : state) {
+        const std::string &key = keys[index];
+        do_not_optimize(hash_bytes(key.data(), key.size()));
+        index = (index + 1) & 1023;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void std_hash_string(BenchmarkState &state)
+{
+    Vector<std::string> keys = make_string_keys(1024, (uint32_t)state.arg(0));
+    uint32_t index = 0;
+    for (auto _ : state) {
+        do_not_optimize(std::hash<std::string_view>{}(keys[index]));
+        index = (index + 1) & 1023;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void default_hash_uint64(BenchmarkState &state)
+{
+    uint64_t value = 0;
+    for (auto _ : state) {
+        do_not_optimize(fold_hash<uint32_t>(DefaultHash<uint64_t>{}(value)));
+        value++;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void mixed_hash_uint64(BenchmarkState &state)
+{
+    uint64_t value = 0;
+    for (auto _ : state) {
+        do_not_optimize(MixedHash<uint64_t>{}(value));
+        value++;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static const Vector<Vector<int64_t>> length_args = {
+    {32}, {64}, {256}, {4096}};
+
+BAS_BENCHMARK(hash_bytes_string, length_args);
+BAS_BENCHMARK(std_hash_string, length_args);
+BAS_BENCHMARK(default_hash_uint64, {});
+BAS_BENCHMARK(mixed_hash_uint64, {});
+
+}  // namespace bas
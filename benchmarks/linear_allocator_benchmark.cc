@@ -0,0 +1,70 @@
+#include <cstdlib>
+
+#include "benchmark.h"
+
+#include "bas/concurrent_linear_allocator.h"
+#include "bas/linear_allocator.h"
+
+namespace bas {
+
+static const uint32_t allocations_per_iteration = 1000;
+
+/* Args: allocation size in bytes. */
+static void linear_allocator_allocate(BenchmarkState &state)
+{
+    size_t size = (size_t)state.arg(0);
+    for (auto _ : state) {
+        LinearAllocator<> allocator;
+        for (uint32_t i = 0; i < allocations_per_iteration; i++) {
+            do_not_optimize(allocator.allocate(size, 8));
+        }
+    }
+    state.set_items_processed(state.iterations() *
+                              allocations_per_iteration);
+}
+
+static void malloc_free(BenchmarkState &state)
+{
+    size_t size = (size_t)state.arg(0);
+    void *pointers[allocations_per_iteration];
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < allocations_per_iteration; i++) {
+            pointers[i] = malloc(size);
+            do_not_optimize(pointers[i]);
+        }
+        for (uint32_t i = 0; i < allocations_per_iteration; i++) {
+            free(pointers[i]);
+        }
+    }
+    state.set_items_processed(state.iterations() *
+                              allocations_per_iteration);
+}
+
+/* Args: allocation size in bytes, threads. Every thread allocates more
+ * often than in the other benchmarks, so that starting the threads does
+ * not dominate the time. */
+static void concurrent_linear_allocator_allocate(BenchmarkState &state)
+{
+    const uint32_t allocations_per_thread = 100 * allocations_per_iteration;
+    size_t size = (size_t)state.arg(0);
+    uint32_t thread_amount = (uint32_t)state.arg(1);
+    for (auto _ : state) {
+        ConcurrentLinearAllocator<> allocator;
+        run_in_threads(thread_amount, [&](uint32_t /*thread_index*/) {
+            for (uint32_t i = 0; i < allocations_per_thread; i++) {
+                do_not_optimize(allocator.allocate(size, 8));
+            }
+        });
+    }
+    state.set_items_processed(state.iterations() * thread_amount *
+                              allocations_per_thread);
+}
+
+static const Vector<Vector<int64_t>> size_args = {{8}, {64}, {1024}};
+
+BAS_BENCHMARK(linear_allocator_allocate, size_args);
+BAS_BENCHMARK(malloc_free, size_args);
+BAS_BENCHMARK(concurrent_linear_allocator_allocate,
+              cross_product({{8, 64, 1024}, {1, 4}}));
+
+}  // namespace bas
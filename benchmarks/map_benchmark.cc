@@ -0,0 +1,300 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/frozen_map.h"
+#include "bas/huge_page_allocator.h"
+#include "bas/map.h"
+#include "bas/mapped_file.h"
+
+namespace bas {
+
+template<typename MapT> static void insert_into(MapT &map, uint64_t key)
+{
+    map.add_new(key, (uint32_t)key);
+}
+
+static void insert_into(std::unordered_map<uint64_t, uint32_t> &map,
+                        uint64_t key)
+{
+    map.insert({key, (uint32_t)key});
+}
+
+template<typename MapT> static bool lookup_in(const MapT &map, uint64_t key)
+{
+    return map.lookup_ptr(key) != nullptr;
+}
+
+static bool lookup_in(const std::unordered_map<uint64_t, uint32_t> &map,
+                      uint64_t key)
+{
+    return map.find(key) != map.end();
+}
+
+/* Args: key distribution, size. */
+template<typename MapT> static void insert_benchmark(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size);
+    state.set_label(key_distribution_name(distribution));
+
+    for (auto _ : state) {
+        MapT map;
+        for (uint64_t key : keys) {
+            insert_into(map, key);
+        }
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * size);
+}
+
+/* Args: key distribution, size, hit percentage. */
+template<typename MapT> static void lookup_benchmark(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, state.arg(2));
+    state.set_label(key_distribution_name(distribution));
+
+    MapT map;
+    for (uint32_t i = 0; i < size; i++) {
+        insert_into(map, keys[i]);
+    }
+
+    uint32_t index = 0;
+    uint32_t mask = size - 1;
+    for (auto _ : state) {
+        do_not_optimize(lookup_in(map, lookups[index]));
+        index = (index + 1) & mask;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+/* Args: key distribution, size. */
+static void map_add_multiple_new(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size);
+    Vector<uint32_t> values;
+    for (uint64_t key : keys) {
+        values.append((uint32_t)key);
+    }
+    state.set_label(key_distribution_name(distribution));
+
+    for (auto _ : state) {
+        Map<uint64_t, uint32_t> map;
+        map.add_multiple_new(keys, values);
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * size);
+}
+
+/* Args: grow threads, size. Most of the time is spent growing. */
+static void map_insert_parallel_grow(BenchmarkState &state)
+{
+    uint32_t grow_threads = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size);
+
+    for (auto _ : state) {
+        Map<uint64_t, uint32_t> map;
+        map.set_grow_threads(grow_threads);
+        for (uint64_t key : keys) {
+            map.add_new(key, (uint32_t)key);
+        }
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * size);
+}
+
+/* Args: incremental grow, size. The label contains the slowest single
+ * insertion, which is dominated by growing unless it is incremental. */
+static void map_insert_max_latency(BenchmarkState &state)
+{
+    using Clock = std::chrono::steady_clock;
+    bool incremental = state.arg(0) != 0;
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size);
+
+    Clock::duration max_duration{0};
+    for (auto _ : state) {
+        Map<uint64_t, uint32_t> map;
+        map.set_incremental_grow(incremental);
+        for (uint64_t key : keys) {
+            Clock::time_point start = Clock::now();
+            map.add_new(key, (uint32_t)key);
+            max_duration = std::max(max_duration, Clock::now() - start);
+        }
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * size);
+    double max_us =
+        std::chrono::duration<double, std::micro>(max_duration).count();
+    state.set_label("max " + std::to_string((uint64_t)max_us) + " us");
+}
+
+using FrozenMapType = FrozenMap<uint64_t, uint32_t>;
+static const char *frozen_map_path = "bas_frozen_map_benchmark.bin";
+
+static void write_frozen_map(const Vector<uint64_t> &keys, uint32_t size)
+{
+    Map<uint64_t, uint32_t> map;
+    for (uint32_t i = 0; i < size; i++) {
+        map.add_new(keys[i], i);
+    }
+    std::ofstream stream(frozen_map_path, std::ios::binary);
+    FrozenMapType::write(stream, map);
+}
+
+/* Args: size. Maps a file that contains a frozen map and does a single
+ * lookup, which is what loading the map costs compared to map_insert. */
+static void map_open_frozen(BenchmarkState &state)
+{
+    uint32_t size = (uint32_t)state.arg(0);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random, size);
+    write_frozen_map(keys, size);
+
+    for (auto _ : state) {
+        MappedFile file(frozen_map_path);
+        if (FrozenMapType::is_valid(file.buffer())) {
+            FrozenMapType frozen(file.buffer());
+            do_not_optimize(frozen.lookup_ptr(keys[0]));
+        }
+    }
+    std::remove(frozen_map_path);
+    state.set_items_processed(state.iterations() * size);
+}
+
+/* Args: key distribution, size, hit percentage. */
+static void map_lookup_frozen(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, state.arg(2));
+    state.set_label(key_distribution_name(distribution));
+    write_frozen_map(keys, size);
+
+    MappedFile file(frozen_map_path);
+    FrozenMapType frozen(file.buffer());
+    uint32_t index = 0;
+    uint32_t mask = size - 1;
+    for (auto _ : state) {
+        do_not_optimize(frozen.lookup_ptr(lookups[index]));
+        index = (index + 1) & mask;
+    }
+    std::remove(frozen_map_path);
+    state.set_items_processed(state.iterations());
+}
+
+static const uint32_t keys_per_batch = 1024;
+
+/* Args: key distribution, size, hit percentage. Every iteration looks up a
+ * batch of keys, either one by one or with lookup_ptr_batch. */
+template<bool UseBatch> static void map_lookup_many(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, state.arg(2));
+    state.set_label(key_distribution_name(distribution));
+
+    Map<uint64_t, uint32_t> map;
+    for (uint32_t i = 0; i < size; i++) {
+        map.add_new(keys[i], i);
+    }
+
+    Vector<const uint32_t *> results(keys_per_batch);
+    uint32_t start = 0;
+    for (auto _ : state) {
+        ArrayRef<uint64_t> batch = lookups.as_ref().slice(start,
+                                                          keys_per_batch);
+        if (UseBatch) {
+            map.lookup_ptr_batch(batch, results);
+        }
+        else {
+            for (uint32_t i = 0; i < keys_per_batch; i++) {
+                results[i] = map.lookup_ptr(batch[i]);
+            }
+        }
+        do_not_optimize(results.begin());
+        start = (start + keys_per_batch) % size;
+    }
+    state.set_items_processed(state.iterations() * keys_per_batch);
+}
+
+static void map_lookup_1024(BenchmarkState &state)
+{
+    map_lookup_many<false>(state);
+}
+
+static void map_lookup_batch_1024(BenchmarkState &state)
+{
+    map_lookup_many<true>(state);
+}
+
+static void map_insert(BenchmarkState &state)
+{
+    insert_benchmark<Map<uint64_t, uint32_t>>(state);
+}
+
+static void std_unordered_map_insert(BenchmarkState &state)
+{
+    insert_benchmark<std::unordered_map<uint64_t, uint32_t>>(state);
+}
+
+static void map_lookup(BenchmarkState &state)
+{
+    lookup_benchmark<Map<uint64_t, uint32_t>>(state);
+}
+
+static void map_lookup_huge_pages(BenchmarkState &state)
+{
+    lookup_benchmark<Map<uint64_t, uint32_t, HugePageAllocator>>(state);
+}
+
+static void map_lookup_mixed_hash(BenchmarkState &state)
+{
+    lookup_benchmark<
+        Map<uint64_t, uint32_t, RawAllocator, MixedHash<uint64_t>>>(state);
+}
+
+static void std_unordered_map_lookup(BenchmarkState &state)
+{
+    lookup_benchmark<std::unordered_map<uint64_t, uint32_t>>(state);
+}
+
+static const Vector<Vector<int64_t>> insert_args = cross_product(
+    {all_key_distributions, table_sizes});
+static const Vector<Vector<int64_t>> lookup_args = cross_product(
+    {all_key_distributions, table_sizes, hit_percentages});
+static const Vector<Vector<int64_t>> batch_args = cross_product(
+    {all_key_distributions, table_sizes, {50}});
+
+BAS_BENCHMARK(map_insert, insert_args);
+BAS_BENCHMARK(std_unordered_map_insert, insert_args);
+BAS_BENCHMARK(map_add_multiple_new, insert_args);
+BAS_BENCHMARK(map_insert_parallel_grow,
+              cross_product({{1, 2, 4, 8}, {1 << 20, 1 << 22}}));
+BAS_BENCHMARK(map_insert_max_latency,
+              cross_product({{0, 1}, {1 << 20, 1 << 22}}));
+BAS_BENCHMARK(map_lookup, lookup_args);
+BAS_BENCHMARK(map_lookup_huge_pages,
+              cross_product({{(int64_t)KeyDistribution::Random},
+                             {1 << 18, 1 << 22, 1 << 24},
+                             {100}}));
+BAS_BENCHMARK(map_lookup_mixed_hash, lookup_args);
+BAS_BENCHMARK(map_lookup_frozen, lookup_args);
+BAS_BENCHMARK(map_open_frozen, {{1 << 16}, {1 << 20}, {1 << 22}});
+BAS_BENCHMARK(std_unordered_map_lookup, lookup_args);
+BAS_BENCHMARK(map_lookup_1024, batch_args);
+BAS_BENCHMARK(map_lookup_batch_1024, batch_args);
+
+}  // namespace bas
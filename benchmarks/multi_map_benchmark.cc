@@ -0,0 +1,113 @@
+#include <unordered_map>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/multi_map.h"
+
+namespace bas {
+
+/* Args: key amount, values per key. */
+static void multi_map_add(BenchmarkState &state)
+{
+    uint32_t key_amount = (uint32_t)state.arg(0);
+    uint32_t values_per_key = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          key_amount);
+
+    for (auto _ : state) {
+        MultiMap<uint64_t, uint32_t> map;
+        for (uint32_t value = 0; value < values_per_key; value++) {
+            for (uint64_t key : keys) {
+                map.add(key, value);
+            }
+        }
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * key_amount *
+                              values_per_key);
+}
+
+static void std_unordered_multimap_add(BenchmarkState &state)
+{
+    uint32_t key_amount = (uint32_t)state.arg(0);
+    uint32_t values_per_key = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          key_amount);
+
+    for (auto _ : state) {
+        std::unordered_multimap<uint64_t, uint32_t> map;
+        for (uint32_t value = 0; value < values_per_key; value++) {
+            for (uint64_t key : keys) {
+                map.insert({key, value});
+            }
+        }
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * key_amount *
+                              values_per_key);
+}
+
+/* Args: key amount, values per key. Iterates over all values of a key. */
+static void multi_map_lookup(BenchmarkState &state)
+{
+    uint32_t key_amount = (uint32_t)state.arg(0);
+    uint32_t values_per_key = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          key_amount);
+    MultiMap<uint64_t, uint32_t> map;
+    for (uint32_t value = 0; value < values_per_key; value++) {
+        for (uint64_t key : keys) {
+            map.add(key, value);
+        }
+    }
+
+    uint32_t index = 0;
+    uint32_t mask = key_amount - 1;
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (uint32_t value : map.lookup(keys[index])) {
+            sum += value;
+        }
+        do_not_optimize(sum);
+        index = (index + 1) & mask;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void std_unordered_multimap_lookup(BenchmarkState &state)
+{
+    uint32_t key_amount = (uint32_t)state.arg(0);
+    uint32_t values_per_key = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          key_amount);
+    std::unordered_multimap<uint64_t, uint32_t> map;
+    for (uint32_t value = 0; value < values_per_key; value++) {
+        for (uint64_t key : keys) {
+            map.insert({key, value});
+        }
+    }
+
+    uint32_t index = 0;
+    uint32_t mask = key_amount - 1;
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        auto range = map.equal_range(keys[index]);
+        for (auto it = range.first; it != range.second; ++it) {
+            sum += it->second;
+        }
+        do_not_optimize(sum);
+        index = (index + 1) & mask;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static const Vector<Vector<int64_t>> multi_map_args = cross_product(
+    {{1 << 10, 1 << 16}, {1, 8}});
+
+BAS_BENCHMARK(multi_map_add, multi_map_args);
+BAS_BENCHMARK(std_unordered_multimap_add, multi_map_args);
+BAS_BENCHMARK(multi_map_lookup, multi_map_args);
+BAS_BENCHMARK(std_unordered_multimap_lookup, multi_map_args);
+
+}  // namespace bas
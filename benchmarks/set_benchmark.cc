@@ -0,0 +1,142 @@
+#include <unordered_set>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/set.h"
+#include "bas/vector_set.h"
+
+namespace bas {
+
+template<typename SetT> static bool contains_in(const SetT &set, uint64_t key)
+{
+    return set.contains(key);
+}
+
+static bool contains_in(const std::unordered_set<uint64_t> &set, uint64_t key)
+{
+    return set.find(key) != set.end();
+}
+
+template<typename SetT> static void insert_into(SetT &set, uint64_t key)
+{
+    set.add_new(key);
+}
+
+static void insert_into(std::unordered_set<uint64_t> &set, uint64_t key)
+{
+    set.insert(key);
+}
+
+/* Args: key distribution, size. */
+template<typename SetT> static void insert_benchmark(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size);
+    state.set_label(key_distribution_name(distribution));
+
+    for (auto _ : state) {
+        SetT set;
+        for (uint64_t key : keys) {
+            insert_into(set, key);
+        }
+        do_not_optimize(set);
+    }
+    state.set_items_processed(state.iterations() * size);
+}
+
+/* Args: key distribution, size, hit percentage. */
+template<typename SetT> static void contains_benchmark(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, state.arg(2));
+    state.set_label(key_distribution_name(distribution));
+
+    SetT set;
+    for (uint32_t i = 0; i < size; i++) {
+        insert_into(set, keys[i]);
+    }
+
+    uint32_t index = 0;
+    uint32_t mask = size - 1;
+    for (auto _ : state) {
+        do_not_optimize(contains_in(set, lookups[index]));
+        index = (index + 1) & mask;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static const uint32_t values_per_batch = 1024;
+
+/* Args: key distribution, size, hit percentage. */
+static void set_contains_batch_1024(BenchmarkState &state)
+{
+    KeyDistribution distribution = (KeyDistribution)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(distribution, size * 2);
+    Vector<uint64_t> lookups = make_lookup_keys(keys, state.arg(2));
+    state.set_label(key_distribution_name(distribution));
+
+    Set<uint64_t> set;
+    for (uint32_t i = 0; i < size; i++) {
+        set.add_new(keys[i]);
+    }
+
+    Vector<bool> results(values_per_batch);
+    uint32_t start = 0;
+    for (auto _ : state) {
+        set.contains_batch(
+            lookups.as_ref().slice(start, values_per_batch), results);
+        do_not_optimize(results.begin());
+        start = (start + values_per_batch) % size;
+    }
+    state.set_items_processed(state.iterations() * values_per_batch);
+}
+
+static void set_insert(BenchmarkState &state)
+{
+    insert_benchmark<Set<uint64_t>>(state);
+}
+
+static void vector_set_insert(BenchmarkState &state)
+{
+    insert_benchmark<VectorSet<uint64_t>>(state);
+}
+
+static void std_unordered_set_insert(BenchmarkState &state)
+{
+    insert_benchmark<std::unordered_set<uint64_t>>(state);
+}
+
+static void set_contains(BenchmarkState &state)
+{
+    contains_benchmark<Set<uint64_t>>(state);
+}
+
+static void vector_set_contains(BenchmarkState &state)
+{
+    contains_benchmark<VectorSet<uint64_t>>(state);
+}
+
+static void std_unordered_set_contains(BenchmarkState &state)
+{
+    contains_benchmark<std::unordered_set<uint64_t>>(state);
+}
+
+static const Vector<Vector<int64_t>> insert_args = cross_product(
+    {all_key_distributions, table_sizes});
+static const Vector<Vector<int64_t>> contains_args = cross_product(
+    {all_key_distributions, table_sizes, hit_percentages});
+
+BAS_BENCHMARK(set_insert, insert_args);
+BAS_BENCHMARK(vector_set_insert, insert_args);
+BAS_BENCHMARK(std_unordered_set_insert, insert_args);
+BAS_BENCHMARK(set_contains, contains_args);
+BAS_BENCHMARK(vector_set_contains, contains_args);
+BAS_BENCHMARK(std_unordered_set_contains, contains_args);
+BAS_BENCHMARK(set_contains_batch_1024, contains_args);
+
+}  // namespace bas
@@ -0,0 +1,59 @@
+#include <mutex>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/map.h"
+#include "bas/sharded_map.h"
+
+namespace bas {
+
+/* Args: thread amount, keys per thread. Every thread adds different keys. */
+static void sharded_map_add(BenchmarkState &state)
+{
+    uint32_t thread_amount = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          size * thread_amount);
+
+    for (auto _ : state) {
+        ShardedMap<uint64_t, uint32_t> map;
+        run_in_threads(thread_amount, [&](uint32_t thread_index) {
+            for (uint32_t i = 0; i < size; i++) {
+                map.add_new(keys[thread_index * size + i], i);
+            }
+        });
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * thread_amount * size);
+}
+
+/* Args: thread amount, keys per thread. The baseline with a single lock. */
+static void mutex_map_add(BenchmarkState &state)
+{
+    uint32_t thread_amount = (uint32_t)state.arg(0);
+    uint32_t size = (uint32_t)state.arg(1);
+    Vector<uint64_t> keys = make_int_keys(KeyDistribution::Random,
+                                          size * thread_amount);
+
+    for (auto _ : state) {
+        Map<uint64_t, uint32_t> map;
+        std::mutex mutex;
+        run_in_threads(thread_amount, [&](uint32_t thread_index) {
+            for (uint32_t i = 0; i < size; i++) {
+                std::lock_guard<std::mutex> lock(mutex);
+                map.add_new(keys[thread_index * size + i], i);
+            }
+        });
+        do_not_optimize(map);
+    }
+    state.set_items_processed(state.iterations() * thread_amount * size);
+}
+
+static const Vector<Vector<int64_t>> thread_args = cross_product(
+    {{1, 2, 4, 8}, {1 << 10, 1 << 16, 1 << 20}});
+
+BAS_BENCHMARK(sharded_map_add, thread_args);
+BAS_BENCHMARK(mutex_map_add, thread_args);
+
+}  // namespace bas
@@ -0,0 +1,93 @@
+#include <unordered_map>
+
+#include "benchmark.h"
+#include "benchmark_keys.h"
+
+#include "bas/map.h"
+#include "bas/string_map.h"
+
+namespace bas {
+
+static void insert_into(StringMap<uint32_t> &map,
+                        const std::string &key,
+                        uint32_t value)
+{
+    map.add_new(key, value);
+}
+
+static void insert_into(Map<std::string, uint32_t> &map,
+                        const std::string &key,
+                        uint32_t value)
+{
+    map.add_new(key, value);
+}
+
+static void insert_into(std::unordered_map<std::string, uint32_t> &map,
+                        const std::string &key,
+                        uint32_t value)
+{
+    map.insert({key, value});
+}
+
+static bool lookup_in(const StringMap<uint32_t> &map, const std::string &key)
+{
+    return map.lookup_ptr(key) != nullptr;
+}
+
+static bool lookup_in(const Map<std::string, uint32_t> &map,
+                      const std::string &key)
+{
+    return map.lookup_ptr(key) != nullptr;
+}
+
+static bool lookup_in(const std::unordered_map<std::string, uint32_t> &map,
+                      const std::string &key)
+{
+    return map.find(key) != map.end();
+}
+
+/* Args: size, key length, hit percentage. */
+template<typename MapT> static void lookup_benchmark(BenchmarkState &state)
+{
+    uint32_t size = (uint32_t)state.arg(0);
+    uint32_t length = (uint32_t)state.arg(1);
+    Vector<std::string> keys = make_string_keys(size * 2, length);
+    Vector<std::string> lookups = make_lookup_keys(keys, state.arg(2));
+
+    MapT map;
+    for (uint32_t i = 0; i < size; i++) {
+        insert_into(map, keys[i], i);
+    }
+
+    uint32_t index = 0;
+    uint32_t mask = size - 1;
+    for (auto _ : state) {
+        do_not_optimize(lookup_in(map, lookups[index]));
+        index = (index + 1) & mask;
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void string_map_lookup(BenchmarkState &state)
+{
+    lookup_benchmark<StringMap<uint32_t>>(state);
+}
+
+static void map_std_string_lookup(BenchmarkState &state)
+{
+    lookup_benchmark<Map<std::string, uint32_t>>(state);
+}
+
+static void std_unordered_map_std_string_lookup(BenchmarkState &state)
+{
+    lookup_benchmark<std::unordered_map<std::string, uint32_t>>(state);
+}
+
+static const Vector<Vector<int64_t>> lookup_args = cross_product(
+    {{1 << 10, 1 << 14, 1 << 18}, {32, 128}, hit_percentages});
+
+BAS_BENCHMARK(string_map_lookup, lookup_args);
+BAS_BENCHMARK(map_std_string_lookup, lookup_args);
+BAS_BENCHMARK(std_unordered_map_std_string_lookup, lookup_args);
+
+}  // namespace bas
@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <string>
+
+#include "benchmark.h"
+
+#include "bas/string_ref.h"
+
+namespace bas {
+
+/* Lines of a config file with indentation and trailing spaces. */
+static std::string make_config_text(size_t line_amount)
+{
+    std::string text;
+    for (size_t i = 0; i < line_amount; i++) {
+        text += "    Setting_" + std::to_string(i) +
+                " = some value with several words, " + std::to_string(i * 7) +
+                "  \n";
+    }
+    return text;
+}
+
+/* Args: number of chars. */
+static void string_ref_equal(BenchmarkState &state)
+{
+    std::string a((size_t)state.arg(0), 'a');
+    std::string b = a;
+    for (auto _ : state) {
+        do_not_optimize(StringRef(a) == StringRef(b));
+    }
+    state.set_items_processed(state.iterations() * a.size());
+}
+
+static void string_ref_startswith_lower_ascii(BenchmarkState &state)
+{
+    std::string str((size_t)state.arg(0), 'A');
+    std::string prefix(str.size(), 'a');
+    for (auto _ : state) {
+        do_not_optimize(StringRef(str).startswith_lower_ascii(prefix));
+    }
+    state.set_items_processed(state.iterations() * str.size());
+}
+
+/* Args: number of lines. Every line is split at the '=' and both sides are
+ * stripped. */
+static void string_ref_split_lines_strip(BenchmarkState &state)
+{
+    std::string text = make_config_text((size_t)state.arg(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (StringRef line : StringRef(text).split('\n')) {
+            for (StringRef part : line.split('=')) {
+                total += part.strip().size();
+            }
+        }
+        do_not_optimize(total);
+    }
+    state.set_items_processed(state.iterations() * text.size());
+}
+
+static void string_ref_tokenize(BenchmarkState &state)
+{
+    std::string text = make_config_text((size_t)state.arg(0));
+    for (auto _ : state) {
+        size_t count = 0;
+        for (StringRef token : StringRef(text).tokenize()) {
+            count += token.size();
+        }
+        do_not_optimize(count);
+    }
+    state.set_items_processed(state.iterations() * text.size());
+}
+
+/* A CSV row with the given amount of numbers. */
+static std::string make_number_row(size_t amount, bool use_floats)
+{
+    std::string row;
+    for (size_t i = 0; i < amount; i++) {
+        row += use_floats ? std::to_string((double)i * 1.37 - 1000.0) :
+                            std::to_string((int)(i * 7919) - 500000);
+        row += ',';
+    }
+    row.pop_back();
+    return row;
+}
+
+/* Args: number of values in the row. */
+static void string_ref_parse_split_int(BenchmarkState &state)
+{
+    std::string row = make_number_row((size_t)state.arg(0), false);
+    Vector<int> values;
+    for (auto _ : state) {
+        values.clear();
+        StringRef(row).parse_split(',', values);
+        do_not_optimize(values.begin());
+    }
+    state.set_items_processed(state.iterations() * state.arg(0));
+}
+
+static void string_ref_parse_split_double(BenchmarkState &state)
+{
+    std::string row = make_number_row((size_t)state.arg(0), true);
+    Vector<double> values;
+    for (auto _ : state) {
+        values.clear();
+        StringRef(row).parse_split(',', values);
+        do_not_optimize(values.begin());
+    }
+    state.set_items_processed(state.iterations() * state.arg(0));
+}
+
+/* Parse every field like to_int and to_float did before: copy it to
+ * null-terminate it and call the C library. */
+static void strtol_split(BenchmarkState &state)
+{
+    std::string row = make_number_row((size_t)state.arg(0), false);
+    Vector<int> values;
+    for (auto _ : state) {
+        values.clear();
+        for (StringRef field : StringRef(row).split(',')) {
+            std::string copy = field;
+            values.append((int)std::strtol(copy.c_str(), nullptr, 10));
+        }
+        do_not_optimize(values.begin());
+    }
+    state.set_items_processed(state.iterations() * state.arg(0));
+}
+
+static void strtod_split(BenchmarkState &state)
+{
+    std::string row = make_number_row((size_t)state.arg(0), true);
+    Vector<double> values;
+    for (auto _ : state) {
+        values.clear();
+        for (StringRef field : StringRef(row).split(',')) {
+            std::string copy = field;
+            values.append(std::strtod(copy.c_str(), nullptr));
+        }
+        do_not_optimize(values.begin());
+    }
+    state.set_items_processed(state.iterations() * state.arg(0));
+}
+
+BAS_BENCHMARK(string_ref_equal, {{16}, {256}, {4096}});
+BAS_BENCHMARK(string_ref_startswith_lower_ascii, {{16}, {256}, {4096}});
+BAS_BENCHMARK(string_ref_split_lines_strip, {{1000}, {100000}});
+BAS_BENCHMARK(string_ref_tokenize, {{1000}, {100000}});
+BAS_BENCHMARK(string_ref_parse_split_int, {{1000}});
+BAS_BENCHMARK(strtol_split, {{1000}});
+BAS_BENCHMARK(string_ref_parse_split_double, {{1000}});
+BAS_BENCHMARK(strtod_split, {{1000}});
+
+}  // namespace bas
@@ -0,0 +1,64 @@
+#include <cmath>
+#include <thread>
+
+#include "benchmark.h"
+
+#include "bas/parallel_for.h"
+
+namespace bas {
+
+static const uint32_t elements_per_iteration = 1 << 16;
+
+/* The cost of an element grows with its index, so that splitting the range
+ * into equally sized parts gives a poor load balance. */
+static float uneven_work(size_t index)
+{
+    float value = (float)index;
+    for (size_t i = 0; i < index / 1024; i++) {
+        value = std::sqrt(value + 1.0f);
+    }
+    return value;
+}
+
+/* Args: grain size. */
+static void parallel_for_uneven(BenchmarkState &state)
+{
+    size_t grain_size = (size_t)state.arg(0);
+    Vector<float> results(elements_per_iteration);
+    for (auto _ : state) {
+        parallel_for(IndexRange(elements_per_iteration),
+                     grain_size,
+                     [&](IndexRange range) {
+                         for (size_t i : range) {
+                             results[i] = uneven_work(i);
+                         }
+                     });
+        do_not_optimize(results);
+    }
+    state.set_items_processed(state.iterations() * elements_per_iteration);
+}
+
+/* One equally sized part per hardware thread, for comparison. */
+static void static_split_uneven(BenchmarkState &state)
+{
+    uint32_t thread_amount = std::max(1u, std::thread::hardware_concurrency());
+    Vector<float> results(elements_per_iteration);
+    for (auto _ : state) {
+        run_in_threads(thread_amount, [&](uint32_t thread) {
+            size_t begin = (size_t)elements_per_iteration * thread /
+                           thread_amount;
+            size_t end = (size_t)elements_per_iteration * (thread + 1) /
+                         thread_amount;
+            for (size_t i = begin; i < end; i++) {
+                results[i] = uneven_work(i);
+            }
+        });
+        do_not_optimize(results);
+    }
+    state.set_items_processed(state.iterations() * elements_per_iteration);
+}
+
+BAS_BENCHMARK(parallel_for_uneven, {{64}, {1024}, {16384}});
+BAS_BENCHMARK(static_split_uneven, {});
+
+}  // namespace bas
@@ -0,0 +1,136 @@
+#include <memory>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "bas/huge_page_allocator.h"
+#include "bas/pool_allocator.h"
+#include "bas/vector.h"
+
+namespace bas {
+
+/* Args: number of appended elements. */
+static void vector_append(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        Vector<uint64_t> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.append(i);
+        }
+        do_not_optimize(vector.begin());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static void vector_append_reserved(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        Vector<uint64_t> vector;
+        vector.reserve(amount);
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.append_unchecked(i);
+        }
+        do_not_optimize(vector.begin());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+/* Large vectors are grown with mremap instead of copying. */
+static void vector_append_huge_pages(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        Vector<uint64_t, 4, HugePageAllocator> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.append(i);
+        }
+        do_not_optimize(vector.begin());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static void std_vector_push_back(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        std::vector<uint64_t> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.push_back(i);
+        }
+        do_not_optimize(vector.data());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+/* Args: number of appended elements. The pointers are null, so that most
+ * of the time is spent relocating them when the vector grows. */
+static void vector_append_unique_ptr(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        Vector<std::unique_ptr<int>> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.append(std::unique_ptr<int>());
+        }
+        do_not_optimize(vector.begin());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+static void std_vector_push_back_unique_ptr(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<int>> vector;
+        for (uint32_t i = 0; i < amount; i++) {
+            vector.push_back(std::unique_ptr<int>());
+        }
+        do_not_optimize(vector.data());
+    }
+    state.set_items_processed(state.iterations() * amount);
+}
+
+/* Args: number of appended elements. Many short-lived vectors that spill
+ * out of their inline buffer. */
+template<typename Allocator>
+static void small_vectors_append(BenchmarkState &state)
+{
+    uint32_t amount = (uint32_t)state.arg(0);
+    const uint32_t vectors_per_iteration = 1000;
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < vectors_per_iteration; i++) {
+            Vector<uint64_t, 4, Allocator> vector;
+            for (uint32_t j = 0; j < amount; j++) {
+                vector.append(j);
+            }
+            do_not_optimize(vector.begin());
+        }
+    }
+    state.set_items_processed(state.iterations() * vectors_per_iteration);
+}
+
+static void small_vectors_raw_allocator(BenchmarkState &state)
+{
+    small_vectors_append<RawAllocator>(state);
+}
+
+static void small_vectors_pool_allocator(BenchmarkState &state)
+{
+    small_vectors_append<PoolAllocator>(state);
+}
+
+static const Vector<Vector<int64_t>> append_args = {
+    {4}, {1 << 10}, {1 << 16}, {1 << 22}};
+
+BAS_BENCHMARK(vector_append, append_args);
+BAS_BENCHMARK(vector_append_reserved, append_args);
+BAS_BENCHMARK(vector_append_huge_pages, append_args);
+BAS_BENCHMARK(std_vector_push_back, append_args);
+BAS_BENCHMARK(vector_append_unique_ptr, append_args);
+BAS_BENCHMARK(std_vector_push_back_unique_ptr, append_args);
+BAS_BENCHMARK(small_vectors_raw_allocator, {{8}, {32}, {100}});
+BAS_BENCHMARK(small_vectors_pool_allocator, {{8}, {32}, {100}});
+
+}  // namespace bas
@@ -7,7 +7,19 @@ namespace bas {
 void *aligned_malloc(size_t size, size_t alignment);
 void aligned_free(void *pointer);
 
+/**
+ * Change the size of a buffer from aligned_malloc. The content is kept up to
+ * the smaller of both sizes. The alignment has to be the same as when the
+ * buffer was allocated. The buffer can often grow in place, and large
+ * buffers are usually remapped by the system instead of copied.
+ * Returns null when the allocation fails.
+ */
+void *aligned_realloc(void *pointer, size_t new_size, size_t alignment);
+
 void *aligned_malloc_fallback(size_t size, size_t alignment);
+void *aligned_realloc_fallback(void *pointer,
+                               size_t new_size,
+                               size_t alignment);
 void aligned_free_fallback(void *pointer);
 
 }  // namespace bas
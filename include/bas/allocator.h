@@ -1,6 +1,26 @@
 #pragma once
 
+/**
+ * An allocator is a class with the methods
+ *
+ *   void *allocate(size_t size, size_t alignment);
+ *   void free(void *pointer);
+ *
+ * that can be default constructed. Containers get it as template parameter
+ * and store their own instance.
+ *
+ * Allocators can optionally implement
+ *
+ *   void *reallocate(void *pointer, size_t new_size, size_t alignment);
+ *
+ * It returns a buffer of the new size that starts with the bytes of the old
+ * buffer, which is freed. It should avoid copying the bytes when possible.
+ * Containers use it for elements that may be moved with memcpy.
+ */
+
 #include <cstdlib>
+#include <type_traits>
+#include <utility>
 
 #include "aligned_allocation.h"
 
@@ -17,6 +37,22 @@ class RawAllocator {
     {
         aligned_free(pointer);
     }
+
+    void *reallocate(void *pointer, size_t new_size, size_t alignment) const
+    {
+        return aligned_realloc(pointer, new_size, alignment);
+    }
+};
+
+template<typename Allocator, typename = void>
+struct allocator_has_reallocate : std::false_type {
+};
+
+template<typename Allocator>
+struct allocator_has_reallocate<
+    Allocator,
+    decltype((void)std::declval<Allocator &>().reallocate(
+        std::declval<void *>(), size_t(), size_t()))> : std::true_type {
 };
 
 }  // namespace bas
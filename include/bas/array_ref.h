@@ -7,6 +7,7 @@
 
 #include "index_range.h"
 #include "memory_utils.h"
+#include "simd_search.h"
 
 namespace bas {
 
@@ -161,12 +162,7 @@ template<typename T> class ArrayRef {
      */
     bool contains(const T &value) const
     {
-        for (const T &element : *this) {
-            if (element == value) {
-                return true;
-            }
-        }
-        return false;
+        return find_first_equal(m_start, m_size, value) >= 0;
     }
 
     /**
@@ -184,13 +180,25 @@ template<typename T> class ArrayRef {
      */
     size_t count(const T &value) const
     {
-        size_t counter = 0;
-        for (const T &element : *this) {
-            if (element == value) {
-                counter++;
-            }
-        }
-        return counter;
+        return count_equal(m_start, m_size, value);
+    }
+
+    /**
+     * Return the smallest element.
+     * Asserts that the array is not empty.
+     */
+    T min() const
+    {
+        return min_value(m_start, m_size);
+    }
+
+    /**
+     * Return the largest element.
+     * Asserts that the array is not empty.
+     */
+    T max() const
+    {
+        return max_value(m_start, m_size);
     }
 
     /**
@@ -271,12 +279,7 @@ template<typename T> class ArrayRef {
 
     ssize_t first_index_try(const T &search_value) const
     {
-        for (size_t i = 0; i < m_size; i++) {
-            if (m_start[i] == search_value) {
-                return i;
-            }
-        }
-        return -1;
+        return find_first_equal(m_start, m_size, search_value);
     }
 
     template<typename PredicateT> bool any(const PredicateT predicate)
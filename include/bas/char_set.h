@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * A set of chars that is tested with a lookup in a 256 bit table, one bit
+ * per byte value. This is used to strip and tokenize strings.
+ *
+ * The first few chars are also kept in a list. Search kernels compare a
+ * whole vector register with each of them, which is faster than a table
+ * lookup per char as long as the set is small.
+ */
+
+#include <initializer_list>
+
+#include "utildefines.h"
+
+namespace bas {
+
+class CharSet {
+  public:
+    static constexpr uint32_t max_listed_chars = 8;
+
+  private:
+    uint64_t m_table[4] = {0, 0, 0, 0};
+    char m_listed_chars[max_listed_chars] = {};
+    uint32_t m_size = 0;
+
+  public:
+    CharSet() = default;
+
+    CharSet(std::initializer_list<char> chars)
+    {
+        for (char c : chars) {
+            this->add(c);
+        }
+    }
+
+    CharSet(const char *chars, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            this->add(chars[i]);
+        }
+    }
+
+    /**
+     * Space, tab, newline and carriage return.
+     */
+    static const CharSet &whitespace()
+    {
+        static const CharSet set = {' ', '\t', '\n', '\r'};
+        return set;
+    }
+
+    void add(char c)
+    {
+        if (this->contains(c)) {
+            return;
+        }
+        uint8_t byte = (uint8_t)c;
+        m_table[byte >> 6] |= (uint64_t)1 << (byte & 63);
+        if (m_size < max_listed_chars) {
+            m_listed_chars[m_size] = c;
+        }
+        m_size++;
+    }
+
+    bool contains(char c) const
+    {
+        uint8_t byte = (uint8_t)c;
+        return (m_table[byte >> 6] >> (byte & 63)) & 1;
+    }
+
+    /**
+     * Number of distinct chars in the set.
+     */
+    uint32_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * True when all chars of the set are in the list.
+     */
+    bool is_listed() const
+    {
+        return m_size <= max_listed_chars;
+    }
+
+    const char *listed_chars() const
+    {
+        return m_listed_chars;
+    }
+};
+
+}  // namespace bas
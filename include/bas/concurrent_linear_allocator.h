@@ -0,0 +1,174 @@
+#pragma once
+
+/**
+ * A concurrent linear allocator is a LinearAllocator that can be used by
+ * many threads at the same time. All memory is freed together when the
+ * allocator is destructed.
+ *
+ * Every thread bumps a pointer in its own chunk, so small allocations do
+ * not need any synchronization besides finding the chunk of the thread.
+ * Chunks are handed out from large shared blocks with an atomic add. Only
+ * when a block is full, a new one is allocated under a lock. Allocations
+ * that are too large for a chunk take the atomic path directly.
+ *
+ * When a thread allocates very often, an EnumerableThreadSpecific of
+ * LinearAllocators avoids looking up the chunk of the thread every time.
+ */
+
+#include <atomic>
+#include <mutex>
+
+#include "enumerable_thread_specific.h"
+#include "string_ref.h"
+#include "vector.h"
+
+namespace bas {
+
+template<typename Allocator = RawAllocator>
+class ConcurrentLinearAllocator : NonCopyable, NonMovable {
+  private:
+    static constexpr size_t chunk_size = 16 * 1024;
+    /* Larger allocations are not done in the chunk of the thread, so that
+     * not too much of the chunk stays unused. */
+    static constexpr size_t max_size_in_chunk = chunk_size / 4;
+    static constexpr size_t min_block_size = 256 * 1024;
+    static constexpr size_t max_block_size = 64 * 1024 * 1024;
+
+    /* The header of a block is stored at the beginning of its buffer. */
+    struct Block {
+        uintptr_t begin;
+        size_t size;
+        std::atomic<size_t> used{0};
+    };
+
+    struct ThreadChunk {
+        uintptr_t begin = 0;
+        uintptr_t end = 0;
+    };
+
+    Allocator m_allocator;
+    EnumerableThreadSpecific<ThreadChunk, Allocator> m_thread_chunks;
+    std::atomic<Block *> m_current_block{nullptr};
+
+    std::mutex m_blocks_mutex;
+    Vector<void *> m_owned_buffers;
+    size_t m_next_block_size = min_block_size;
+
+  public:
+    ConcurrentLinearAllocator() = default;
+
+    ~ConcurrentLinearAllocator()
+    {
+        for (void *buffer : m_owned_buffers) {
+            m_allocator.free(buffer);
+        }
+    }
+
+    template<typename T> T *allocate()
+    {
+        return (T *)this->allocate(sizeof(T), alignof(T));
+    }
+
+    template<typename T> MutableArrayRef<T> allocate_array(size_t length)
+    {
+        return MutableArrayRef<T>(
+            (T *)this->allocate(sizeof(T) * length, alignof(T)), length);
+    }
+
+    void *allocate(size_t size, size_t alignment = 4)
+    {
+        assert(alignment >= 1);
+        assert(is_power_of_2(alignment));
+
+        if (size + alignment > max_size_in_chunk) {
+            return this->allocate_shared(size, alignment);
+        }
+
+        ThreadChunk &chunk = m_thread_chunks.local();
+        uintptr_t alignment_mask = alignment - 1;
+        uintptr_t begin = (chunk.begin + alignment_mask) & ~alignment_mask;
+        uintptr_t end = begin + size;
+        if (end > chunk.end) {
+            chunk.begin = (uintptr_t)this->allocate_shared(chunk_size, 64);
+            chunk.end = chunk.begin + chunk_size;
+            begin = (chunk.begin + alignment_mask) & ~alignment_mask;
+            end = begin + size;
+        }
+        chunk.begin = end;
+        return (void *)begin;
+    }
+
+    StringRefNull copy_string(StringRef str)
+    {
+        size_t alloc_size = str.size() + 1;
+        char *buffer = (char *)this->allocate(alloc_size, 1);
+        str.copy(buffer, alloc_size);
+        return StringRefNull((const char *)buffer);
+    }
+
+    template<typename T, typename... Args> T *construct(Args &&... args)
+    {
+        void *buffer = this->allocate(sizeof(T), alignof(T));
+        return new (buffer) T(std::forward<Args>(args)...);
+    }
+
+  private:
+    /**
+     * Allocate directly from the current block. Many threads can do this at
+     * the same time, because the used part of the block is increased
+     * atomically.
+     */
+    void *allocate_shared(size_t size, size_t alignment)
+    {
+        size_t padded_size = size + alignment - 1;
+        uintptr_t alignment_mask = alignment - 1;
+        if (padded_size > max_block_size / 4) {
+            uintptr_t buffer = (uintptr_t)this->allocate_buffer(padded_size);
+            return (void *)((buffer + alignment_mask) & ~alignment_mask);
+        }
+        while (true) {
+            Block *block = m_current_block.load(std::memory_order_acquire);
+            if (block != nullptr) {
+                size_t offset = block->used.fetch_add(
+                    padded_size, std::memory_order_relaxed);
+                if (offset + padded_size <= block->size) {
+                    uintptr_t begin = block->begin + offset;
+                    return (void *)((begin + alignment_mask) &
+                                    ~alignment_mask);
+                }
+            }
+            this->add_block(block, padded_size);
+        }
+    }
+
+    /**
+     * Replace the full block with a new one, unless another thread did that
+     * already.
+     */
+    BAS_NOINLINE void add_block(Block *full_block, size_t min_size)
+    {
+        std::lock_guard<std::mutex> lock(m_blocks_mutex);
+        if (m_current_block.load(std::memory_order_relaxed) != full_block) {
+            return;
+        }
+        size_t size = std::max(m_next_block_size, min_size);
+        m_next_block_size = std::min(size * 2, max_block_size);
+
+        void *buffer = m_allocator.allocate(sizeof(Block) + size, 64);
+        m_owned_buffers.append(buffer);
+        Block *block = new (buffer) Block();
+        block->begin = (uintptr_t)buffer + sizeof(Block);
+        block->size = size;
+        m_current_block.store(block, std::memory_order_release);
+    }
+
+    void *allocate_buffer(size_t size)
+    {
+        void *buffer = m_allocator.allocate(size, 64);
+        std::lock_guard<std::mutex> lock(m_blocks_mutex);
+        m_owned_buffers.append(buffer);
+        return buffer;
+    }
+};
+
+}  // namespace bas
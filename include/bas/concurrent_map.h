@@ -0,0 +1,451 @@
+#pragma once
+
+/**
+ * A ConcurrentMap is a hash map that can be used by many threads at the same
+ * time without external locking. It is meant for shared tables that are read
+ * much more often than they are written to, like symbol or interning tables.
+ *
+ * - Lookups are lock-free. They do not write to shared memory, so their
+ *   throughput scales with the number of cores.
+ * - Insertions claim a slot with a compare-and-swap. No locks are used
+ *   unless the table has to grow.
+ * - When the table is full, the inserting thread allocates a larger table.
+ *   All threads that try to insert in the meantime help moving the entries
+ *   to the new table, instead of waiting for a single thread to do it.
+ *
+ * Keys and values are stored in separately allocated entries that never
+ * move, so references to values stay valid until the map is destructed.
+ * Entries cannot be removed and values cannot be changed after they have
+ * been added. Old tables are kept alive until the map is destructed, because
+ * lookups might still read from them. Together they are smaller than the
+ * current table.
+ *
+ * The allocator has to be thread-safe.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "hash.h"
+#include "open_addressing.h"
+
+namespace bas {
+
+// clang-format off
+
+#define ITER_SLOTS_BEGIN(HASH, ARRAY, OPTIONAL_CONST, R_SLOT) \
+  SizeT hash_copy = HASH; \
+  SizeT perturb = hash_copy; \
+  while (true) { \
+    for (SizeT i = 0; i < 4; i++) {\
+      SizeT slot_index = (hash_copy + i) & ARRAY.slot_mask(); \
+      OPTIONAL_CONST Slot &R_SLOT = ARRAY.item(slot_index);
+
+#define ITER_SLOTS_END \
+    } \
+    perturb >>= 5; \
+    hash_copy = hash_copy * 5 + 1 + perturb; \
+  } ((void)0)
+
+// clang-format on
+
+template<typename KeyT,
+         typename ValueT,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<KeyT>,
+         typename SizeT = uint32_t>
+class ConcurrentMap {
+  private:
+    /* Number of slots that are moved to a new table at once when growing. */
+    static constexpr SizeT slots_per_chunk = 1024;
+    static constexpr size_t cache_line_size = 64;
+
+    struct Entry {
+        SizeT hash;
+        KeyT key;
+        ValueT value;
+    };
+
+    class Slot {
+      private:
+        std::atomic<Entry *> m_entry{nullptr};
+
+      public:
+        static constexpr uint32_t slots_per_item = 1;
+
+        Slot() = default;
+
+        Slot(Slot &&other) noexcept
+            : m_entry(other.m_entry.load(std::memory_order_relaxed))
+        {
+        }
+
+        Entry *entry() const
+        {
+            return m_entry.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Store the entry in the slot when it is still empty. Otherwise, the
+         * entry that is in the slot already is written to r_current.
+         */
+        bool try_set(Entry *&r_current, Entry *entry)
+        {
+            return m_entry.compare_exchange_strong(r_current,
+                                                   entry,
+                                                   std::memory_order_release,
+                                                   std::memory_order_acquire);
+        }
+    };
+
+    using ArrayType = OpenAddressingArray<Slot, 1, Allocator, SizeT>;
+
+    struct Table {
+        ArrayType array;
+        /* The table that was replaced by this one, or null. */
+        Table *previous = nullptr;
+
+        /* Number of slots that are set or reserved by an insertion. */
+        alignas(cache_line_size) std::atomic<SizeT> slots_set{0};
+
+        /* Migration state. It is only used once next is set. */
+        alignas(cache_line_size) std::atomic<Table *> next{nullptr};
+        std::atomic<bool> migration_ready{false};
+        std::atomic<SizeT> next_chunk{0};
+        std::atomic<SizeT> chunks_done{0};
+
+        Table(ArrayType array) : array(std::move(array))
+        {
+        }
+
+        SizeT chunk_amount() const
+        {
+            return (array.slots_total() + slots_per_chunk - 1) /
+                   slots_per_chunk;
+        }
+    };
+
+    Allocator m_allocator;
+    alignas(cache_line_size) std::atomic<Table *> m_table;
+    alignas(cache_line_size) std::atomic<uint32_t> m_active_writers{0};
+    std::mutex m_grow_mutex;
+
+  public:
+    ConcurrentMap() : ConcurrentMap(0)
+    {
+    }
+
+    /**
+     * Create a map that can hold min_usable_slots entries before it has to
+     * grow for the first time.
+     */
+    explicit ConcurrentMap(SizeT min_usable_slots)
+    {
+        m_table.store(this->new_table(ArrayType().init_reserved(
+                          std::max<SizeT>(min_usable_slots, 1))),
+                      std::memory_order_relaxed);
+    }
+
+    ~ConcurrentMap()
+    {
+        Table *table = m_table.load(std::memory_order_relaxed);
+        for (Slot &slot : table->array) {
+            Entry *entry = slot.entry();
+            if (entry != nullptr) {
+                entry->~Entry();
+                m_allocator.free(entry);
+            }
+        }
+        while (table != nullptr) {
+            Table *previous = table->previous;
+            table->~Table();
+            m_allocator.free(table);
+            table = previous;
+        }
+    }
+
+    ConcurrentMap(const ConcurrentMap &other) = delete;
+    ConcurrentMap &operator=(const ConcurrentMap &other) = delete;
+
+    /**
+     * Insert a new key-value-pair if the key does not exist yet.
+     * Returns true when the pair was newly inserted, otherwise false.
+     */
+    bool add(const KeyT &key, const ValueT &value)
+    {
+        bool newly_added;
+        this->lookup_or_add__impl(
+            key, [&]() { return value; }, newly_added);
+        return newly_added;
+    }
+
+    /**
+     * Get the value that is stored for the key. When the key does not exist
+     * yet, create_value is called to create the value that is added.
+     *
+     * When multiple threads add the same key at the same time, all of them
+     * get the value of the thread that added it first. The other created
+     * values are destructed again.
+     */
+    template<typename CreateValueF>
+    const ValueT &lookup_or_add(const KeyT &key,
+                                const CreateValueF &create_value)
+    {
+        bool newly_added;
+        return this->lookup_or_add__impl(key, create_value, newly_added);
+    }
+
+    /**
+     * Get a pointer to the value that is stored for the key, or null when the
+     * key does not exist. The pointer stays valid until the map is
+     * destructed.
+     */
+    const ValueT *lookup_ptr(const KeyT &key) const
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        const Entry *entry = this->lookup_entry(key, hash);
+        return (entry == nullptr) ? nullptr : &entry->value;
+    }
+
+    /**
+     * Get the value that is stored for the key.
+     * Asserts that the key exists.
+     */
+    const ValueT &lookup(const KeyT &key) const
+    {
+        const ValueT *ptr = this->lookup_ptr(key);
+        assert(ptr != nullptr);
+        return *ptr;
+    }
+
+    /**
+     * Get the value that is stored for the key, or the default value when
+     * the key does not exist.
+     */
+    ValueT lookup_default(const KeyT &key, const ValueT &default_value) const
+    {
+        const ValueT *ptr = this->lookup_ptr(key);
+        return (ptr == nullptr) ? default_value : *ptr;
+    }
+
+    bool contains(const KeyT &key) const
+    {
+        return this->lookup_ptr(key) != nullptr;
+    }
+
+    /**
+     * Number of entries in the map. While other threads add entries, this
+     * can include insertions that are still in progress.
+     */
+    SizeT size() const
+    {
+        return m_table.load(std::memory_order_acquire)
+            ->slots_set.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Call the function for every key-value-pair in the map. Entries that
+     * are added by other threads during the iteration might be skipped.
+     */
+    template<typename FuncT> void foreach_item(const FuncT &func) const
+    {
+        const Table *table = m_table.load(std::memory_order_acquire);
+        for (const Slot &slot : table->array) {
+            const Entry *entry = slot.entry();
+            if (entry != nullptr) {
+                func(entry->key, entry->value);
+            }
+        }
+    }
+
+  private:
+    template<typename CreateValueF>
+    const ValueT &lookup_or_add__impl(const KeyT &key,
+                                      const CreateValueF &create_value,
+                                      bool &r_newly_added)
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        const Entry *existing = this->lookup_entry(key, hash);
+        if (existing != nullptr) {
+            r_newly_added = false;
+            return existing->value;
+        }
+
+        Entry *entry = (Entry *)m_allocator.allocate(sizeof(Entry),
+                                                     alignof(Entry));
+        new (entry) Entry{hash, key, create_value()};
+        Entry *stored = this->insert_entry(entry);
+        r_newly_added = stored == entry;
+        if (!r_newly_added) {
+            entry->~Entry();
+            m_allocator.free(entry);
+        }
+        return stored->value;
+    }
+
+    Table *new_table(ArrayType array)
+    {
+        Table *table = (Table *)m_allocator.allocate(sizeof(Table),
+                                                     alignof(Table));
+        new (table) Table(std::move(array));
+        return table;
+    }
+
+    const Entry *lookup_entry(const KeyT &key, SizeT hash) const
+    {
+        const Table *table = m_table.load(std::memory_order_acquire);
+        ITER_SLOTS_BEGIN(hash, table->array, const, slot)
+        {
+            const Entry *entry = slot.entry();
+            if (entry == nullptr) {
+                return nullptr;
+            }
+            if (entry->hash == hash && entry->key == key) {
+                return entry;
+            }
+        }
+        ITER_SLOTS_END;
+    }
+
+    /**
+     * Insert the entry unless there is an entry with the same key already.
+     * Returns the entry that is in the map afterwards.
+     */
+    Entry *insert_entry(Entry *entry)
+    {
+        while (true) {
+            Table *table = this->begin_write();
+            SizeT slots_set = table->slots_set.fetch_add(1);
+            if (slots_set >= table->array.slots_usable()) {
+                table->slots_set.fetch_sub(1);
+                this->end_write();
+                this->grow(*table);
+                continue;
+            }
+            Entry *stored = this->insert_entry_in_table(*table, entry);
+            if (stored != entry) {
+                table->slots_set.fetch_sub(1);
+            }
+            this->end_write();
+            return stored;
+        }
+    }
+
+    /**
+     * Two threads that insert the same key go through the same probe
+     * sequence and only ever try to fill the first empty slot in it. The one
+     * that fails to fill the slot finds the entry of the other one in it.
+     */
+    static Entry *insert_entry_in_table(Table &table, Entry *entry)
+    {
+        ITER_SLOTS_BEGIN(entry->hash, table.array, , slot)
+        {
+            Entry *current = slot.entry();
+            while (current == nullptr) {
+                if (slot.try_set(current, entry)) {
+                    return entry;
+                }
+            }
+            if (current->hash == entry->hash && current->key == entry->key) {
+                return current;
+            }
+        }
+        ITER_SLOTS_END;
+    }
+
+    /**
+     * Register the calling thread as writer and get the table it can insert
+     * into. While a table is replaced, no thread is registered as writer.
+     * Threads that want to write in the meantime help moving the entries.
+     */
+    Table *begin_write()
+    {
+        while (true) {
+            Table *table = m_table.load();
+            m_active_writers.fetch_add(1);
+            /* A table gets its successor before the writers are counted in
+             * grow, so either this thread sees the successor, or grow sees
+             * this writer. */
+            if (table->next.load() == nullptr) {
+                return table;
+            }
+            this->end_write();
+            this->help_migrate(*table);
+        }
+    }
+
+    void end_write()
+    {
+        m_active_writers.fetch_sub(1);
+    }
+
+    BAS_NOINLINE void grow(Table &table)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_grow_mutex);
+            if (table.next.load() == nullptr) {
+                SizeT min_usable_slots = (SizeT)(
+                    (double)table.array.slots_usable() *
+                    table.array.growth_factor());
+                Table *new_table = this->new_table(table.array.init_reserved(
+                    std::max(min_usable_slots,
+                             table.array.slots_usable() + 1)));
+                new_table->previous = &table;
+                table.next.store(new_table);
+                while (m_active_writers.load() > 0) {
+                    std::this_thread::yield();
+                }
+                table.migration_ready.store(true);
+            }
+        }
+        this->help_migrate(table);
+    }
+
+    /**
+     * Move chunks of the table to its successor until all chunks are
+     * claimed. Then wait until the successor becomes the current table.
+     */
+    void help_migrate(Table &table)
+    {
+        while (!table.migration_ready.load()) {
+            std::this_thread::yield();
+        }
+        Table &new_table = *table.next.load();
+        SizeT chunk_amount = table.chunk_amount();
+        while (true) {
+            SizeT chunk = table.next_chunk.fetch_add(1);
+            if (chunk >= chunk_amount) {
+                break;
+            }
+            this->migrate_chunk(table, new_table, chunk);
+            if (table.chunks_done.fetch_add(1) + 1 == chunk_amount) {
+                m_table.store(&new_table);
+            }
+        }
+        while (m_table.load() == &table) {
+            std::this_thread::yield();
+        }
+    }
+
+    static void migrate_chunk(Table &table, Table &new_table, SizeT chunk)
+    {
+        SizeT start = chunk * slots_per_chunk;
+        SizeT end = std::min(start + slots_per_chunk,
+                             table.array.slots_total());
+        SizeT moved = 0;
+        for (SizeT i = start; i < end; i++) {
+            Entry *entry = table.array.item(i).entry();
+            if (entry != nullptr) {
+                insert_entry_in_table(new_table, entry);
+                moved++;
+            }
+        }
+        new_table.slots_set.fetch_add(moved);
+    }
+};
+
+#undef ITER_SLOTS_BEGIN
+#undef ITER_SLOTS_END
+
+}  // namespace bas
@@ -0,0 +1,230 @@
+#pragma once
+
+/**
+ * A control group stores one metadata byte for each of 16 consecutive slots
+ * in a hash table. Every byte is either empty, dummy, or contains a 7 bit
+ * fragment of the hash of the key that is stored in the slot.
+ *
+ * This allows a hash table to check all 16 slots of a group with a single
+ * vector comparison. Only the slots whose fragment matches the fragment of
+ * the searched key have to compare the actual keys. Most lookups for keys that
+ * are not in the table do not compare any key at all.
+ *
+ * SSE2 is used when it is available. Otherwise, a portable implementation that
+ * compares one byte at a time is used.
+ */
+
+#include <cstring>
+
+#include "utildefines.h"
+
+#ifdef BAS_HAS_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace bas {
+
+/**
+ * A set of slot offsets within a control group, stored as bits.
+ * It can be iterated over to get the offsets in increasing order.
+ */
+class SlotMask {
+  private:
+    uint32_t m_bits;
+
+  public:
+    explicit SlotMask(uint32_t bits) : m_bits(bits)
+    {
+    }
+
+    bool has_any() const
+    {
+        return m_bits != 0;
+    }
+
+    /**
+     * Get the lowest offset in the mask.
+     * Asserts that the mask is not empty.
+     */
+    uint32_t first() const
+    {
+        return count_trailing_zeros(m_bits);
+    }
+
+    uint32_t bits() const
+    {
+        return m_bits;
+    }
+
+    class Iterator {
+      private:
+        uint32_t m_bits;
+
+      public:
+        Iterator(uint32_t bits) : m_bits(bits)
+        {
+        }
+
+        Iterator &operator++()
+        {
+            /* Clear the lowest set bit. */
+            m_bits &= m_bits - 1;
+            return *this;
+        }
+
+        bool operator!=(const Iterator &iterator) const
+        {
+            return m_bits != iterator.m_bits;
+        }
+
+        uint32_t operator*() const
+        {
+            return count_trailing_zeros(m_bits);
+        }
+    };
+
+    Iterator begin() const
+    {
+        return Iterator(m_bits);
+    }
+
+    Iterator end() const
+    {
+        return Iterator(0);
+    }
+};
+
+class ControlGroup {
+  public:
+    static constexpr uint32_t size = 16;
+
+  private:
+    /* Set slots have the highest bit cleared. */
+    static constexpr uint8_t IS_EMPTY = 0x80;
+    static constexpr uint8_t IS_DUMMY = 0xFE;
+
+    uint8_t m_bytes[size];
+
+  public:
+    ControlGroup()
+    {
+        memset(m_bytes, IS_EMPTY, size);
+    }
+
+    /**
+     * Compute the 7 bit fragment that is stored for a hash. The top bits of a
+     * multiplicative hash are used, so that all bits of the hash have an
+     * influence on the fragment. The low bits of the hash are already used to
+     * find the group.
+     */
+    static uint8_t fragment(uint32_t hash)
+    {
+        return (uint8_t)((hash * 0x9E3779B1u) >> 25);
+    }
+
+    static uint8_t fragment(uint64_t hash)
+    {
+        return (uint8_t)((hash * 0x9E3779B97F4A7C15ull) >> 57);
+    }
+
+    bool is_set(uint32_t offset) const
+    {
+        assert(offset < size);
+        return (m_bytes[offset] & 0x80) == 0;
+    }
+
+    bool is_empty(uint32_t offset) const
+    {
+        assert(offset < size);
+        return m_bytes[offset] == IS_EMPTY;
+    }
+
+    bool is_dummy(uint32_t offset) const
+    {
+        assert(offset < size);
+        return m_bytes[offset] == IS_DUMMY;
+    }
+
+    void set(uint32_t offset, uint8_t fragment)
+    {
+        assert(offset < size);
+        assert(fragment < 0x80);
+        m_bytes[offset] = fragment;
+    }
+
+    void set_dummy(uint32_t offset)
+    {
+        assert(this->is_set(offset));
+        m_bytes[offset] = IS_DUMMY;
+    }
+
+    void set_empty(uint32_t offset)
+    {
+        assert(!this->is_empty(offset));
+        m_bytes[offset] = IS_EMPTY;
+    }
+
+    /**
+     * First step of rehashing a table in place: dummies become empty and set
+     * slots become dummies, which marks them as not yet rehashed.
+     */
+    void prepare_rehash_in_place()
+    {
+        for (uint32_t offset = 0; offset < size; offset++) {
+            m_bytes[offset] = this->is_set(offset) ? IS_DUMMY : IS_EMPTY;
+        }
+    }
+
+    /**
+     * Get all set slots that store the given fragment.
+     */
+    SlotMask match(uint8_t fragment) const
+    {
+        return SlotMask(this->match_byte(fragment));
+    }
+
+    SlotMask match_empty() const
+    {
+        return SlotMask(this->match_byte(IS_EMPTY));
+    }
+
+    /**
+     * Get all slots that are empty or dummy.
+     */
+    SlotMask match_free() const
+    {
+        return SlotMask(~this->match_set().bits() & 0xFFFFu);
+    }
+
+    SlotMask match_set() const
+    {
+#ifdef BAS_HAS_SSE2
+        __m128i bytes = _mm_loadu_si128((const __m128i *)m_bytes);
+        return SlotMask(~(uint32_t)_mm_movemask_epi8(bytes) & 0xFFFFu);
+#else
+        uint32_t bits = 0;
+        for (uint32_t offset = 0; offset < size; offset++) {
+            bits |= (uint32_t)((m_bytes[offset] & 0x80) == 0) << offset;
+        }
+        return SlotMask(bits);
+#endif
+    }
+
+  private:
+    uint32_t match_byte(uint8_t byte) const
+    {
+#ifdef BAS_HAS_SSE2
+        __m128i bytes = _mm_loadu_si128((const __m128i *)m_bytes);
+        __m128i pattern = _mm_set1_epi8((char)byte);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, pattern));
+#else
+        uint32_t bits = 0;
+        for (uint32_t offset = 0; offset < size; offset++) {
+            bits |= (uint32_t)(m_bytes[offset] == byte) << offset;
+        }
+        return bits;
+#endif
+    }
+};
+
+}  // namespace bas
@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * EnumerableThreadSpecific holds a separate instance of a type for every
+ * thread that uses it. The instance of a thread is created the first time
+ * the thread calls local(). Afterwards, all instances can be enumerated,
+ * e.g. to combine per-thread results or to free per-thread arenas together.
+ *
+ * Every thread remembers the instance it used last. Otherwise, the instance
+ * is found with a lock-free lookup in a ConcurrentMap. Instances are aligned
+ * to cache lines, so threads do not share cache lines when they modify their
+ * own instance.
+ */
+
+#include <mutex>
+
+#include "concurrent_map.h"
+#include "vector.h"
+
+namespace bas {
+
+template<typename T, typename Allocator = RawAllocator>
+class EnumerableThreadSpecific : NonCopyable, NonMovable {
+  private:
+    static constexpr size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+
+    /* Identifies this object in the per-thread cache. Unlike the address,
+     * it is never reused by another object. */
+    uint64_t m_id = next_unique_id();
+    ConcurrentMap<uint64_t, T *, Allocator> m_instance_by_thread;
+    std::mutex m_instances_mutex;
+    Vector<T *> m_instances;
+
+  public:
+    EnumerableThreadSpecific() = default;
+
+    ~EnumerableThreadSpecific()
+    {
+        for (T *instance : m_instances) {
+            instance->~T();
+            Allocator().free(instance);
+        }
+    }
+
+    /**
+     * Get the instance of the current thread. It is default constructed when
+     * the thread did not use it before.
+     */
+    T &local()
+    {
+        struct LastUsed {
+            uint64_t id = UINT64_MAX;
+            T *instance = nullptr;
+        };
+        static thread_local LastUsed last_used;
+        if (last_used.id == m_id) {
+            return *last_used.instance;
+        }
+
+        uint64_t thread_key = current_thread_key();
+        T *instance = m_instance_by_thread.lookup_default(thread_key, nullptr);
+        if (instance == nullptr) {
+            instance = this->add_instance(thread_key);
+        }
+        last_used.id = m_id;
+        last_used.instance = instance;
+        return *instance;
+    }
+
+    /**
+     * Number of threads that called local() so far. Like foreach, this must
+     * not be called while other threads might create their instance.
+     */
+    size_t size() const
+    {
+        return m_instances.size();
+    }
+
+    /**
+     * Call the function with every instance. Must not be called while other
+     * threads might create their instance.
+     */
+    template<typename FuncT> void foreach(const FuncT &func)
+    {
+        for (T *instance : m_instances) {
+            func(*instance);
+        }
+    }
+
+    template<typename FuncT> void foreach(const FuncT &func) const
+    {
+        for (const T *instance : m_instances) {
+            func(*instance);
+        }
+    }
+
+  private:
+    /**
+     * Every thread gets a unique key the first time it uses any
+     * EnumerableThreadSpecific. Keys are never reused, so a new thread never
+     * finds the instance of a thread that has finished already.
+     */
+    static uint64_t current_thread_key()
+    {
+        static thread_local uint64_t key = next_unique_id();
+        return key;
+    }
+
+    static uint64_t next_unique_id()
+    {
+        static std::atomic<uint64_t> next_id{0};
+        return next_id.fetch_add(1);
+    }
+
+    BAS_NOINLINE T *add_instance(uint64_t thread_key)
+    {
+        void *buffer = Allocator().allocate(sizeof(T), alignment);
+        T *instance = new (buffer) T();
+        {
+            std::lock_guard<std::mutex> lock(m_instances_mutex);
+            m_instances.append(instance);
+        }
+        m_instance_by_thread.add(thread_key, instance);
+        return instance;
+    }
+};
+
+}  // namespace bas
@@ -0,0 +1,516 @@
+#pragma once
+
+/**
+ * A frozen map is a read-only view of a Map that has been written to a
+ * buffer, usually a file. The items of the open addressing array are
+ * written as they are, so the view can probe them with the same code as the
+ * map itself and nothing has to be rehashed when the buffer is loaded.
+ * Together with MappedFile, even very large tables are ready to be queried
+ * right after the file is mapped, and all processes that map the same file
+ * share its pages.
+ *
+ *   FrozenMap<uint64_t, float>::write(stream, map);
+ *   ...
+ *   MappedFile file("table.bin");
+ *   if (FrozenMap<uint64_t, float>::is_valid(file.buffer())) {
+ *       FrozenMap<uint64_t, float> frozen(file.buffer());
+ *       const float *value = frozen.lookup_ptr(key);
+ *   }
+ *
+ * FrozenSet and FrozenStringMap do the same for Set and StringMap. A string
+ * map also writes the buffer that contains its keys.
+ *
+ * The buffer starts with a FrozenHeader, followed by the items at a 64 byte
+ * aligned offset and the key characters of string maps. Only tables whose
+ * keys and values are trivially copyable can be frozen. The header contains
+ * the sizes of all types, so that a buffer that has been written with a
+ * different layout is detected. The hash function is not checked, so the
+ * buffer has to be read with the same hash as it has been written with.
+ */
+
+#include <ostream>
+
+#include "map.h"
+#include "set.h"
+#include "string_map.h"
+
+namespace bas {
+
+enum class FrozenKind : uint32_t {
+    Map = 1,
+    Set = 2,
+    StringMap = 3,
+};
+
+struct FrozenHeader {
+    /* "BASFROZN" when read as little endian integer. It does not match on
+     * platforms with another byte order. */
+    static constexpr uint64_t magic_value = 0x4e5a4f5246534142;
+    static constexpr uint32_t current_version = 1;
+    static constexpr size_t items_offset = 64;
+
+    uint64_t magic;
+    uint32_t version;
+    FrozenKind kind;
+    uint32_t item_size;
+    uint32_t item_alignment;
+    uint32_t size_type_size;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t padding;
+    /* Number of elements in the table. */
+    uint64_t size;
+    uint64_t item_amount;
+    /* Size of the buffer with the keys, only used by string maps. */
+    uint64_t chars_size;
+
+    size_t chars_offset() const
+    {
+        return items_offset + (size_t)(item_amount * item_size);
+    }
+
+    size_t buffer_size() const
+    {
+        return this->chars_offset() + (size_t)chars_size;
+    }
+};
+
+static_assert(sizeof(FrozenHeader) <= FrozenHeader::items_offset,
+              "The items should start after the header.");
+
+/**
+ * Read-only array of items that is used for probing in a frozen table. It
+ * has the same interface as the parts of OpenAddressingArray that are
+ * needed for lookups.
+ */
+template<typename Item, typename SizeT> class FrozenArray {
+  private:
+    const Item *m_items = nullptr;
+    SizeT m_item_amount = 0;
+
+  public:
+    FrozenArray() = default;
+
+    FrozenArray(const Item *items, SizeT item_amount)
+        : m_items(items), m_item_amount(item_amount)
+    {
+        assert(is_power_of_2(item_amount));
+    }
+
+    SizeT item_mask() const
+    {
+        return m_item_amount - 1;
+    }
+
+    SizeT slot_mask() const
+    {
+        return m_item_amount * Item::slots_per_item - 1;
+    }
+
+    SizeT item_amount() const
+    {
+        return m_item_amount;
+    }
+
+    const Item &item(SizeT item_index) const
+    {
+        return m_items[item_index];
+    }
+
+    const Item *begin() const
+    {
+        return m_items;
+    }
+
+    const Item *end() const
+    {
+        return m_items + m_item_amount;
+    }
+};
+
+namespace frozen_detail {
+
+template<typename Item, typename SizeT>
+inline FrozenHeader make_header(FrozenKind kind,
+                                uint32_t key_size,
+                                uint32_t value_size)
+{
+    FrozenHeader header = {};
+    header.magic = FrozenHeader::magic_value;
+    header.version = FrozenHeader::current_version;
+    header.kind = kind;
+    header.item_size = (uint32_t)sizeof(Item);
+    header.item_alignment = (uint32_t)alignof(Item);
+    header.size_type_size = (uint32_t)sizeof(SizeT);
+    header.key_size = key_size;
+    header.value_size = value_size;
+    return header;
+}
+
+/**
+ * Returns the header when the buffer contains a table with the expected
+ * layout, otherwise null.
+ */
+inline const FrozenHeader *find_header(ArrayRef<char> buffer,
+                                       const FrozenHeader &expected)
+{
+    if (buffer.size() < FrozenHeader::items_offset ||
+        !is_aligned(buffer.begin(), FrozenHeader::items_offset)) {
+        return nullptr;
+    }
+    const FrozenHeader *header = (const FrozenHeader *)buffer.begin();
+    if (header->magic != expected.magic ||
+        header->version != expected.version ||
+        header->kind != expected.kind ||
+        header->item_size != expected.item_size ||
+        header->item_alignment != expected.item_alignment ||
+        header->size_type_size != expected.size_type_size ||
+        header->key_size != expected.key_size ||
+        header->value_size != expected.value_size) {
+        return nullptr;
+    }
+    /* Check the sizes one by one, so that the total size cannot overflow
+     * when the buffer is corrupted. */
+    if (header->item_amount == 0 || !is_power_of_2(header->item_amount) ||
+        header->item_amount > buffer.size() / header->item_size ||
+        header->chars_size > buffer.size() ||
+        header->buffer_size() != buffer.size()) {
+        return nullptr;
+    }
+    return header;
+}
+
+inline bool write_buffer(std::ostream &stream,
+                         const FrozenHeader &header,
+                         const void *items,
+                         const char *chars)
+{
+    char padding[FrozenHeader::items_offset] = {};
+    stream.write((const char *)&header, sizeof(FrozenHeader));
+    stream.write(padding,
+                 FrozenHeader::items_offset - sizeof(FrozenHeader));
+    stream.write((const char *)items,
+                 (std::streamsize)(header.item_amount * header.item_size));
+    stream.write(chars, (std::streamsize)header.chars_size);
+    return stream.good();
+}
+
+}  // namespace frozen_detail
+
+template<typename KeyT,
+         typename ValueT,
+         typename Hash = DefaultHash<KeyT>,
+         typename SizeT = uint32_t>
+class FrozenMap {
+    static_assert(std::is_trivially_copyable<KeyT>::value &&
+                      std::is_trivially_copyable<ValueT>::value,
+                  "Only maps with trivially copyable types can be frozen.");
+
+  private:
+    /* The layout of the items does not depend on the allocator. */
+    using MapType = Map<KeyT, ValueT, RawAllocator, Hash, SizeT>;
+    using Item = typename MapType::Item;
+
+    FrozenArray<Item, SizeT> m_array;
+    SizeT m_size;
+
+  public:
+    /**
+     * Create a view of a buffer that has been written by write. The buffer
+     * has to stay alive as long as the view is used.
+     * Asserts that the buffer is valid.
+     */
+    explicit FrozenMap(ArrayRef<char> buffer)
+    {
+        const FrozenHeader *header = frozen_detail::find_header(
+            buffer, expected_header());
+        assert(header != nullptr);
+        m_array = FrozenArray<Item, SizeT>(
+            (const Item *)(buffer.begin() + FrozenHeader::items_offset),
+            (SizeT)header->item_amount);
+        m_size = (SizeT)header->size;
+    }
+
+    /**
+     * Returns true when the buffer contains a map that has been written
+     * with the same key, value and size types. Buffers that are read from
+     * disk should be checked before a view is created.
+     */
+    static bool is_valid(ArrayRef<char> buffer)
+    {
+        return frozen_detail::find_header(buffer, expected_header()) !=
+               nullptr;
+    }
+
+    /**
+     * Write the map in the layout that can be used by a frozen map.
+     * Asserts that the map is not growing incrementally.
+     * Returns false when writing to the stream failed.
+     */
+    template<typename Allocator>
+    static bool write(std::ostream &stream,
+                      const Map<KeyT, ValueT, Allocator, Hash, SizeT> &map)
+    {
+        assert(!map.is_growing_incrementally());
+        static_assert(
+            sizeof(typename Map<KeyT, ValueT, Allocator, Hash, SizeT>::Item) ==
+                sizeof(Item),
+            "The layout of the items should not depend on the allocator.");
+        FrozenHeader header = expected_header();
+        header.size = map.size();
+        header.item_amount = map.m_array.item_amount();
+        return frozen_detail::write_buffer(
+            stream, header, map.m_array.begin(), nullptr);
+    }
+
+    SizeT size() const
+    {
+        return m_size;
+    }
+
+    bool is_empty() const
+    {
+        return m_size == 0;
+    }
+
+    const ValueT *lookup_ptr(const KeyT &key) const
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        return MapType::lookup_ptr_in_array(m_array, key, hash);
+    }
+
+    bool contains(const KeyT &key) const
+    {
+        return this->lookup_ptr(key) != nullptr;
+    }
+
+    /**
+     * Get the value that is stored for the key.
+     * Asserts when the key does not exist.
+     */
+    const ValueT &lookup(const KeyT &key) const
+    {
+        const ValueT *value = this->lookup_ptr(key);
+        assert(value != nullptr);
+        return *value;
+    }
+
+    ValueT lookup_default(const KeyT &key, const ValueT &default_value) const
+    {
+        const ValueT *value = this->lookup_ptr(key);
+        return value != nullptr ? *value : default_value;
+    }
+
+    template<typename FuncT> void foreach_item(const FuncT &func) const
+    {
+        for (const Item &item : m_array) {
+            for (uint32_t offset : item.set_slots()) {
+                func(*item.key(offset), *item.value(offset));
+            }
+        }
+    }
+
+  private:
+    static FrozenHeader expected_header()
+    {
+        return frozen_detail::make_header<Item, SizeT>(
+            FrozenKind::Map, sizeof(KeyT), sizeof(ValueT));
+    }
+};
+
+template<typename T,
+         typename Hash = DefaultHash<T>,
+         typename SizeT = uint32_t>
+class FrozenSet {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only sets with a trivially copyable type can be frozen.");
+
+  private:
+    using SetType = Set<T, RawAllocator, Hash, SizeT>;
+    using Item = typename SetType::Item;
+
+    FrozenArray<Item, SizeT> m_array;
+    SizeT m_size;
+
+  public:
+    /**
+     * See FrozenMap.
+     */
+    explicit FrozenSet(ArrayRef<char> buffer)
+    {
+        const FrozenHeader *header = frozen_detail::find_header(
+            buffer, expected_header());
+        assert(header != nullptr);
+        m_array = FrozenArray<Item, SizeT>(
+            (const Item *)(buffer.begin() + FrozenHeader::items_offset),
+            (SizeT)header->item_amount);
+        m_size = (SizeT)header->size;
+    }
+
+    static bool is_valid(ArrayRef<char> buffer)
+    {
+        return frozen_detail::find_header(buffer, expected_header()) !=
+               nullptr;
+    }
+
+    /**
+     * Asserts that the set is not growing incrementally.
+     */
+    template<typename Allocator>
+    static bool write(std::ostream &stream,
+                      const Set<T, Allocator, Hash, SizeT> &set)
+    {
+        assert(!set.is_growing_incrementally());
+        static_assert(
+            sizeof(typename Set<T, Allocator, Hash, SizeT>::Item) ==
+                sizeof(Item),
+            "The layout of the items should not depend on the allocator.");
+        FrozenHeader header = expected_header();
+        header.size = set.size();
+        header.item_amount = set.m_array.item_amount();
+        return frozen_detail::write_buffer(
+            stream, header, set.m_array.begin(), nullptr);
+    }
+
+    SizeT size() const
+    {
+        return m_size;
+    }
+
+    bool is_empty() const
+    {
+        return m_size == 0;
+    }
+
+    bool contains(const T &value) const
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        return SetType::contains_in_array(m_array, value, hash);
+    }
+
+    template<typename FuncT> void foreach_value(const FuncT &func) const
+    {
+        for (const Item &item : m_array) {
+            for (uint32_t offset : item.set_slots()) {
+                func(*item.value(offset));
+            }
+        }
+    }
+
+  private:
+    static FrozenHeader expected_header()
+    {
+        return frozen_detail::make_header<Item, SizeT>(
+            FrozenKind::Set, sizeof(T), 0);
+    }
+};
+
+template<typename T, typename Hash = DefaultHash<StringRef>>
+class FrozenStringMap {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only maps with a trivially copyable type can be frozen.");
+
+  private:
+    using MapType = StringMap<T, RawAllocator, Hash>;
+    using Item = typename MapType::Item;
+
+    FrozenArray<Item, uint32_t> m_array;
+    const char *m_chars;
+    uint32_t m_size;
+
+  public:
+    /**
+     * See FrozenMap. The keys are referenced in the buffer as well.
+     */
+    explicit FrozenStringMap(ArrayRef<char> buffer)
+    {
+        const FrozenHeader *header = frozen_detail::find_header(
+            buffer, expected_header());
+        assert(header != nullptr);
+        m_array = FrozenArray<Item, uint32_t>(
+            (const Item *)(buffer.begin() + FrozenHeader::items_offset),
+            (uint32_t)header->item_amount);
+        m_chars = buffer.begin() + header->chars_offset();
+        m_size = (uint32_t)header->size;
+    }
+
+    static bool is_valid(ArrayRef<char> buffer)
+    {
+        return frozen_detail::find_header(buffer, expected_header()) !=
+               nullptr;
+    }
+
+    template<typename Allocator>
+    static bool write(std::ostream &stream,
+                      const StringMap<T, Allocator, Hash> &map)
+    {
+        static_assert(
+            sizeof(typename StringMap<T, Allocator, Hash>::Item) ==
+                sizeof(Item),
+            "The layout of the items should not depend on the allocator.");
+        FrozenHeader header = expected_header();
+        header.size = map.size();
+        header.item_amount = map.m_array.item_amount();
+        header.chars_size = map.m_chars.size();
+        return frozen_detail::write_buffer(
+            stream, header, map.m_array.begin(), map.m_chars.begin());
+    }
+
+    uint32_t size() const
+    {
+        return m_size;
+    }
+
+    bool is_empty() const
+    {
+        return m_size == 0;
+    }
+
+    const T *lookup_ptr(StringRef key) const
+    {
+        return MapType::lookup_ptr_in_array(
+            m_array, m_chars, key, MapType::compute_string_hash(key));
+    }
+
+    bool contains(StringRef key) const
+    {
+        return this->lookup_ptr(key) != nullptr;
+    }
+
+    /**
+     * Asserts when the key does not exist.
+     */
+    const T &lookup(StringRef key) const
+    {
+        const T *value = this->lookup_ptr(key);
+        assert(value != nullptr);
+        return *value;
+    }
+
+    T lookup_default(StringRef key, const T &default_value) const
+    {
+        const T *value = this->lookup_ptr(key);
+        return value != nullptr ? *value : default_value;
+    }
+
+    template<typename FuncT> void foreach_item(const FuncT &func) const
+    {
+        for (const Item &item : m_array) {
+            for (uint32_t offset = 0; offset < Item::slots_per_item;
+                 offset++) {
+                if (item.is_set(offset)) {
+                    func(item.get_key(offset, m_chars), *item.value(offset));
+                }
+            }
+        }
+    }
+
+  private:
+    static FrozenHeader expected_header()
+    {
+        return frozen_detail::make_header<Item, uint32_t>(
+            FrozenKind::StringMap, 0, sizeof(T));
+    }
+};
+
+}  // namespace bas
@@ -1,14 +1,137 @@
 #pragma once
 
+/**
+ * Hash functions are function objects that return a 32 or 64 bit hash for a
+ * key. All hash tables take the hash function as template parameter, which
+ * uses DefaultHash<Key> by default. Tables convert the hash to their size type
+ * with fold_hash, so that 64 bit hashes keep all their bits in tables with 64
+ * bit sizes and are folded into 32 bits otherwise.
+ */
+
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "string_ref.h"
 #include "utildefines.h"
 
 namespace bas {
 
+namespace hash_detail {
+
+constexpr uint64_t P0 = 0xa0761d6478bd642full;
+constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+
+/* Multiply two 64 bit numbers and fold the 128 bit result into 64 bits. */
+inline uint64_t multiply_fold(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t result = (__uint128_t)a * b;
+    return (uint64_t)result ^ (uint64_t)(result >> 64);
+#else
+    uint64_t a_low = (uint32_t)a, a_high = a >> 32;
+    uint64_t b_low = (uint32_t)b, b_high = b >> 32;
+    uint64_t low_low = a_low * b_low;
+    uint64_t high_low = a_high * b_low;
+    uint64_t low_high = a_low * b_high;
+    uint64_t high_high = a_high * b_high;
+    uint64_t cross = (low_low >> 32) + (uint32_t)high_low + low_high;
+    uint64_t low = (cross << 32) | (uint32_t)low_low;
+    uint64_t high = high_high + (high_low >> 32) + (cross >> 32);
+    return low ^ high;
+#endif
+}
+
+inline uint64_t read_u64(const uint8_t *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline uint64_t read_u32(const uint8_t *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+}  // namespace hash_detail
+
+/**
+ * Hash an arbitrary byte buffer. This follows the structure of wyhash: up to
+ * 16 bytes are hashed without a loop, longer buffers are consumed 32 bytes per
+ * iteration in two independent lanes. The result depends on the byte order of
+ * the machine.
+ */
+inline uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0)
+{
+    using namespace hash_detail;
+
+    const uint8_t *ptr = (const uint8_t *)data;
+    seed ^= P0;
+    uint64_t a, b;
+    if (size <= 16) {
+        if (size >= 4) {
+            size_t shift = (size >> 3) << 2;
+            a = (read_u32(ptr) << 32) | read_u32(ptr + shift);
+            b = (read_u32(ptr + size - 4) << 32) |
+                read_u32(ptr + size - 4 - shift);
+        }
+        else if (size > 0) {
+            a = ((uint64_t)ptr[0] << 16) | ((uint64_t)ptr[size >> 1] << 8) |
+                (uint64_t)ptr[size - 1];
+            b = 0;
+        }
+        else {
+            a = 0;
+            b = 0;
+        }
+    }
+    else {
+        size_t remaining = size;
+        if (remaining > 32) {
+            uint64_t seed2 = seed;
+            do {
+                seed = multiply_fold(read_u64(ptr) ^ P1,
+                                     read_u64(ptr + 8) ^ seed);
+                seed2 = multiply_fold(read_u64(ptr + 16) ^ P2,
+                                      read_u64(ptr + 24) ^ seed2);
+                ptr += 32;
+                remaining -= 32;
+            } while (remaining > 32);
+            seed ^= seed2;
+        }
+        if (remaining > 16) {
+            seed = multiply_fold(read_u64(ptr) ^ P1, read_u64(ptr + 8) ^ seed);
+            ptr += 16;
+            remaining -= 16;
+        }
+        /* The last 16 bytes might overlap with already consumed bytes. */
+        a = read_u64(ptr + remaining - 16);
+        b = read_u64(ptr + remaining - 8);
+    }
+    return multiply_fold(P3 ^ size, multiply_fold(a ^ P1, b ^ seed));
+}
+
+/**
+ * Mix all bits of an integer, so that every input bit affects every output
+ * bit. This is the finalizer of splitmix64.
+ */
+inline uint64_t mix_bits(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
 template<typename T> struct DefaultHash {
 };
 
@@ -22,10 +145,10 @@ template<typename T> struct DefaultHash {
 
 /**
  * Cannot make any assumptions about the distribution of keys, so use a trivial
- * hash function by default. The hash table implementations are designed to
- * take all bits of the hash into account to avoid really bad behavior when the
- * lower bits are all zero. Special hash functions can be implemented when more
- * knowledge about a specific key distribution is available.
+ * hash function by default. This is ideal for dense keys like sequential ids.
+ * The hash table implementations are designed to take all bits of the hash
+ * into account to avoid really bad behavior when the lower bits are all zero.
+ * MixedHash can be used when keys have patterns that cause many collisions.
  */
 TRIVIAL_DEFAULT_INT_HASH(int8_t);
 TRIVIAL_DEFAULT_INT_HASH(uint8_t);
@@ -33,24 +156,61 @@ TRIVIAL_DEFAULT_INT_HASH(int16_t);
 TRIVIAL_DEFAULT_INT_HASH(uint16_t);
 TRIVIAL_DEFAULT_INT_HASH(int32_t);
 TRIVIAL_DEFAULT_INT_HASH(uint32_t);
-TRIVIAL_DEFAULT_INT_HASH(int64_t);
-TRIVIAL_DEFAULT_INT_HASH(uint64_t);
+
+#define TRIVIAL_DEFAULT_INT_HASH_64(TYPE) \
+    template<> struct DefaultHash<TYPE> { \
+        uint64_t operator()(TYPE value) const \
+        { \
+            return (uint64_t)value; \
+        } \
+    }
+
+/* The upper half of 64 bit integers is folded into the lower half when a
+ * table only uses 32 bit hashes. */
+TRIVIAL_DEFAULT_INT_HASH_64(int64_t);
+TRIVIAL_DEFAULT_INT_HASH_64(uint64_t);
 
 template<> struct DefaultHash<float> {
     uint32_t operator()(float value) const
     {
-        return *(uint32_t *)&value;
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+};
+
+template<> struct DefaultHash<StringRef> {
+    uint64_t operator()(StringRef value) const
+    {
+        return hash_bytes(value.data(), value.size());
+    }
+};
+
+template<> struct DefaultHash<StringRefNull> {
+    uint64_t operator()(StringRefNull value) const
+    {
+        return DefaultHash<StringRef>{}(value);
     }
 };
 
 template<> struct DefaultHash<std::string> {
-    uint32_t operator()(const std::string &value) const
+    uint64_t operator()(const std::string &value) const
     {
-        uint32_t hash = 5381;
-        for (char c : value) {
-            hash = hash * 33 + c;
-        }
-        return hash;
+        return DefaultHash<StringRef>{}(value);
+    }
+};
+
+/**
+ * Hash function for integer keys that mixes all bits. Use it instead of the
+ * default hash when keys have a regular structure, e.g. when they are all
+ * multiples of a large power of two.
+ */
+template<typename T> struct MixedHash {
+    uint64_t operator()(T value) const
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "MixedHash only works for integer types.");
+        return mix_bits((uint64_t)value);
     }
 };
 
@@ -60,28 +220,120 @@ template<> struct DefaultHash<std::string> {
  * aligned addresses on 64-bit systems.
  */
 template<typename T> struct DefaultHash<T *> {
-    uint32_t operator()(const T *value) const
+    uint64_t operator()(const T *value) const
     {
         uintptr_t ptr = ptr_to_int(value);
-        uint32_t hash = (uint32_t)(ptr >> 3);
+        uint64_t hash = (uint64_t)(ptr >> 3);
         return hash;
     }
 };
 
 template<typename T> struct DefaultHash<std::unique_ptr<T>> {
-    uint32_t operator()(const std::unique_ptr<T> &value) const
+    uint64_t operator()(const std::unique_ptr<T> &value) const
     {
         return DefaultHash<T *>{}(value.get());
     }
 };
 
 template<typename T1, typename T2> struct DefaultHash<std::pair<T1, T2>> {
-    uint32_t operator()(const std::pair<T1, T2> &value) const
+    uint64_t operator()(const std::pair<T1, T2> &value) const
     {
-        uint32_t hash1 = DefaultHash<T1>{}(value.first);
-        uint32_t hash2 = DefaultHash<T2>{}(value.second);
+        uint64_t hash1 = DefaultHash<T1>{}(value.first);
+        uint64_t hash2 = DefaultHash<T2>{}(value.second);
         return hash1 ^ (hash2 * 33);
     }
 };
 
+/**
+ * Convert the result of a hash function to the size type of a hash table.
+ * When a 64 bit hash is used in a 32 bit table, the upper half is mixed into
+ * the lower half instead of being dropped. Hashes that fit into 32 bits are
+ * not changed in that case.
+ */
+template<typename SizeT, typename HashT> inline SizeT fold_hash(HashT hash)
+{
+    static_assert(std::is_unsigned<SizeT>::value,
+                  "Hash tables need an unsigned size type.");
+    if constexpr (sizeof(HashT) > sizeof(SizeT) && sizeof(SizeT) == 4) {
+        uint32_t high = (uint32_t)((uint64_t)hash >> 32);
+        return (SizeT)((uint32_t)hash ^ (high * 0x9E3779B1u));
+    }
+    else {
+        return (SizeT)hash;
+    }
+}
+
+/**
+ * When this is true for a key type, hash tables store the full hash of every
+ * key next to it. Then most key comparisons can be skipped by comparing the
+ * hashes first, and the hashes do not have to be recomputed when the table
+ * grows. This costs the size of a hash per slot, so it is only enabled for
+ * types that are expensive to hash or to compare. Specialize it to enable it
+ * for other types.
+ */
+template<typename T> struct StoreHashInTable {
+    static constexpr bool value = false;
+};
+
+template<> struct StoreHashInTable<std::string> {
+    static constexpr bool value = true;
+};
+
+template<typename T1, typename T2> struct StoreHashInTable<std::pair<T1, T2>> {
+    static constexpr bool value = StoreHashInTable<T1>::value ||
+                                  StoreHashInTable<T2>::value;
+};
+
+/**
+ * Storage for the hashes of N slots. Hash tables derive their slot types from
+ * it, so that it does not take up any space when hashes are not stored. In
+ * that case every hash compares equal and the check is optimized away.
+ */
+template<bool Enabled, uint32_t N, typename HashT = uint32_t>
+class StoredHashes {
+  private:
+    HashT m_hashes[N];
+
+  public:
+    static constexpr bool stores_hashes = true;
+
+    void set_hash(uint32_t offset, HashT hash)
+    {
+        assert(offset < N);
+        m_hashes[offset] = hash;
+    }
+
+    HashT stored_hash(uint32_t offset) const
+    {
+        assert(offset < N);
+        return m_hashes[offset];
+    }
+
+    bool hash_matches(uint32_t offset, HashT hash) const
+    {
+        assert(offset < N);
+        return m_hashes[offset] == hash;
+    }
+};
+
+template<uint32_t N, typename HashT> class StoredHashes<false, N, HashT> {
+  public:
+    static constexpr bool stores_hashes = false;
+
+    void set_hash(uint32_t /*offset*/, HashT /*hash*/)
+    {
+    }
+
+    HashT stored_hash(uint32_t /*offset*/) const
+    {
+        assert(false);
+        return 0;
+    }
+
+    bool hash_matches(uint32_t /*offset*/, HashT /*hash*/) const
+    {
+        return true;
+    }
+};
+
 }  // namespace bas
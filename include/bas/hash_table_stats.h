@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * Statistics about the memory usage and the probing behavior of a hash table.
+ * Every hash table in this library can compute them with compute_stats(), so
+ * that bad hash distributions and oversized tables can be detected at run
+ * time.
+ *
+ * The probe length of an element is the number of probing steps that are
+ * necessary before the element is found. Tables that check a whole group of
+ * slots at once (Map and Set) count groups, the other tables count slots.
+ */
+
+#include <iostream>
+
+#include "string_ref.h"
+#include "vector.h"
+
+namespace bas {
+
+struct HashTableStats {
+    /* Number of elements in the table. */
+    uint64_t size = 0;
+    /* Number of slots in the table. */
+    uint64_t capacity = 0;
+    /* Number of slots that contained an element that has been removed. */
+    uint64_t dummy_amount = 0;
+    /* Fraction of the slots that contain an element. */
+    float load_factor = 0.0f;
+    /* The table grows when the fraction of non-empty slots reaches this. */
+    float max_load_factor = 0.0f;
+    /* The value at index i is the number of elements with probe length i. */
+    Vector<uint64_t> probe_length_histogram;
+    uint64_t max_probe_length = 0;
+    /* Sum of the probe lengths of all elements. */
+    uint64_t total_probe_length = 0;
+    /* Heap memory that is owned by the table. */
+    uint64_t bytes_allocated = 0;
+    /* Part of the allocated memory that does not contain elements. */
+    uint64_t bytes_wasted = 0;
+
+    /**
+     * Record the probe length of one element.
+     */
+    void add_probe_length(uint64_t probe_length)
+    {
+        while (probe_length_histogram.size() <= probe_length) {
+            probe_length_histogram.append(0);
+        }
+        probe_length_histogram[probe_length]++;
+        max_probe_length = std::max(max_probe_length, probe_length);
+        total_probe_length += probe_length;
+    }
+
+    /**
+     * The total is divided only once, so that the result stays precise for
+     * tables with many millions of elements.
+     */
+    double average_probe_length() const
+    {
+        uint64_t amount = 0;
+        for (uint64_t count : probe_length_histogram) {
+            amount += count;
+        }
+        if (amount == 0) {
+            return 0.0;
+        }
+        return (double)total_probe_length / (double)amount;
+    }
+
+    void print(StringRef name, std::ostream &stream = std::cout) const
+    {
+        stream << "Hash Table Stats: " << name << '\n';
+        stream << "  Size: " << size << '\n';
+        stream << "  Capacity: " << capacity << '\n';
+        stream << "  Dummies: " << dummy_amount << '\n';
+        stream << "  Load Factor: " << load_factor << " (max "
+               << max_load_factor << ")\n";
+        stream << "  Average Probe Length: " << this->average_probe_length()
+               << '\n';
+        stream << "  Max Probe Length: " << max_probe_length << '\n';
+        stream << "  Probe Length Histogram:\n";
+        for (uint32_t i = 0; i < probe_length_histogram.size(); i++) {
+            stream << "    " << i << ": " << probe_length_histogram[i]
+                   << '\n';
+        }
+        stream << "  Bytes Allocated: " << bytes_allocated << '\n';
+        stream << "  Bytes Wasted: " << bytes_wasted << '\n';
+    }
+};
+
+}  // namespace bas
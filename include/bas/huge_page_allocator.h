@@ -0,0 +1,71 @@
+#pragma once
+
+/**
+ * The huge page allocator is meant for very large hash tables and vectors.
+ * Random accesses into buffers of many gigabytes cause a TLB miss almost
+ * every time with 4 KiB pages. With 2 MiB pages, far fewer translations
+ * are needed, so more of them fit into the TLB.
+ *
+ * Large allocations are mapped directly with mmap, aligned to 2 MiB and
+ * marked with MADV_HUGEPAGE, so that the kernel backs them with transparent
+ * huge pages. Optionally, explicit huge pages (MAP_HUGETLB) are tried first.
+ * Those have to be reserved by the system administrator. When they are not
+ * available, the allocator falls back to transparent huge pages.
+ *
+ * Large buffers can be grown with mremap. The kernel then moves the page
+ * table entries instead of copying the memory. Small allocations are
+ * forwarded to aligned_malloc. On systems without mmap, all allocations
+ * are.
+ */
+
+#include "aligned_allocation.h"
+
+namespace bas {
+
+class HugePageAllocator {
+  public:
+    /* Smaller allocations do not use mmap. */
+    static constexpr size_t min_mapped_size = 2 * 1024 * 1024;
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    void *allocate(size_t size, size_t alignment) const
+    {
+        return huge_page_allocate(size, alignment);
+    }
+
+    void free(void *pointer) const
+    {
+        huge_page_free(pointer);
+    }
+
+    /**
+     * Grow or shrink the buffer. Large buffers are remapped without copying
+     * when the alignment allows it.
+     */
+    void *reallocate(void *pointer, size_t new_size, size_t alignment) const
+    {
+        return huge_page_reallocate(pointer, new_size, alignment);
+    }
+
+    /**
+     * Try explicit huge pages before falling back to transparent huge pages.
+     * This affects all huge page allocators. The default is false.
+     */
+    static void set_use_explicit_huge_pages(bool enabled);
+    static bool use_explicit_huge_pages();
+
+    /**
+     * Returns true when the buffer has been mapped with mmap instead of
+     * being allocated with aligned_malloc.
+     */
+    static bool is_mapped(const void *pointer);
+
+  private:
+    static void *huge_page_allocate(size_t size, size_t alignment);
+    static void huge_page_free(void *pointer);
+    static void *huge_page_reallocate(void *pointer,
+                                      size_t new_size,
+                                      size_t alignment);
+};
+
+}  // namespace bas
@@ -1,162 +1,361 @@
 #pragma once
 
+/**
+ * The map stores its entries in groups of 16 slots. Every group has a control
+ * group with a hash fragment for every slot. A lookup only has to compare the
+ * keys of the slots whose fragment matches the fragment of the searched key.
+ * Probing stops at the first group that has an empty slot.
+ *
+ * Therefore, a removed slot can become empty again when its group has another
+ * empty slot. Only slots in full groups become dummies. When dummies take up
+ * too much space, the table is rehashed in place instead of growing.
+ *
+ * Optionally, the map grows incrementally. Then the old array is kept after
+ * growing, and every following insertion or removal moves a few of its
+ * items to the new array. Lookups check both arrays until all elements are
+ * moved. Slots that have been moved become dummies in the old array, so
+ * that probing in it still finds the remaining keys.
+ *
+ * SizeT is the type of sizes, indices and hashes in the table. Use uint64_t
+ * for maps that can contain more than about a billion entries, or when 32 bit
+ * hashes cause too many collisions.
+ */
+
 #include "array_ref.h"
+#include "control_group.h"
 #include "hash.h"
 #include "open_addressing.h"
+#include "parallel_grow.h"
 
 namespace bas {
 
 // clang-format off
 
-#define ITER_SLOTS_BEGIN(KEY, ARRAY, OPTIONAL_CONST, R_ITEM, R_OFFSET) \
-  uint32_t hash = DefaultHash<KeyT>{}(KEY); \
-  uint32_t perturb = hash; \
+#define ITER_ITEMS_BEGIN(HASH, ARRAY, OPTIONAL_CONST, R_ITEM, R_FRAGMENT) \
+  SizeT hash_copy = HASH; \
+  uint8_t R_FRAGMENT = ControlGroup::fragment(hash_copy); \
+  SizeT perturb = hash_copy; \
   while (true) { \
-    uint32_t item_index = (hash & ARRAY.slot_mask()) >> OFFSET_SHIFT; \
-    uint8_t R_OFFSET = hash & OFFSET_MASK; \
-    uint8_t initial_offset = R_OFFSET; \
-    OPTIONAL_CONST Item &R_ITEM = ARRAY.item(item_index); \
-    do {
-
-#define ITER_SLOTS_END(R_OFFSET) \
-      R_OFFSET = (R_OFFSET + 1u) & OFFSET_MASK; \
-    } while (R_OFFSET != initial_offset); \
+    SizeT item_index = hash_copy & ARRAY.item_mask(); \
+    OPTIONAL_CONST Item &R_ITEM = ARRAY.item(item_index);
+
+#define ITER_ITEMS_END \
     perturb >>= 5; \
-    hash = hash * 5 + 1 + perturb; \
+    hash_copy = hash_copy * 5 + 1 + perturb; \
   } ((void)0)
 
 // clang-format on
 
-template<typename KeyT, typename ValueT, typename Allocator = RawAllocator>
+template<typename KeyT,
+         typename ValueT,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<KeyT>,
+         typename SizeT = uint32_t>
 class Map {
   private:
-    static constexpr uint32_t OFFSET_MASK = 3;
-    static constexpr uint32_t OFFSET_SHIFT = 2;
-
-    class Item {
+    static constexpr uint32_t OFFSET_MASK = ControlGroup::size - 1;
+    static constexpr uint32_t OFFSET_SHIFT = 4;
+    /* Number of keys that are prefetched ahead in batched lookups. */
+    static constexpr size_t prefetch_distance = 16;
+    /* Number of old items that are moved per operation when the map grows
+     * incrementally. */
+    static constexpr SizeT items_moved_per_step = 4;
+    /* Smaller maps always grow at once, because that is fast anyway. */
+    static constexpr SizeT min_size_for_incremental_grow = 1 << 12;
+
+    using Hashes = StoredHashes<StoreHashInTable<KeyT>::value,
+                                ControlGroup::size,
+                                SizeT>;
+
+    class Item : Hashes {
       private:
-        static constexpr uint8_t IS_EMPTY = 0;
-        static constexpr uint8_t IS_SET = 1;
-        static constexpr uint8_t IS_DUMMY = 2;
-
-        uint8_t m_status[4];
-        char m_keys[4 * sizeof(KeyT)];
-        char m_values[4 * sizeof(ValueT)];
+        ControlGroup m_control;
+        AlignedBuffer<sizeof(KeyT) * ControlGroup::size, alignof(KeyT)>
+            m_keys;
+        AlignedBuffer<sizeof(ValueT) * ControlGroup::size, alignof(ValueT)>
+            m_values;
 
       public:
-        static constexpr uint32_t slots_per_item = 4;
+        static constexpr uint32_t slots_per_item = ControlGroup::size;
+        /* The control group and hashes do not point into the item. */
+        static constexpr bool trivially_relocatable =
+            is_trivially_relocatable<KeyT>::value &&
+            is_trivially_relocatable<ValueT>::value;
+
+        Item() = default;
 
-        Item()
+        ~Item()
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                m_status[offset] = IS_EMPTY;
+            for (uint32_t offset : m_control.match_set()) {
+                destruct(this->key(offset));
+                destruct(this->value(offset));
             }
         }
 
-        ~Item()
+        Item(const Item &other) : Hashes(other), m_control(other.m_control)
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                if (m_status[offset] == IS_SET) {
-                    this->key(offset)->~KeyT();
-                    this->value(offset)->~ValueT();
-                }
+            for (uint32_t offset : m_control.match_set()) {
+                new (this->key(offset)) KeyT(*other.key(offset));
+                new (this->value(offset)) ValueT(*other.value(offset));
             }
         }
 
-        Item(const Item &other)
+        Item(Item &&other) noexcept
+            : Hashes(other), m_control(other.m_control)
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                uint8_t status = other.m_status[offset];
-                m_status[offset] = status;
-                if (status == IS_SET) {
-                    new (this->key(offset)) KeyT(*other.key(offset));
-                    new (this->value(offset)) ValueT(*other.value(offset));
-                }
+            for (uint32_t offset : m_control.match_set()) {
+                new (this->key(offset)) KeyT(std::move(*other.key(offset)));
+                new (this->value(offset))
+                    ValueT(std::move(*other.value(offset)));
             }
         }
 
-        Item(Item &&other) noexcept
+        /**
+         * Return the offset of the slot that contains the key, or -1 when the
+         * key is not in this item.
+         */
+        int32_t find_key(uint8_t fragment,
+                         SizeT hash,
+                         const KeyT &key) const
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                uint8_t status = other.m_status[offset];
-                m_status[offset] = status;
-                if (status == IS_SET) {
-                    new (this->key(offset))
-                        KeyT(std::move(*other.key(offset)));
-                    new (this->value(offset))
-                        ValueT(std::move(*other.value(offset)));
+            for (uint32_t offset : m_control.match(fragment)) {
+                if (this->hash_matches(offset, hash) &&
+                    key == *this->key(offset)) {
+                    return (int32_t)offset;
                 }
             }
+            return -1;
+        }
+
+        /**
+         * Return the offset of the first empty slot, or -1 when the item is
+         * full.
+         */
+        int32_t find_empty() const
+        {
+            SlotMask empty = m_control.match_empty();
+            return empty.has_any() ? (int32_t)empty.first() : -1;
         }
 
-        bool has_key(uint32_t offset, const KeyT &key) const
+        SlotMask set_slots() const
         {
-            return m_status[offset] == IS_SET && key == *this->key(offset);
+            return m_control.match_set();
+        }
+
+        /**
+         * Get the hash of the key in a set slot. It is only recomputed when
+         * hashes are not stored for the key type.
+         */
+        SizeT hash(uint32_t offset) const
+        {
+            if constexpr (Hashes::stores_hashes) {
+                return this->stored_hash(offset);
+            }
+            else {
+                return fold_hash<SizeT>(Hash{}(*this->key(offset)));
+            }
         }
 
         bool is_set(uint32_t offset) const
         {
-            return m_status[offset] == IS_SET;
+            return m_control.is_set(offset);
         }
 
         bool is_empty(uint32_t offset) const
         {
-            return m_status[offset] == IS_EMPTY;
+            return m_control.is_empty(offset);
         }
 
         bool is_dummy(uint32_t offset) const
         {
-            return m_status[offset] == IS_DUMMY;
+            return m_control.is_dummy(offset);
         }
 
         KeyT *key(uint32_t offset) const
         {
-            return (KeyT *)(m_keys + offset * sizeof(KeyT));
+            return (KeyT *)m_keys.ptr() + offset;
         }
 
         ValueT *value(uint32_t offset) const
         {
-            return (ValueT *)(m_values + offset * sizeof(ValueT));
+            return (ValueT *)m_values.ptr() + offset;
         }
 
         template<typename ForwardKeyT, typename ForwardValueT>
-        void store(uint32_t offset, ForwardKeyT &&key, ForwardValueT &&value)
+        void store(uint32_t offset,
+                   uint8_t fragment,
+                   SizeT hash,
+                   ForwardKeyT &&key,
+                   ForwardValueT &&value)
         {
-            assert(m_status[offset] != IS_SET);
-            m_status[offset] = IS_SET;
+            assert(!this->is_set(offset));
+            m_control.set(offset, fragment);
+            this->set_hash(offset, hash);
             new (this->key(offset)) KeyT(std::forward<ForwardKeyT>(key));
             new (this->value(offset))
                 ValueT(std::forward<ForwardValueT>(value));
         }
 
         template<typename ForwardKeyT>
-        void store_without_value(uint32_t offset, ForwardKeyT &&key)
+        void store_without_value(uint32_t offset,
+                                 uint8_t fragment,
+                                 SizeT hash,
+                                 ForwardKeyT &&key)
         {
-            assert(m_status[offset] != IS_SET);
-            m_status[offset] = IS_SET;
+            assert(!this->is_set(offset));
+            m_control.set(offset, fragment);
+            this->set_hash(offset, hash);
             new (this->key(offset)) KeyT(std::forward<ForwardKeyT>(key));
         }
 
-        void set_dummy(uint32_t offset)
+        /**
+         * Destruct the key and value in a set slot. The slot becomes empty
+         * when the item has another empty slot, because then no lookup
+         * probes past this item. Otherwise it has to become a dummy.
+         * Returns true when the slot became empty.
+         */
+        bool remove(uint32_t offset)
+        {
+            destruct(this->key(offset));
+            destruct(this->value(offset));
+            if (m_control.match_empty().has_any()) {
+                m_control.set_empty(offset);
+                return true;
+            }
+            m_control.set_dummy(offset);
+            return false;
+        }
+
+        /**
+         * Start loading the control group and the first keys into the cache.
+         */
+        void prefetch() const
+        {
+            BAS_PREFETCH(&m_control);
+            BAS_PREFETCH(m_keys.ptr());
+        }
+
+        int32_t find_free() const
+        {
+            SlotMask free = m_control.match_free();
+            return free.has_any() ? (int32_t)free.first() : -1;
+        }
+
+        void prepare_rehash_in_place()
+        {
+            m_control.prepare_rehash_in_place();
+        }
+
+        void set_fragment(uint32_t offset, uint8_t fragment)
+        {
+            m_control.set(offset, fragment);
+        }
+
+        /**
+         * Move the key and value of a slot into an empty slot of another
+         * item. The slot in this item becomes empty.
+         */
+        void move_slot(uint32_t offset,
+                       Item &dst,
+                       uint32_t dst_offset,
+                       uint8_t fragment)
+        {
+            dst.store(dst_offset,
+                      fragment,
+                      this->hash(offset),
+                      std::move(*this->key(offset)),
+                      std::move(*this->value(offset)));
+            destruct(this->key(offset));
+            destruct(this->value(offset));
+            m_control.set_empty(offset);
+        }
+
+        /**
+         * Destruct the key and value of a slot that has been moved from and
+         * make it a dummy, so that probing continues past it.
+         */
+        void set_moved_to_dummy(uint32_t offset)
         {
-            assert(m_status[offset] == IS_SET);
-            m_status[offset] = IS_DUMMY;
             destruct(this->key(offset));
             destruct(this->value(offset));
+            m_control.set_dummy(offset);
+        }
+
+        /**
+         * Swap the keys, values and hashes of two slots that are
+         * initialized.
+         */
+        void swap_slot(uint32_t offset, Item &other, uint32_t other_offset)
+        {
+            using std::swap;
+            SizeT hash = this->hash(offset);
+            this->set_hash(offset, other.hash(other_offset));
+            other.set_hash(other_offset, hash);
+            swap(*this->key(offset), *other.key(other_offset));
+            swap(*this->value(offset), *other.value(other_offset));
         }
     };
 
-    using ArrayType = OpenAddressingArray<Item, 1, Allocator>;
+    using ArrayType = OpenAddressingArray<Item, 1, Allocator, SizeT>;
     ArrayType m_array;
+    /* While the map grows incrementally, this is the previous array. All its
+     * items before m_moved_items have been moved to m_array already. The
+     * counters of m_array include the elements that are still in it. */
+    ArrayType *m_old_array = nullptr;
+    SizeT m_moved_items = 0;
+
+    template<typename, typename, typename, typename> friend class FrozenMap;
 
   public:
     Map() = default;
 
+    ~Map()
+    {
+        this->free_old_array();
+    }
+
+    Map(const Map &other)
+        : m_array(other.m_array), m_moved_items(other.m_moved_items)
+    {
+        if (other.m_old_array != nullptr) {
+            m_old_array = this->allocate_old_array(*other.m_old_array);
+        }
+    }
+
+    Map(Map &&other) noexcept
+        : m_array(std::move(other.m_array)),
+          m_old_array(other.m_old_array),
+          m_moved_items(other.m_moved_items)
+    {
+        other.m_old_array = nullptr;
+        other.m_moved_items = 0;
+    }
+
+    Map &operator=(const Map &other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        this->~Map();
+        new (this) Map(other);
+        return *this;
+    }
+
+    Map &operator=(Map &&other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        this->~Map();
+        new (this) Map(std::move(other));
+        return *this;
+    }
+
     /**
      * Allocate memory such that at least min_usable_slots can be added before
      * the map has to grow again.
      */
-    void reserve(uint32_t min_usable_slots)
+    void reserve(SizeT min_usable_slots)
     {
         if (m_array.slots_usable() < min_usable_slots) {
             this->grow(min_usable_slots);
@@ -164,12 +363,108 @@ class Map {
     }
 
     /**
-     * Remove all elements from the map.
+     * Change the fraction of slots that can be used before the map has to
+     * grow. Higher values reduce the memory usage, lower values make probing
+     * faster. The default is 0.5.
+     */
+    void set_max_load_factor(float factor)
+    {
+        m_array.set_max_load_factor(factor);
+        if (m_array.should_grow()) {
+            this->grow(this->size() + 1);
+        }
+    }
+
+    float max_load_factor() const
+    {
+        return m_array.max_load_factor();
+    }
+
+    /**
+     * Change by which factor the number of elements can increase before the
+     * map has to grow again. The default is 2.
+     */
+    void set_growth_factor(float factor)
+    {
+        m_array.set_growth_factor(factor);
+    }
+
+    float growth_factor() const
+    {
+        return m_array.growth_factor();
+    }
+
+    /**
+     * Allow the map to use multiple threads to move its elements when it
+     * grows. This shortens the pause of inserts that make large tables grow.
+     * Tables that are small are still grown by one thread. The default is 1.
+     */
+    void set_grow_threads(uint32_t thread_amount)
+    {
+        m_array.set_grow_threads(thread_amount);
+    }
+
+    uint32_t grow_threads() const
+    {
+        return m_array.grow_threads();
+    }
+
+    /**
+     * Spread the work of growing over the insertions and removals that
+     * follow, instead of moving all elements at once. This bounds the
+     * latency of every single insertion, but the old array is kept until
+     * all its elements are moved and lookups have to check both arrays in
+     * the meantime. Maps that are small are still grown at once. The
+     * default is false.
+     */
+    void set_incremental_grow(bool enabled)
+    {
+        m_array.set_incremental_grow(enabled);
+        if (!enabled) {
+            this->finish_incremental_grow();
+        }
+    }
+
+    bool incremental_grow() const
+    {
+        return m_array.incremental_grow();
+    }
+
+    /**
+     * Returns true while elements of an incremental grow still have to be
+     * moved to the new array.
+     */
+    bool is_growing_incrementally() const
+    {
+        return m_old_array != nullptr;
+    }
+
+    /**
+     * Move all elements that remain from an incremental grow to the new
+     * array now.
+     */
+    void finish_incremental_grow()
+    {
+        while (m_old_array != nullptr) {
+            this->move_old_items_step();
+        }
+    }
+
+    /**
+     * Remove all elements from the map. The growth policy is kept.
      */
     void clear()
     {
+        float max_load_factor = m_array.max_load_factor();
+        float growth_factor = m_array.growth_factor();
+        uint32_t grow_threads = m_array.grow_threads();
+        bool incremental_grow = m_array.incremental_grow();
         this->~Map();
         new (this) Map();
+        m_array.set_max_load_factor(max_load_factor);
+        m_array.set_growth_factor(growth_factor);
+        m_array.set_grow_threads(grow_threads);
+        m_array.set_incremental_grow(incremental_grow);
     }
 
     /**
@@ -214,6 +509,35 @@ class Map {
         return this->add__impl(std::move(key), std::move(value));
     }
 
+    /**
+     * Insert multiple key-value-pairs. Keys that exist already keep their
+     * old value. The map grows at most once before the pairs are inserted.
+     * Asserts that both arrays have the same size.
+     */
+    void add_multiple(ArrayRef<KeyT> keys, ArrayRef<ValueT> values)
+    {
+        assert(keys.size() == values.size());
+        this->ensure_can_add_multiple((SizeT)keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            this->add__no_grow(keys[i], values[i]);
+        }
+    }
+
+    /**
+     * Insert multiple new key-value-pairs. The map grows at most once before
+     * the pairs are inserted.
+     * Asserts that none of the keys existed before and that both arrays have
+     * the same size.
+     */
+    void add_multiple_new(ArrayRef<KeyT> keys, ArrayRef<ValueT> values)
+    {
+        assert(keys.size() == values.size());
+        this->ensure_can_add_multiple((SizeT)keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            this->add_new__no_grow(keys[i], values[i]);
+        }
+    }
+
     /**
      * Remove the key from the map.
      * Asserts when the key does not exist in the map.
@@ -221,15 +545,17 @@ class Map {
     void remove(const KeyT &key)
     {
         assert(this->contains(key));
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        this->prepare_modify(key, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.has_key(offset, key)) {
-                item.set_dummy(offset);
-                m_array.update__set_to_dummy();
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                this->remove_from_item(item, (uint32_t)offset);
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     /**
@@ -239,16 +565,18 @@ class Map {
     ValueT pop(const KeyT &key)
     {
         assert(this->contains(key));
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        this->prepare_modify(key, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.has_key(offset, key)) {
-                ValueT value = std::move(*item.value(offset));
-                item.set_dummy(offset);
-                m_array.update__set_to_dummy();
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                ValueT value = std::move(*item.value((uint32_t)offset));
+                this->remove_from_item(item, (uint32_t)offset);
                 return value;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     /**
@@ -256,16 +584,7 @@ class Map {
      */
     bool contains(const KeyT &key) const
     {
-        ITER_SLOTS_BEGIN(key, m_array, const, item, offset)
-        {
-            if (item.is_empty(offset)) {
-                return false;
-            }
-            else if (item.has_key(offset, key)) {
-                return true;
-            }
-        }
-        ITER_SLOTS_END(offset);
+        return this->lookup_ptr(key) != nullptr;
     }
 
     /**
@@ -326,16 +645,8 @@ class Map {
      */
     const ValueT *lookup_ptr(const KeyT &key) const
     {
-        ITER_SLOTS_BEGIN(key, m_array, const, item, offset)
-        {
-            if (item.is_empty(offset)) {
-                return nullptr;
-            }
-            else if (item.has_key(offset, key)) {
-                return item.value(offset);
-            }
-        }
-        ITER_SLOTS_END(offset);
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        return this->lookup_ptr__impl(key, hash);
     }
 
     /**
@@ -355,6 +666,41 @@ class Map {
         return const_cast<ValueT *>(const_this->lookup_ptr(key));
     }
 
+    /**
+     * Do lookup_ptr for many keys at once. This is faster when the map does
+     * not fit into the cache, because the items of the next keys are
+     * prefetched while the current key is searched. That way, multiple cache
+     * misses are resolved at the same time.
+     */
+    void lookup_ptr_batch(ArrayRef<KeyT> keys,
+                          MutableArrayRef<const ValueT *> r_values) const
+    {
+        assert(keys.size() == r_values.size());
+        SizeT hashes[prefetch_distance];
+        for (size_t i = 0; i < keys.size() + prefetch_distance; i++) {
+            if (i >= prefetch_distance) {
+                size_t done = i - prefetch_distance;
+                r_values[done] = this->lookup_ptr__impl(
+                    keys[done], hashes[done % prefetch_distance]);
+            }
+            if (i < keys.size()) {
+                SizeT hash = fold_hash<SizeT>(Hash{}(keys[i]));
+                hashes[i % prefetch_distance] = hash;
+                m_array.item(hash & m_array.item_mask()).prefetch();
+            }
+        }
+    }
+
+    void lookup_ptr_batch(ArrayRef<KeyT> keys,
+                          MutableArrayRef<ValueT *> r_values)
+    {
+        const Map *const_this = this;
+        const_this->lookup_ptr_batch(
+            keys,
+            MutableArrayRef<const ValueT *>((const ValueT **)r_values.begin(),
+                                            r_values.size()));
+    }
+
     ValueT &lookup(const KeyT &key)
     {
         const Map *const_this = this;
@@ -395,33 +741,52 @@ class Map {
     /**
      * Get the number of elements in the map.
      */
-    uint32_t size() const
+    SizeT size() const
     {
         return m_array.slots_set();
     }
 
     template<typename FuncT> void foreach_item(const FuncT &func) const
     {
-        for (const Item &item : m_array) {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                if (item.is_set(offset)) {
-                    const KeyT &key = *item.key(offset);
-                    const ValueT &value = *item.value(offset);
-                    func(key, value);
-                }
-            }
+        foreach_item_in_array(m_array, func);
+        if (m_old_array != nullptr) {
+            foreach_item_in_array(*m_old_array, func);
         }
     }
 
+    /**
+     * Compute statistics about the memory usage and the probe lengths. Every
+     * key is hashed again, so this should not be used in performance
+     * critical code.
+     */
+    HashTableStats compute_stats() const
+    {
+        HashTableStats stats = m_array.compute_base_stats();
+        foreach_item_in_array(
+            m_array, [&](const KeyT &key, const ValueT & /*value*/) {
+                stats.add_probe_length(count_collisions(m_array, key));
+            });
+        if (m_old_array != nullptr) {
+            stats.bytes_allocated +=
+                m_old_array->compute_base_stats().bytes_allocated;
+            foreach_item_in_array(
+                *m_old_array, [&](const KeyT &key, const ValueT & /*value*/) {
+                    stats.add_probe_length(
+                        count_collisions(*m_old_array, key));
+                });
+        }
+        return stats;
+    }
+
     void print_table() const
     {
         std::cout << "Hash Table:\n";
         std::cout << "  Size: " << m_array.slots_set() << '\n';
         std::cout << "  Capacity: " << m_array.slots_total() << '\n';
-        uint32_t item_index = 0;
+        SizeT item_index = 0;
         for (const Item &item : m_array) {
             std::cout << "   Item: " << item_index++ << '\n';
-            for (uint32_t offset = 0; offset < 4; offset++) {
+            for (uint32_t offset = 0; offset < ControlGroup::size; offset++) {
                 std::cout << "    " << offset << " \t";
                 if (item.is_empty(offset)) {
                     std::cout << "    <empty>\n";
@@ -429,7 +794,7 @@ class Map {
                 else if (item.is_set(offset)) {
                     const KeyT &key = *item.key(offset);
                     const ValueT &value = *item.value(offset);
-                    uint32_t collisions = this->count_collisions(key);
+                    uint32_t collisions = count_collisions(m_array, key);
                     std::cout << "    " << key << " -> " << value
                               << "  \t Collisions: " << collisions << '\n';
                 }
@@ -443,10 +808,10 @@ class Map {
     template<typename SubIterator> class BaseIterator {
       protected:
         const Map *m_map;
-        uint32_t m_slot;
+        SizeT m_slot;
 
       public:
-        BaseIterator(const Map *map, uint32_t slot) : m_map(map), m_slot(slot)
+        BaseIterator(const Map *map, SizeT slot) : m_map(map), m_slot(slot)
         {
         }
 
@@ -474,22 +839,21 @@ class Map {
 
         SubIterator end() const
         {
-            return SubIterator(m_map, m_map->m_array.slots_total());
+            return SubIterator(m_map, m_map->slots_end());
         }
     };
 
     class KeyIterator final : public BaseIterator<KeyIterator> {
       public:
-        KeyIterator(const Map *map, uint32_t slot)
+        KeyIterator(const Map *map, SizeT slot)
             : BaseIterator<KeyIterator>(map, slot)
         {
         }
 
         const KeyT &operator*() const
         {
-            uint32_t item_index = this->m_slot >> OFFSET_SHIFT;
-            uint32_t offset = this->m_slot & OFFSET_MASK;
-            const Item &item = this->m_map->m_array.item(item_index);
+            uint32_t offset = (uint32_t)(this->m_slot & OFFSET_MASK);
+            const Item &item = this->m_map->item_of_slot(this->m_slot);
             assert(item.is_set(offset));
             return *item.key(offset);
         }
@@ -497,16 +861,15 @@ class Map {
 
     class ValueIterator final : public BaseIterator<ValueIterator> {
       public:
-        ValueIterator(const Map *map, uint32_t slot)
+        ValueIterator(const Map *map, SizeT slot)
             : BaseIterator<ValueIterator>(map, slot)
         {
         }
 
         ValueT &operator*() const
         {
-            uint32_t item_index = this->m_slot >> OFFSET_SHIFT;
-            uint32_t offset = this->m_slot & OFFSET_MASK;
-            const Item &item = this->m_map->m_array.item(item_index);
+            uint32_t offset = (uint32_t)(this->m_slot & OFFSET_MASK);
+            const Item &item = this->m_map->item_of_slot(this->m_slot);
             assert(item.is_set(offset));
             return *item.value(offset);
         }
@@ -514,7 +877,7 @@ class Map {
 
     class ItemIterator final : public BaseIterator<ItemIterator> {
       public:
-        ItemIterator(const Map *map, uint32_t slot)
+        ItemIterator(const Map *map, SizeT slot)
             : BaseIterator<ItemIterator>(map, slot)
         {
         }
@@ -533,9 +896,8 @@ class Map {
 
         UserItem operator*() const
         {
-            uint32_t item_index = this->m_slot >> OFFSET_SHIFT;
-            uint32_t offset = this->m_slot & OFFSET_MASK;
-            const Item &item = this->m_map->m_array.item(item_index);
+            uint32_t offset = (uint32_t)(this->m_slot & OFFSET_MASK);
+            const Item &item = this->m_map->item_of_slot(this->m_slot);
             assert(item.is_set(offset));
             return {*item.key(offset), *item.value(offset)};
         }
@@ -569,47 +931,214 @@ class Map {
     }
 
   private:
-    uint32_t next_slot(uint32_t slot) const
+    const ValueT *lookup_ptr__impl(const KeyT &key, SizeT hash) const
+    {
+        const ValueT *value = lookup_ptr_in_array(m_array, key, hash);
+        if (BAS_UNLIKELY(m_old_array != nullptr) && value == nullptr) {
+            value = lookup_ptr_in_array(*m_old_array, key, hash);
+        }
+        return value;
+    }
+
+    /**
+     * Probe in the given array. It is a template, so that frozen maps can
+     * probe in items that are not owned by an OpenAddressingArray.
+     */
+    template<typename ArrayT>
+    static const ValueT *lookup_ptr_in_array(const ArrayT &array,
+                                             const KeyT &key,
+                                             SizeT hash)
+    {
+        ITER_ITEMS_BEGIN(hash, array, const, item, fragment)
+        {
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                return item.value((uint32_t)offset);
+            }
+            if (item.find_empty() >= 0) {
+                return nullptr;
+            }
+        }
+        ITER_ITEMS_END;
+    }
+
+    /**
+     * Slot indices of the old array follow the ones of the current array, so
+     * that iterators visit both while the map grows incrementally.
+     */
+    SizeT slots_end() const
+    {
+        SizeT end = m_array.slots_total();
+        if (m_old_array != nullptr) {
+            end += m_old_array->slots_total();
+        }
+        return end;
+    }
+
+    const Item &item_of_slot(SizeT slot) const
+    {
+        SizeT item_index = slot >> OFFSET_SHIFT;
+        if (item_index < m_array.item_amount()) {
+            return m_array.item(item_index);
+        }
+        return m_old_array->item(item_index - m_array.item_amount());
+    }
+
+    SizeT next_slot(SizeT slot) const
     {
-        for (; slot < m_array.slots_total(); slot++) {
-            uint32_t item_index = slot >> OFFSET_SHIFT;
-            uint32_t offset = slot & OFFSET_MASK;
-            const Item &item = m_array.item(item_index);
-            if (item.is_set(offset)) {
+        SizeT end = this->slots_end();
+        for (; slot < end; slot++) {
+            uint32_t offset = (uint32_t)(slot & OFFSET_MASK);
+            if (this->item_of_slot(slot).is_set(offset)) {
                 return slot;
             }
         }
         return slot;
     }
 
-    uint32_t count_collisions(const KeyT &key) const
+    template<typename FuncT>
+    static void foreach_item_in_array(const ArrayType &array,
+                                      const FuncT &func)
+    {
+        for (const Item &item : array) {
+            for (uint32_t offset : item.set_slots()) {
+                const KeyT &key = *item.key(offset);
+                const ValueT &value = *item.value(offset);
+                func(key, value);
+            }
+        }
+    }
+
+    static uint32_t count_collisions(const ArrayType &array, const KeyT &key)
     {
         uint32_t collisions = 0;
-        ITER_SLOTS_BEGIN(key, m_array, const, item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        ITER_ITEMS_BEGIN(hash, array, const, item, fragment)
         {
-            if (item.is_empty(offset) || item.has_key(offset, key)) {
+            if (item.find_key(fragment, hash, key) >= 0 ||
+                item.find_empty() >= 0) {
                 return collisions;
             }
             collisions++;
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     void ensure_can_add()
     {
+        if (BAS_UNLIKELY(m_old_array != nullptr)) {
+            this->move_old_items_step();
+        }
         if (BAS_UNLIKELY(m_array.should_grow())) {
-            this->grow(this->size() + 1);
+            if (m_array.should_remove_dummies_instead_of_grow()) {
+                this->rehash_in_place();
+            }
+            else {
+                this->grow(m_array.slots_usable_after_grow());
+            }
+        }
+    }
+
+    /**
+     * Make sure that the given amount of elements can be added without
+     * checking whether the map has to grow before every element. When the
+     * map grows, it grows at least as much as when a single element is
+     * added, so that repeated bulk insertions stay amortized.
+     */
+    void ensure_can_add_multiple(SizeT amount)
+    {
+        if (!m_array.can_add_without_grow(amount)) {
+            this->grow(std::max(m_array.slots_usable_after_grow(),
+                                this->size() + amount));
+        }
+    }
+
+    void remove_from_item(Item &item, uint32_t offset)
+    {
+        if (item.remove(offset)) {
+            m_array.update__set_to_empty();
+        }
+        else {
+            m_array.update__set_to_dummy();
+        }
+        if (BAS_UNLIKELY(m_old_array != nullptr)) {
+            this->move_old_items_step();
+        }
+    }
+
+    /**
+     * Remove all dummies without allocating a new array. First, all set
+     * slots are marked as dummies and all dummies become empty. Then every
+     * marked element is moved to the first item in its probe sequence that
+     * has a free slot. If that slot is still marked, the two elements are
+     * swapped and the element that is now in the current slot is processed
+     * next.
+     */
+    BAS_NOINLINE void rehash_in_place()
+    {
+        this->finish_incremental_grow();
+        for (Item &item : m_array) {
+            item.prepare_rehash_in_place();
+        }
+        for (Item &item : m_array) {
+            for (uint32_t offset = 0; offset < ControlGroup::size; offset++) {
+                while (item.is_dummy(offset)) {
+                    this->rehash_slot_in_place(item, offset);
+                }
+            }
+        }
+        m_array.update__dummies_to_empty();
+    }
+
+    void rehash_slot_in_place(Item &item, uint32_t offset)
+    {
+        ITER_ITEMS_BEGIN(item.hash(offset), m_array, , dst, fragment)
+        {
+            int32_t dst_offset = dst.find_free();
+            if (dst_offset >= 0) {
+                if (&dst == &item) {
+                    item.set_fragment(offset, fragment);
+                }
+                else if (dst.is_empty((uint32_t)dst_offset)) {
+                    item.move_slot(
+                        offset, dst, (uint32_t)dst_offset, fragment);
+                }
+                else {
+                    item.swap_slot(offset, dst, (uint32_t)dst_offset);
+                    dst.set_fragment((uint32_t)dst_offset, fragment);
+                }
+                return;
+            }
         }
+        ITER_ITEMS_END;
     }
 
-    BAS_NOINLINE void grow(uint32_t min_usable_slots)
+    BAS_NOINLINE void grow(SizeT min_usable_slots)
     {
+        this->finish_incremental_grow();
         ArrayType new_array = m_array.init_reserved(min_usable_slots);
-        for (Item &old_item : m_array) {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                if (old_item.is_set(offset)) {
+        if (m_array.incremental_grow() &&
+            this->size() >= min_size_for_incremental_grow) {
+            m_old_array = this->allocate_old_array(std::move(m_array));
+            m_moved_items = 0;
+            m_array = std::move(new_array);
+            return;
+        }
+        if (should_grow_in_parallel(m_array)) {
+            auto move_with_probing = [&](Item &item, uint32_t offset) {
+                this->add_after_grow(*item.key(offset),
+                                     *item.value(offset),
+                                     item.hash(offset),
+                                     new_array);
+            };
+            parallel_grow(m_array, new_array, move_with_probing);
+        }
+        else {
+            for (Item &old_item : m_array) {
+                for (uint32_t offset : old_item.set_slots()) {
                     this->add_after_grow(*old_item.key(offset),
                                          *old_item.value(offset),
+                                         old_item.hash(offset),
                                          new_array);
                 }
             }
@@ -617,16 +1146,94 @@ class Map {
         m_array = std::move(new_array);
     }
 
-    void add_after_grow(KeyT &key, ValueT &value, ArrayType &new_array)
+    /**
+     * Move the elements of the next few items of the old array to the
+     * current array. The old array is freed after its last item.
+     */
+    void move_old_items_step()
+    {
+        SizeT end = std::min<SizeT>(m_moved_items + items_moved_per_step,
+                                    m_old_array->item_amount());
+        for (; m_moved_items < end; m_moved_items++) {
+            Item &item = m_old_array->item(m_moved_items);
+            for (uint32_t offset : item.set_slots()) {
+                this->move_old_slot(item, offset);
+            }
+        }
+        if (m_moved_items == m_old_array->item_amount()) {
+            this->free_old_array();
+        }
+    }
+
+    void move_old_slot(Item &item, uint32_t offset)
+    {
+        this->add_after_grow(*item.key(offset),
+                             *item.value(offset),
+                             item.hash(offset),
+                             m_array);
+        item.set_moved_to_dummy(offset);
+    }
+
+    /**
+     * Has to be called before an existing key is modified or removed. When
+     * the map grows incrementally and the key is still in the old array, it
+     * is moved to the current array first. Then only the current array has
+     * to be searched.
+     */
+    void prepare_modify(const KeyT &key, SizeT hash)
+    {
+        if (m_old_array == nullptr) {
+            return;
+        }
+        ITER_ITEMS_BEGIN(hash, (*m_old_array), , item, fragment)
+        {
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                this->move_old_slot(item, (uint32_t)offset);
+                return;
+            }
+            if (item.find_empty() >= 0) {
+                return;
+            }
+        }
+        ITER_ITEMS_END;
+    }
+
+    static ArrayType *allocate_old_array(ArrayType array)
+    {
+        void *buffer = Allocator().allocate(sizeof(ArrayType),
+                                            alignof(ArrayType));
+        return new (buffer) ArrayType(std::move(array));
+    }
+
+    void free_old_array()
     {
-        ITER_SLOTS_BEGIN(key, new_array, , item, offset)
+        if (m_old_array != nullptr) {
+            m_old_array->~ArrayType();
+            Allocator().free(m_old_array);
+            m_old_array = nullptr;
+            m_moved_items = 0;
+        }
+    }
+
+    void add_after_grow(KeyT &key,
+                        ValueT &value,
+                        SizeT hash,
+                        ArrayType &new_array)
+    {
+        ITER_ITEMS_BEGIN(hash, new_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset, std::move(key), std::move(value));
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
+                           std::move(key),
+                           std::move(value));
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardKeyT, typename ForwardValueT>
@@ -648,40 +1255,62 @@ class Map {
     bool add__impl(ForwardKeyT &&key, ForwardValueT &&value)
     {
         this->ensure_can_add();
+        return this->add__no_grow(std::forward<ForwardKeyT>(key),
+                                  std::forward<ForwardValueT>(value));
+    }
 
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+    template<typename ForwardKeyT, typename ForwardValueT>
+    bool add__no_grow(ForwardKeyT &&key, ForwardValueT &&value)
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        this->prepare_modify(key, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset,
+            if (item.find_key(fragment, hash, key) >= 0) {
+                return false;
+            }
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
                            std::forward<ForwardKeyT>(key),
                            std::forward<ForwardValueT>(value));
                 m_array.update__empty_to_set();
                 return true;
             }
-            else if (item.has_key(offset, key)) {
-                return false;
-            }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardKeyT, typename ForwardValueT>
     void add_new__impl(ForwardKeyT &&key, ForwardValueT &&value)
     {
-        assert(!this->contains(key));
         this->ensure_can_add();
+        this->add_new__no_grow(std::forward<ForwardKeyT>(key),
+                               std::forward<ForwardValueT>(value));
+    }
 
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+    template<typename ForwardKeyT, typename ForwardValueT>
+    void add_new__no_grow(ForwardKeyT &&key, ForwardValueT &&value)
+    {
+        assert(!this->contains(key));
+
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset,
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
                            std::forward<ForwardKeyT>(key),
                            std::forward<ForwardValueT>(value));
                 m_array.update__empty_to_set();
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardKeyT,
@@ -699,21 +1328,27 @@ class Map {
 
         this->ensure_can_add();
 
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        this->prepare_modify(key, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                ValueT *value_ptr = item.value((uint32_t)offset);
+                return modify_value(value_ptr);
+            }
+            offset = item.find_empty();
+            if (offset >= 0) {
                 m_array.update__empty_to_set();
-                item.store_without_value(offset,
+                item.store_without_value((uint32_t)offset,
+                                         fragment,
+                                         hash,
                                          std::forward<ForwardKeyT>(key));
-                ValueT *value_ptr = item.value(offset);
+                ValueT *value_ptr = item.value((uint32_t)offset);
                 return create_value(value_ptr);
             }
-            else if (item.has_key(offset, key)) {
-                ValueT *value_ptr = item.value(offset);
-                return modify_value(value_ptr);
-            }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardKeyT, typename CreateValueF>
@@ -722,23 +1357,30 @@ class Map {
     {
         this->ensure_can_add();
 
-        ITER_SLOTS_BEGIN(key, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(key));
+        this->prepare_modify(key, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(
-                    offset, std::forward<ForwardKeyT>(key), create_value());
-                m_array.update__empty_to_set();
-                return *item.value(offset);
+            int32_t offset = item.find_key(fragment, hash, key);
+            if (offset >= 0) {
+                return *item.value((uint32_t)offset);
             }
-            else if (item.has_key(offset, key)) {
-                return *item.value(offset);
+            offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
+                           std::forward<ForwardKeyT>(key),
+                           create_value());
+                m_array.update__empty_to_set();
+                return *item.value((uint32_t)offset);
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 };
 
-#undef ITER_SLOTS_BEGIN
-#undef ITER_SLOTS_END
+#undef ITER_ITEMS_BEGIN
+#undef ITER_ITEMS_END
 
 }  // namespace bas
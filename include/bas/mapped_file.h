@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * A mapped file makes the content of a file accessible as read-only memory.
+ * On systems with mmap, the pages are shared with all other processes that
+ * map the same file and are only loaded from disk when they are accessed.
+ * Elsewhere, the whole file is read into a buffer.
+ *
+ * The buffer is aligned to at least 64 bytes, so that data structures that
+ * have been written to the file can be used in place.
+ */
+
+#include <utility>
+
+#include "array_ref.h"
+#include "utildefines.h"
+
+namespace bas {
+
+class MappedFile : NonCopyable {
+  private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+
+  public:
+    MappedFile() = default;
+
+    /**
+     * Map the file at the given path. Use is_open to check whether that
+     * worked. Empty files cannot be mapped.
+     */
+    explicit MappedFile(const char *path);
+
+    ~MappedFile()
+    {
+        this->close();
+    }
+
+    MappedFile(MappedFile &&other) noexcept
+        : m_data(other.m_data), m_size(other.m_size)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        this->~MappedFile();
+        new (this) MappedFile(std::move(other));
+        return *this;
+    }
+
+    bool is_open() const
+    {
+        return m_data != nullptr;
+    }
+
+    const char *data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    ArrayRef<char> buffer() const
+    {
+        return ArrayRef<char>(m_data, m_size);
+    }
+
+    /**
+     * Unmap the file. Pointers into the buffer become invalid.
+     */
+    void close();
+};
+
+}  // namespace bas
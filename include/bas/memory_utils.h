@@ -1,12 +1,47 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <type_traits>
 
 #include "utildefines.h"
 
 namespace bas {
 
+/**
+ * A type is trivially relocatable when moving an object to a new address
+ * and destructing the old one has the same effect as copying its bytes.
+ * Most types are, unless they store pointers into themselves. The
+ * containers of this library are not, because they point into their inline
+ * buffers.
+ *
+ * Trivially copyable types are detected automatically. Other types opt in
+ * by specializing this trait, or with a member
+ *
+ *   static constexpr bool trivially_relocatable = true;
+ */
+template<typename T, typename = void>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+};
+
+template<typename T>
+struct is_trivially_relocatable<
+    T,
+    std::enable_if_t<!std::is_trivially_copyable<T>::value &&
+                     (sizeof(T::trivially_relocatable) > 0)>>
+    : std::integral_constant<bool, T::trivially_relocatable> {
+};
+
+template<typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>>
+    : is_trivially_relocatable<Deleter> {
+};
+
+template<typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {
+};
+
 using std::copy;
 using std::copy_n;
 using std::uninitialized_copy;
@@ -50,14 +85,30 @@ template<typename T> void move_n(T *src, size_t n, T *dst)
 
 template<typename T> void uninitialized_relocate(T *src, T *dst)
 {
-    new (dst) T(std::move(*src));
-    destruct(src);
+    if constexpr (is_trivially_relocatable<T>::value) {
+        memcpy((void *)dst, (const void *)src, sizeof(T));
+    }
+    else {
+        new (dst) T(std::move(*src));
+        destruct(src);
+    }
 }
 
+/**
+ * Move n objects to uninitialized memory and destruct the source objects.
+ * The ranges must not overlap.
+ */
 template<typename T> void uninitialized_relocate_n(T *src, size_t n, T *dst)
 {
-    uninitialized_move_n(src, n, dst);
-    destruct_n(src, n);
+    if constexpr (is_trivially_relocatable<T>::value) {
+        if (n > 0) {
+            memcpy((void *)dst, (const void *)src, sizeof(T) * n);
+        }
+    }
+    else {
+        uninitialized_move_n(src, n, dst);
+        destruct_n(src, n);
+    }
 }
 
 template<typename T> void relocate(T *src, T *dst)
@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+
 #include "array_ref.h"
 #include "linear_allocator.h"
 #include "map.h"
@@ -93,10 +96,14 @@ template<typename KeyT, typename ValueT, uint32_t N = 4> class MultiMap {
         this->add_multiple__impl(std::move(key), values);
     }
 
+    /**
+     * Add all values of another multimap. The key map grows at most once.
+     */
     template<uint32_t OtherN>
     void add_multiple(const MultiMap<KeyT, ValueT, OtherN> &other)
     {
         assert(this != &other);
+        m_map.reserve(m_map.size() + other.key_amount());
         other.foreach_item([&](const KeyT &key, ArrayRef<ValueT> values) {
             this->add_multiple(key, values);
         });
@@ -131,6 +138,15 @@ template<typename KeyT, typename ValueT, uint32_t N = 4> class MultiMap {
         return m_map.keys();
     }
 
+    /**
+     * Compute statistics of the table that maps keys to their values. The
+     * memory that stores the values is not included.
+     */
+    HashTableStats compute_stats() const
+    {
+        return m_map.compute_stats();
+    }
+
     template<typename FuncT> void foreach_value(const FuncT &func) const
     {
         for (const Entry &entry : m_map.values()) {
@@ -161,12 +177,49 @@ template<typename KeyT, typename ValueT, uint32_t N = 4> class MultiMap {
     }
 
   private:
+    /**
+     * Looks up the key only once and grows the array of values at most once,
+     * instead of adding the values one by one.
+     */
     template<typename ForwardKeyT>
     void add_multiple__impl(ForwardKeyT &&key, ArrayRef<ValueT> values)
     {
-        for (const ValueT &value : values) {
-            this->add(std::forward<ForwardKeyT>(key), value);
+        if (values.size() == 0) {
+            return;
         }
+        uint32_t amount = (uint32_t)values.size();
+        m_map.add_or_modify(
+            std::forward<ForwardKeyT>(key),
+            /* Insert new key with all values. */
+            [&](Entry *r_entry) {
+                ValueT *array = (ValueT *)m_allocator.allocate(
+                    sizeof(ValueT) * amount, alignof(ValueT));
+                std::uninitialized_copy_n(values.begin(), amount, array);
+                r_entry->ptr = array;
+                r_entry->length = amount;
+                r_entry->capacity = amount;
+                return true;
+            },
+            /* Append values to existing key. */
+            [&](Entry *entry) {
+                if (entry->capacity - entry->length < amount) {
+                    this->grow_entry(*entry, entry->length + amount);
+                }
+                std::uninitialized_copy_n(
+                    values.begin(), amount, entry->ptr + entry->length);
+                entry->length += amount;
+                return false;
+            });
+    }
+
+    void grow_entry(Entry &entry, uint32_t min_capacity)
+    {
+        uint32_t new_capacity = std::max(min_capacity, entry.capacity * 2);
+        ValueT *new_array = (ValueT *)m_allocator.allocate(
+            sizeof(ValueT) * new_capacity, alignof(ValueT));
+        uninitialized_relocate_n(entry.ptr, entry.length, new_array);
+        entry.ptr = new_array;
+        entry.capacity = new_capacity;
     }
 
     template<typename ForwardKeyT, typename ForwardValueT>
@@ -193,18 +246,11 @@ template<typename KeyT, typename ValueT, uint32_t N = 4> class MultiMap {
                     entry->length++;
                 }
                 else {
-                    uint32_t old_capacity = entry->capacity;
-                    assert(old_capacity >= 1);
-                    uint32_t new_capacity = old_capacity * 2;
-                    ValueT *new_array = (ValueT *)m_allocator.allocate(
-                        sizeof(ValueT) * new_capacity, alignof(ValueT));
-                    uninitialized_relocate_n(
-                        entry->ptr, old_capacity, new_array);
-                    new (new_array + entry->length)
+                    assert(entry->capacity >= 1);
+                    this->grow_entry(*entry, entry->capacity * 2);
+                    new (entry->ptr + entry->length)
                         ValueT(std::forward<ForwardValueT>(value));
-                    entry->ptr = new_array;
                     entry->length++;
-                    entry->capacity = new_capacity;
                 }
                 return false;
             });
@@ -6,15 +6,23 @@
  *   - Allocation and deallocation of the open addressing array.
  *   - Optional small object optimization.
  *   - Keeps track of how many elements and dummies are in the table.
+ *   - The growth policy, consisting of the max load factor, the growth
+ *     factor, the number of threads that move elements when growing and
+ *     whether growing is done incrementally. All of them can be changed per
+ *     instance.
+ *   - The integer type used for sizes and hashes. Tables that might grow
+ *     beyond 2^31 slots, or that benefit from 64 bit hashes, use uint64_t.
  *
  * The nice thing about this abstraction is that it does not get in the way of
  * any performance optimizations. The data that is actually stored in the table
  * is still fully defined by the actual hash table implementation.
  */
 
+#include <algorithm>
 #include <cmath>
 
 #include "allocator.h"
+#include "hash_table_stats.h"
 #include "memory_utils.h"
 #include "utildefines.h"
 
@@ -26,11 +34,21 @@ namespace bas {
 
 template<typename Item,
          uint32_t ItemsInSmallStorage = 1,
-         typename Allocator = RawAllocator>
+         typename Allocator = RawAllocator,
+         typename SizeT = uint32_t>
 class OpenAddressingArray {
+    static_assert(std::is_same<SizeT, uint32_t>::value ||
+                      std::is_same<SizeT, uint64_t>::value,
+                  "Only 32 and 64 bit sizes are supported.");
+
   private:
     static constexpr uint32_t slots_per_item = Item::slots_per_item;
-    static constexpr float max_load_factor = 0.5f;
+
+  public:
+    static constexpr float default_max_load_factor = 0.5f;
+    static constexpr float default_growth_factor = 2.0f;
+
+  private:
 
     /* Invariants:
      *   2^m_item_exponent = m_item_amount
@@ -43,32 +61,50 @@ class OpenAddressingArray {
      * inlined storage. */
     Item *m_items;
     /* Number of items in the hash table. Must be a power of two. */
-    uint32_t m_item_amount;
+    SizeT m_item_amount;
     /* Exponent of the current item amount. */
     uint8_t m_item_exponent;
     /* Number of elements that could be stored in the table when the load
      * factor is 1. */
-    uint32_t m_slots_total;
+    SizeT m_slots_total;
     /* Number of elements that are not empty. */
-    uint32_t m_slots_set_or_dummy;
+    SizeT m_slots_set_or_dummy;
     /* Number of dummy entries. */
-    uint32_t m_slots_dummy;
+    SizeT m_slots_dummy;
     /* Max number of slots that can be non-empty according to the load factor.
      */
-    uint32_t m_slots_usable;
+    SizeT m_slots_usable;
     /* Can be used to map a hash value into the range of valid slot indices. */
-    uint32_t m_slot_mask;
+    SizeT m_slot_mask;
+    /* Fraction of the slots that can be non-empty before the array grows. */
+    float m_max_load_factor;
+    /* The number of elements in the array can increase by this factor until
+     * the next grow is necessary. */
+    float m_growth_factor;
+    /* Number of threads that may be used to move the elements into a new
+     * array when the table grows. */
+    uint32_t m_grow_threads = 1;
+    /* When true, the hash table moves its elements to the new array over
+     * multiple operations when it grows. */
+    bool m_incremental_grow = false;
     Allocator m_allocator;
     AlignedBuffer<sizeof(Item) * ItemsInSmallStorage, alignof(Item)>
         m_local_storage;
 
   public:
-    explicit OpenAddressingArray(uint8_t item_exponent = 0)
+    explicit OpenAddressingArray(
+        uint8_t item_exponent = 0,
+        float max_load_factor = default_max_load_factor,
+        float growth_factor = default_growth_factor)
     {
-        m_slots_total = ((uint32_t)1 << item_exponent) * slots_per_item;
+        assert(max_load_factor > 0.0f && max_load_factor < 1.0f);
+        assert(growth_factor > 1.0f);
+        m_max_load_factor = max_load_factor;
+        m_growth_factor = growth_factor;
+        m_slots_total = ((SizeT)1 << item_exponent) * slots_per_item;
         m_slots_set_or_dummy = 0;
         m_slots_dummy = 0;
-        m_slots_usable = (uint32_t)((float)m_slots_total * max_load_factor);
+        m_slots_usable = this->compute_slots_usable();
         m_slot_mask = m_slots_total - 1;
         m_item_amount = m_slots_total / slots_per_item;
         m_item_exponent = item_exponent;
@@ -78,10 +114,10 @@ class OpenAddressingArray {
         }
         else {
             m_items = (Item *)m_allocator.allocate(
-                (uint32_t)sizeof(Item) * m_item_amount, alignof(Item));
+                sizeof(Item) * (size_t)m_item_amount, alignof(Item));
         }
 
-        for (uint32_t i = 0; i < m_item_amount; i++) {
+        for (SizeT i = 0; i < m_item_amount; i++) {
             new (m_items + i) Item();
         }
     }
@@ -89,7 +125,7 @@ class OpenAddressingArray {
     ~OpenAddressingArray()
     {
         if (m_items != nullptr) {
-            for (uint32_t i = 0; i < m_item_amount; i++) {
+            for (SizeT i = 0; i < m_item_amount; i++) {
                 m_items[i].~Item();
             }
             if (!this->is_in_small_storage()) {
@@ -105,6 +141,10 @@ class OpenAddressingArray {
         m_slots_dummy = other.m_slots_dummy;
         m_slots_usable = other.m_slots_usable;
         m_slot_mask = other.m_slot_mask;
+        m_max_load_factor = other.m_max_load_factor;
+        m_growth_factor = other.m_growth_factor;
+        m_grow_threads = other.m_grow_threads;
+        m_incremental_grow = other.m_incremental_grow;
         m_item_amount = other.m_item_amount;
         m_item_exponent = other.m_item_exponent;
 
@@ -113,7 +153,7 @@ class OpenAddressingArray {
         }
         else {
             m_items = (Item *)m_allocator.allocate(
-                sizeof(Item) * m_item_amount, alignof(Item));
+                sizeof(Item) * (size_t)m_item_amount, alignof(Item));
         }
 
         uninitialized_copy_n(other.m_items, m_item_amount, m_items);
@@ -126,6 +166,10 @@ class OpenAddressingArray {
         m_slots_dummy = other.m_slots_dummy;
         m_slots_usable = other.m_slots_usable;
         m_slot_mask = other.m_slot_mask;
+        m_max_load_factor = other.m_max_load_factor;
+        m_growth_factor = other.m_growth_factor;
+        m_grow_threads = other.m_grow_threads;
+        m_incremental_grow = other.m_incremental_grow;
         m_item_amount = other.m_item_amount;
         m_item_exponent = other.m_item_exponent;
         if (other.is_in_small_storage()) {
@@ -138,7 +182,10 @@ class OpenAddressingArray {
 
         other.m_items = nullptr;
         other.~OpenAddressingArray();
-        new (&other) OpenAddressingArray();
+        new (&other)
+            OpenAddressingArray(0, m_max_load_factor, m_growth_factor);
+        other.m_grow_threads = m_grow_threads;
+        other.m_incremental_grow = m_incremental_grow;
     }
 
     OpenAddressingArray &operator=(const OpenAddressingArray &other)
@@ -163,21 +210,24 @@ class OpenAddressingArray {
 
     /* Prepare a new array that can hold a minimum of min_usable_slots
      * elements. All entries are empty. */
-    OpenAddressingArray init_reserved(uint32_t min_usable_slots) const
+    OpenAddressingArray init_reserved(SizeT min_usable_slots) const
     {
-        float min_total_slots = (float)min_usable_slots / max_load_factor;
-        uint32_t min_total_items = (uint32_t)std::ceil(min_total_slots /
-                                                       (float)slots_per_item);
+        double min_total_slots = (double)min_usable_slots / m_max_load_factor;
+        SizeT min_total_items = (SizeT)std::ceil(min_total_slots /
+                                                 (double)slots_per_item);
         uint8_t item_exponent = (uint8_t)log2_ceil_u(min_total_items);
-        OpenAddressingArray grown(item_exponent);
+        OpenAddressingArray grown(
+            item_exponent, m_max_load_factor, m_growth_factor);
         grown.m_slots_set_or_dummy = this->slots_set();
+        grown.m_grow_threads = m_grow_threads;
+        grown.m_incremental_grow = m_incremental_grow;
         return grown;
     }
 
     /**
      * Amount of items in the array times the number of slots per item.
      */
-    uint32_t slots_total() const
+    SizeT slots_total() const
     {
         return m_slots_total;
     }
@@ -186,7 +236,7 @@ class OpenAddressingArray {
      * Amount of slots that are initialized with some value that is not empty
      * or dummy.
      */
-    uint32_t slots_set() const
+    SizeT slots_set() const
     {
         return m_slots_set_or_dummy - m_slots_dummy;
     }
@@ -194,11 +244,87 @@ class OpenAddressingArray {
     /**
      * Amount of slots that can be used before the array should grow.
      */
-    uint32_t slots_usable() const
+    SizeT slots_usable() const
     {
         return m_slots_usable;
     }
 
+    /**
+     * Minimum amount of usable slots of the array that replaces this one when
+     * it has to grow. Dummies are not counted, so the array might not
+     * actually become larger when it contains many of them.
+     */
+    SizeT slots_usable_after_grow() const
+    {
+        SizeT slots_set = this->slots_set();
+        SizeT target = (SizeT)((double)slots_set * m_growth_factor);
+        return std::max(target, slots_set + 1);
+    }
+
+    float max_load_factor() const
+    {
+        return m_max_load_factor;
+    }
+
+    /**
+     * Change the max load factor. It has to be between zero and one. The
+     * caller is responsible for growing the array when should_grow returns
+     * true afterwards.
+     */
+    void set_max_load_factor(float factor)
+    {
+        assert(factor > 0.0f && factor < 1.0f);
+        m_max_load_factor = factor;
+        m_slots_usable = this->compute_slots_usable();
+    }
+
+    float growth_factor() const
+    {
+        return m_growth_factor;
+    }
+
+    /**
+     * Change the growth factor. Since the number of items is always a power
+     * of two, the array at least doubles its size when it grows, unless it
+     * contains many dummies.
+     */
+    void set_growth_factor(float factor)
+    {
+        assert(factor > 1.0f);
+        m_growth_factor = factor;
+    }
+
+    uint32_t grow_threads() const
+    {
+        return m_grow_threads;
+    }
+
+    /**
+     * Change the number of threads that the hash table may use to move its
+     * elements when it grows. The table decides whether it is large enough
+     * for that to be worth it.
+     */
+    void set_grow_threads(uint32_t thread_amount)
+    {
+        assert(thread_amount >= 1);
+        m_grow_threads = thread_amount;
+    }
+
+    bool incremental_grow() const
+    {
+        return m_incremental_grow;
+    }
+
+    /**
+     * Change whether the hash table moves its elements to the new array over
+     * multiple operations when it grows. The hash table is responsible for
+     * keeping track of the old array.
+     */
+    void set_incremental_grow(bool enabled)
+    {
+        m_incremental_grow = enabled;
+    }
+
     /**
      * Update the counters after one empty element is used for a newly added
      * element.
@@ -224,24 +350,50 @@ class OpenAddressingArray {
         m_slots_dummy++;
     }
 
+    /**
+     * Update the counters after one previously set element becomes empty.
+     */
+    void update__set_to_empty()
+    {
+        m_slots_set_or_dummy--;
+    }
+
+    /**
+     * Update the counters after all dummies have been turned into empty
+     * elements.
+     */
+    void update__dummies_to_empty()
+    {
+        m_slots_set_or_dummy -= m_slots_dummy;
+        m_slots_dummy = 0;
+    }
+
     /**
      * Access the current slot mask for this array.
      */
-    uint32_t slot_mask() const
+    SizeT slot_mask() const
     {
         return m_slot_mask;
     }
 
+    /**
+     * Can be used to map a hash value into the range of valid item indices.
+     */
+    SizeT item_mask() const
+    {
+        return m_item_amount - 1;
+    }
+
     /**
      * Access the item for a specific item index.
      * Note: The item index is not necessarily the slot index.
      */
-    const Item &item(uint32_t item_index) const
+    const Item &item(SizeT item_index) const
     {
         return m_items[item_index];
     }
 
-    Item &item(uint32_t item_index)
+    Item &item(SizeT item_index)
     {
         return m_items[item_index];
     }
@@ -251,7 +403,7 @@ class OpenAddressingArray {
         return m_item_exponent;
     }
 
-    uint32_t item_amount() const
+    SizeT item_amount() const
     {
         return m_item_amount;
     }
@@ -261,6 +413,48 @@ class OpenAddressingArray {
         return m_slots_set_or_dummy >= m_slots_usable;
     }
 
+    /**
+     * Returns true when the given amount of empty slots can be filled before
+     * the array should grow. Bulk insertions use this to check once instead
+     * of before every element.
+     */
+    bool can_add_without_grow(SizeT amount) const
+    {
+        return m_slots_set_or_dummy + amount <= m_slots_usable;
+    }
+
+    /**
+     * When the array should grow but dummies take up at least half of the
+     * usable slots, removing the dummies frees enough space, so the array can
+     * keep its size.
+     */
+    bool should_remove_dummies_instead_of_grow() const
+    {
+        return m_slots_dummy >= m_slots_usable / 2;
+    }
+
+    /**
+     * Compute the statistics that do not depend on the elements in the
+     * array. The probe lengths have to be added by the hash table.
+     */
+    HashTableStats compute_base_stats() const
+    {
+        HashTableStats stats;
+        stats.size = this->slots_set();
+        stats.capacity = m_slots_total;
+        stats.dummy_amount = m_slots_dummy;
+        stats.load_factor = (float)((double)stats.size /
+                                    (double)stats.capacity);
+        stats.max_load_factor = m_max_load_factor;
+        if (!this->is_in_small_storage()) {
+            stats.bytes_allocated = sizeof(Item) * (uint64_t)m_item_amount;
+            /* Subtract first, so that huge tables do not overflow. */
+            stats.bytes_wasted = (stats.capacity - stats.size) *
+                                 sizeof(Item) / slots_per_item;
+        }
+        return stats;
+    }
+
     Item *begin()
     {
         return m_items;
@@ -282,6 +476,11 @@ class OpenAddressingArray {
     }
 
   private:
+    SizeT compute_slots_usable() const
+    {
+        return (SizeT)((double)m_slots_total * m_max_load_factor);
+    }
+
     Item *small_storage() const
     {
         return reinterpret_cast<Item *>((char *)m_local_storage.ptr());
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+ * parallel_for splits a range of indices into chunks that are processed by
+ * the threads of a task pool.
+ *
+ * The range is split in half recursively. The calling thread keeps working
+ * on the first half and spawns a task for the second one, until the chunk
+ * is not larger than the grain size. Idle threads steal the largest
+ * remaining halves, so the work is balanced even when some chunks take much
+ * longer than others.
+ */
+
+#include "task_pool.h"
+
+namespace bas {
+
+namespace parallel_for_detail {
+
+template<typename FuncT> struct LoopData {
+    const FuncT &func;
+    size_t grain_size;
+    TaskGroup &group;
+};
+
+template<typename FuncT> void run_loop_task(void *data, IndexRange range)
+{
+    LoopData<FuncT> &loop = *(LoopData<FuncT> *)data;
+    while (range.size() > loop.grain_size) {
+        size_t half = range.size() / 2;
+        loop.group.spawn(&run_loop_task<FuncT>,
+                         data,
+                         range.slice(half, range.size() - half));
+        range = range.slice(0, half);
+    }
+    loop.func(range);
+}
+
+}  // namespace parallel_for_detail
+
+/**
+ * Call func(IndexRange) for disjoint chunks that cover the whole range. The
+ * chunks have at most grain_size elements and may be processed in any
+ * order and in parallel. Returns when all chunks are done.
+ */
+template<typename FuncT>
+void parallel_for(IndexRange range,
+                  size_t grain_size,
+                  const FuncT &func,
+                  TaskPool &pool = TaskPool::global())
+{
+    assert(grain_size > 0);
+    if (range.size() <= grain_size) {
+        if (range.size() > 0) {
+            func(range);
+        }
+        return;
+    }
+    TaskGroup group(pool);
+    parallel_for_detail::LoopData<FuncT> loop{func, grain_size, group};
+    parallel_for_detail::run_loop_task<FuncT>(&loop, range);
+    group.wait();
+}
+
+}  // namespace bas
@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * Moves the elements of a hash table that uses control groups (Map and Set)
+ * into a larger array with multiple threads.
+ *
+ * The items of the new array are split into one contiguous region per
+ * thread. First, every thread goes over a part of the old array and sorts
+ * the slots by the region of their home item in the new array. Then every
+ * thread moves the elements of its region into their home items. Since no
+ * two threads write to the same item, no locks are needed. The few elements
+ * whose home item is full already are moved afterwards by the calling
+ * thread, using the normal probing.
+ *
+ * The parts are run as tasks in the global task pool, so the number of
+ * threads that actually work on them depends on the size of the pool.
+ */
+
+#include "control_group.h"
+#include "parallel_for.h"
+#include "vector.h"
+
+namespace bas {
+
+/* Smaller tables are always grown by a single thread, because starting the
+ * threads would take longer than moving the elements. */
+constexpr uint64_t min_size_for_parallel_grow = 1 << 16;
+
+template<typename ArrayType>
+inline bool should_grow_in_parallel(const ArrayType &array)
+{
+    return array.grow_threads() > 1 &&
+           array.slots_set() >= min_size_for_parallel_grow;
+}
+
+namespace parallel_grow_detail {
+
+template<typename FuncT>
+inline void run_in_threads(uint32_t thread_amount, const FuncT &func)
+{
+    parallel_for(IndexRange(thread_amount), 1, [&](IndexRange range) {
+        for (size_t thread : range) {
+            func((uint32_t)thread);
+        }
+    });
+}
+
+}  // namespace parallel_grow_detail
+
+/**
+ * Move all set slots of old_array into new_array, which has to be empty.
+ * The moved slots become empty in the old array. The remaining slots are
+ * moved by calling move_with_probing(old_item, offset) afterwards.
+ */
+template<typename ArrayType, typename MoveWithProbingF>
+void parallel_grow(ArrayType &old_array,
+                   ArrayType &new_array,
+                   const MoveWithProbingF &move_with_probing)
+{
+    using SizeT = decltype(old_array.item_amount());
+    constexpr SizeT offset_mask = ControlGroup::size - 1;
+    constexpr uint32_t offset_shift = 4;
+
+    uint32_t thread_amount = old_array.grow_threads();
+    SizeT old_item_amount = old_array.item_amount();
+    SizeT new_item_mask = new_array.item_mask();
+    uint8_t new_item_exponent = new_array.item_exponent();
+
+    auto region_of_home = [&](SizeT hash) {
+        uint64_t home = hash & new_item_mask;
+        return (uint32_t)((home * thread_amount) >> new_item_exponent);
+    };
+
+    /* Slot indices in the old array, sorted by source thread and region. */
+    Vector<Vector<SizeT>> slots_by_region(thread_amount * thread_amount);
+    parallel_grow_detail::run_in_threads(thread_amount, [&](uint32_t thread) {
+        SizeT begin = (SizeT)((uint64_t)old_item_amount * thread /
+                              thread_amount);
+        SizeT end = (SizeT)((uint64_t)old_item_amount * (thread + 1) /
+                            thread_amount);
+        for (SizeT item_index = begin; item_index < end; item_index++) {
+            auto &item = old_array.item(item_index);
+            for (uint32_t offset : item.set_slots()) {
+                uint32_t region = region_of_home(item.hash(offset));
+                slots_by_region[thread * thread_amount + region].append(
+                    (item_index << offset_shift) | offset);
+            }
+        }
+    });
+
+    Vector<Vector<SizeT>> overflow_by_region(thread_amount);
+    parallel_grow_detail::run_in_threads(thread_amount, [&](uint32_t region) {
+        for (uint32_t thread = 0; thread < thread_amount; thread++) {
+            for (SizeT slot :
+                 slots_by_region[thread * thread_amount + region]) {
+                auto &item = old_array.item(slot >> offset_shift);
+                uint32_t offset = (uint32_t)(slot & offset_mask);
+                SizeT hash = item.hash(offset);
+                auto &home = new_array.item(hash & new_item_mask);
+                int32_t home_offset = home.find_empty();
+                if (home_offset >= 0) {
+                    item.move_slot(offset,
+                                   home,
+                                   (uint32_t)home_offset,
+                                   ControlGroup::fragment(hash));
+                }
+                else {
+                    overflow_by_region[region].append(slot);
+                }
+            }
+        }
+    });
+
+    for (const Vector<SizeT> &overflow : overflow_by_region) {
+        for (SizeT slot : overflow) {
+            move_with_probing(old_array.item(slot >> offset_shift),
+                              (uint32_t)(slot & offset_mask));
+        }
+    }
+}
+
+}  // namespace bas
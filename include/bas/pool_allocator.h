@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * The pool allocator is a drop-in replacement for RawAllocator that is much
+ * faster for small allocations. It can be passed as Allocator template
+ * parameter to Vector, Map, Set and the other containers.
+ *
+ * Small allocations are rounded up to one of a few size classes. Every size
+ * class has a free list per thread, so allocating and freeing usually just
+ * pops or pushes a block without any synchronization. When the list of a
+ * thread is empty, a batch of blocks is taken from a shared list or a new
+ * slab is split into blocks. When a thread frees many blocks, or when it
+ * finishes, its blocks are given back to the shared list. Slabs are never
+ * returned to the system.
+ *
+ * Every block starts with a small header that stores its size class, because
+ * the allocator interface does not pass the size to free. Allocations that
+ * are larger than the largest size class or need more alignment than the
+ * blocks have are forwarded to aligned_malloc.
+ *
+ * All instances share the same pools, so a buffer can be freed by another
+ * instance and in another thread than it has been allocated.
+ */
+
+#include "aligned_allocation.h"
+
+namespace bas {
+
+class PoolAllocator {
+  public:
+    /* Allocations up to this size and alignment are served from the pools.
+     * The size includes the header of the block. */
+    static constexpr size_t max_pooled_size = 2048;
+    static constexpr size_t max_pooled_alignment = 16;
+
+    void *allocate(size_t size, size_t alignment) const
+    {
+        return pool_allocate(size, alignment);
+    }
+
+    void free(void *pointer) const
+    {
+        pool_free(pointer);
+    }
+
+  private:
+    static void *pool_allocate(size_t size, size_t alignment);
+    static void pool_free(void *pointer);
+};
+
+}  // namespace bas
@@ -1,88 +1,88 @@
 #pragma once
 
+/**
+ * The set uses the same group based probing as the map and can also grow
+ * incrementally. See map.h, also for the meaning of SizeT.
+ */
+
+#include "control_group.h"
 #include "hash.h"
 #include "open_addressing.h"
+#include "parallel_grow.h"
 #include "vector.h"
 
 namespace bas {
 
 // clang-format off
 
-#define ITER_SLOTS_BEGIN(VALUE, ARRAY, OPTIONAL_CONST, R_ITEM, R_OFFSET) \
-  uint32_t hash = DefaultHash<T>{}(VALUE); \
-  uint32_t perturb = hash; \
+#define ITER_ITEMS_BEGIN(HASH, ARRAY, OPTIONAL_CONST, R_ITEM, R_FRAGMENT) \
+  SizeT hash_copy = HASH; \
+  uint8_t R_FRAGMENT = ControlGroup::fragment(hash_copy); \
+  SizeT perturb = hash_copy; \
   while (true) { \
-    uint32_t item_index = (hash & ARRAY.slot_mask()) >> OFFSET_SHIFT; \
-    uint8_t R_OFFSET = hash & OFFSET_MASK; \
-    uint8_t initial_offset = R_OFFSET; \
-    OPTIONAL_CONST Item &R_ITEM = ARRAY.item(item_index); \
-    do {
-
-#define ITER_SLOTS_END(R_OFFSET) \
-      R_OFFSET = (R_OFFSET + 1) & OFFSET_MASK; \
-    } while (R_OFFSET != initial_offset); \
+    SizeT item_index = hash_copy & ARRAY.item_mask(); \
+    OPTIONAL_CONST Item &R_ITEM = ARRAY.item(item_index);
+
+#define ITER_ITEMS_END \
     perturb >>= 5; \
-    hash = hash * 5 + 1 + perturb; \
+    hash_copy = hash_copy * 5 + 1 + perturb; \
   } ((void)0)
 
 // clang-format on
 
-template<typename T, typename Allocator = RawAllocator> class Set {
+template<typename T,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<T>,
+         typename SizeT = uint32_t>
+class Set {
   private:
-    static constexpr uint32_t OFFSET_MASK = 3;
-    static constexpr uint32_t OFFSET_SHIFT = 2;
-
-    class Item {
+    static constexpr uint32_t OFFSET_MASK = ControlGroup::size - 1;
+    static constexpr uint32_t OFFSET_SHIFT = 4;
+    /* Number of values that are prefetched ahead in batched lookups. */
+    static constexpr size_t prefetch_distance = 16;
+    /* See the constants with the same names in Map. */
+    static constexpr SizeT items_moved_per_step = 4;
+    static constexpr SizeT min_size_for_incremental_grow = 1 << 12;
+
+    using Hashes = StoredHashes<StoreHashInTable<T>::value,
+                                ControlGroup::size,
+                                SizeT>;
+
+    class Item : Hashes {
       private:
-        static constexpr uint8_t IS_EMPTY = 0;
-        static constexpr uint8_t IS_SET = 1;
-        static constexpr uint8_t IS_DUMMY = 2;
-
-        uint8_t m_status[4];
-        char m_values[4 * sizeof(T)];
+        ControlGroup m_control;
+        AlignedBuffer<sizeof(T) * ControlGroup::size, alignof(T)> m_values;
 
       public:
-        static constexpr uint32_t slots_per_item = 4;
+        static constexpr uint32_t slots_per_item = ControlGroup::size;
+        static constexpr bool trivially_relocatable =
+            is_trivially_relocatable<T>::value;
 
-        Item()
-        {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                m_status[offset] = IS_EMPTY;
-            }
-        }
+        Item() = default;
 
         ~Item()
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                if (m_status[offset] == IS_SET) {
-                    destruct(this->value(offset));
-                }
+            for (uint32_t offset : m_control.match_set()) {
+                destruct(this->value(offset));
             }
         }
 
-        Item(const Item &other)
+        Item(const Item &other) : Hashes(other), m_control(other.m_control)
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                uint8_t status = other.m_status[offset];
-                m_status[offset] = status;
-                if (status == IS_SET) {
-                    T *src = other.value(offset);
-                    T *dst = this->value(offset);
-                    new (dst) T(*src);
-                }
+            for (uint32_t offset : m_control.match_set()) {
+                T *src = other.value(offset);
+                T *dst = this->value(offset);
+                new (dst) T(*src);
             }
         }
 
         Item(Item &&other) noexcept
+            : Hashes(other), m_control(other.m_control)
         {
-            for (uint32_t offset = 0; offset < 4; offset++) {
-                uint8_t status = other.m_status[offset];
-                m_status[offset] = status;
-                if (status == IS_SET) {
-                    T *src = other.value(offset);
-                    T *dst = this->value(offset);
-                    new (dst) T(std::move(*src));
-                }
+            for (uint32_t offset : m_control.match_set()) {
+                T *src = other.value(offset);
+                T *dst = this->value(offset);
+                new (dst) T(std::move(*src));
             }
         }
 
@@ -91,61 +91,223 @@ template<typename T, typename Allocator = RawAllocator> class Set {
 
         T *value(uint32_t offset) const
         {
-            return (T *)(m_values + offset * sizeof(T));
+            return (T *)m_values.ptr() + offset;
         }
 
         template<typename ForwardT>
-        void store(uint32_t offset, ForwardT &&value)
+        void store(uint32_t offset,
+                   uint8_t fragment,
+                   SizeT hash,
+                   ForwardT &&value)
         {
-            assert(m_status[offset] != IS_SET);
-            m_status[offset] = IS_SET;
+            assert(!this->is_set(offset));
+            m_control.set(offset, fragment);
+            this->set_hash(offset, hash);
             T *dst = this->value(offset);
             new (dst) T(std::forward<ForwardT>(value));
         }
 
-        void set_dummy(uint32_t offset)
+        /**
+         * Destruct the value in a set slot. See Map::Item::remove.
+         * Returns true when the slot became empty.
+         */
+        bool remove(uint32_t offset)
+        {
+            destruct(this->value(offset));
+            if (m_control.match_empty().has_any()) {
+                m_control.set_empty(offset);
+                return true;
+            }
+            m_control.set_dummy(offset);
+            return false;
+        }
+
+        /**
+         * Start loading the control group and the first values into the
+         * cache.
+         */
+        void prefetch() const
+        {
+            BAS_PREFETCH(&m_control);
+            BAS_PREFETCH(m_values.ptr());
+        }
+
+        int32_t find_free() const
         {
-            assert(m_status[offset] == IS_SET);
-            m_status[offset] = IS_DUMMY;
+            SlotMask free = m_control.match_free();
+            return free.has_any() ? (int32_t)free.first() : -1;
+        }
+
+        void prepare_rehash_in_place()
+        {
+            m_control.prepare_rehash_in_place();
+        }
+
+        void set_fragment(uint32_t offset, uint8_t fragment)
+        {
+            m_control.set(offset, fragment);
+        }
+
+        /**
+         * Move the value of a slot into an empty slot of another item. The
+         * slot in this item becomes empty.
+         */
+        void move_slot(uint32_t offset,
+                       Item &dst,
+                       uint32_t dst_offset,
+                       uint8_t fragment)
+        {
+            dst.store(dst_offset,
+                      fragment,
+                      this->hash(offset),
+                      std::move(*this->value(offset)));
             destruct(this->value(offset));
+            m_control.set_empty(offset);
+        }
+
+        /**
+         * Destruct the value of a slot that has been moved from and make it
+         * a dummy, so that probing continues past it.
+         */
+        void set_moved_to_dummy(uint32_t offset)
+        {
+            destruct(this->value(offset));
+            m_control.set_dummy(offset);
+        }
+
+        /**
+         * Swap the values and hashes of two slots that are initialized.
+         */
+        void swap_slot(uint32_t offset, Item &other, uint32_t other_offset)
+        {
+            using std::swap;
+            SizeT hash = this->hash(offset);
+            this->set_hash(offset, other.hash(other_offset));
+            other.set_hash(other_offset, hash);
+            swap(*this->value(offset), *other.value(other_offset));
+        }
+
+        SlotMask set_slots() const
+        {
+            return m_control.match_set();
+        }
+
+        /**
+         * Get the hash of the value in a set slot. It is only recomputed when
+         * hashes are not stored for the value type.
+         */
+        SizeT hash(uint32_t offset) const
+        {
+            if constexpr (Hashes::stores_hashes) {
+                return this->stored_hash(offset);
+            }
+            else {
+                return fold_hash<SizeT>(Hash{}(*this->value(offset)));
+            }
         }
 
         bool is_empty(uint32_t offset) const
         {
-            return m_status[offset] == IS_EMPTY;
+            return m_control.is_empty(offset);
         }
 
         bool is_set(uint32_t offset) const
         {
-            return m_status[offset] == IS_SET;
+            return m_control.is_set(offset);
         }
 
         bool is_dummy(uint32_t offset) const
         {
-            return m_status[offset] == IS_DUMMY;
+            return m_control.is_dummy(offset);
         }
 
-        bool has_value(uint32_t offset, const T &value) const
+        /**
+         * Return the offset of the slot that contains the value, or -1 when
+         * the value is not in this item.
+         */
+        int32_t find_value(uint8_t fragment,
+                           SizeT hash,
+                           const T &value) const
         {
-            return m_status[offset] == IS_SET && *this->value(offset) == value;
+            for (uint32_t offset : m_control.match(fragment)) {
+                if (this->hash_matches(offset, hash) &&
+                    *this->value(offset) == value) {
+                    return (int32_t)offset;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Return the offset of the first empty slot, or -1 when the item is
+         * full.
+         */
+        int32_t find_empty() const
+        {
+            SlotMask empty = m_control.match_empty();
+            return empty.has_any() ? (int32_t)empty.first() : -1;
         }
     };
 
-    using ArrayType = OpenAddressingArray<Item, 1, Allocator>;
-    ArrayType m_array = OpenAddressingArray<Item>();
+    using ArrayType = OpenAddressingArray<Item, 1, Allocator, SizeT>;
+    ArrayType m_array;
+    /* The previous array while the set grows incrementally. See Map. */
+    ArrayType *m_old_array = nullptr;
+    SizeT m_moved_items = 0;
+
+    template<typename, typename, typename> friend class FrozenSet;
 
   public:
     Set() = default;
 
+    ~Set()
+    {
+        this->free_old_array();
+    }
+
+    Set(const Set &other)
+        : m_array(other.m_array), m_moved_items(other.m_moved_items)
+    {
+        if (other.m_old_array != nullptr) {
+            m_old_array = this->allocate_old_array(*other.m_old_array);
+        }
+    }
+
+    Set(Set &&other) noexcept
+        : m_array(std::move(other.m_array)),
+          m_old_array(other.m_old_array),
+          m_moved_items(other.m_moved_items)
+    {
+        other.m_old_array = nullptr;
+        other.m_moved_items = 0;
+    }
+
+    Set &operator=(const Set &other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        this->~Set();
+        new (this) Set(other);
+        return *this;
+    }
+
+    Set &operator=(Set &&other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        this->~Set();
+        new (this) Set(std::move(other));
+        return *this;
+    }
+
     /**
      * Create a new set that contains the given elements.
      */
     Set(ArrayRef<T> values)
     {
-        this->reserve((uint32_t)values.size());
-        for (const T &value : values) {
-            this->add(value);
-        }
+        this->add_multiple(values);
     }
 
     /**
@@ -158,13 +320,89 @@ template<typename T, typename Allocator = RawAllocator> class Set {
     /**
      * Make the set large enough to hold the given amount of elements.
      */
-    void reserve(uint32_t min_usable_slots)
+    void reserve(SizeT min_usable_slots)
     {
         if (m_array.slots_usable() < min_usable_slots) {
             this->grow(min_usable_slots);
         }
     }
 
+    /**
+     * Change the fraction of slots that can be used before the set has to
+     * grow. Higher values reduce the memory usage, lower values make probing
+     * faster. The default is 0.5.
+     */
+    void set_max_load_factor(float factor)
+    {
+        m_array.set_max_load_factor(factor);
+        if (m_array.should_grow()) {
+            this->grow(this->size() + 1);
+        }
+    }
+
+    float max_load_factor() const
+    {
+        return m_array.max_load_factor();
+    }
+
+    /**
+     * Change by which factor the number of elements can increase before the
+     * set has to grow again. The default is 2.
+     */
+    void set_growth_factor(float factor)
+    {
+        m_array.set_growth_factor(factor);
+    }
+
+    float growth_factor() const
+    {
+        return m_array.growth_factor();
+    }
+
+    /**
+     * Allow the set to use multiple threads to move its elements when it
+     * grows. This shortens the pause of inserts that make large tables grow.
+     * Tables that are small are still grown by one thread. The default is 1.
+     */
+    void set_grow_threads(uint32_t thread_amount)
+    {
+        m_array.set_grow_threads(thread_amount);
+    }
+
+    uint32_t grow_threads() const
+    {
+        return m_array.grow_threads();
+    }
+
+    /**
+     * Spread the work of growing over the insertions and removals that
+     * follow. See Map::set_incremental_grow.
+     */
+    void set_incremental_grow(bool enabled)
+    {
+        m_array.set_incremental_grow(enabled);
+        if (!enabled) {
+            this->finish_incremental_grow();
+        }
+    }
+
+    bool incremental_grow() const
+    {
+        return m_array.incremental_grow();
+    }
+
+    bool is_growing_incrementally() const
+    {
+        return m_old_array != nullptr;
+    }
+
+    void finish_incremental_grow()
+    {
+        while (m_old_array != nullptr) {
+            this->move_old_items_step();
+        }
+    }
+
     /**
      * Add a new element to the set.
      * Asserts that the element did not exist in the set before.
@@ -191,23 +429,27 @@ template<typename T, typename Allocator = RawAllocator> class Set {
     }
 
     /**
-     * Add multiple elements to the set.
+     * Add multiple elements to the set. The set grows at most once before the
+     * elements are inserted.
      */
     void add_multiple(ArrayRef<T> values)
     {
+        this->ensure_can_add_multiple((SizeT)values.size());
         for (const T &value : values) {
-            this->add(value);
+            this->add__no_grow(value);
         }
     }
 
     /**
-     * Add multiple new elements to the set.
+     * Add multiple new elements to the set. The set grows at most once before
+     * the elements are inserted.
      * Asserts that none of the elements existed in the set before.
      */
     void add_multiple_new(ArrayRef<T> values)
     {
+        this->ensure_can_add_multiple((SizeT)values.size());
         for (const T &value : values) {
-            this->add_new(value);
+            this->add_new__no_grow(value);
         }
     }
 
@@ -216,16 +458,32 @@ template<typename T, typename Allocator = RawAllocator> class Set {
      */
     bool contains(const T &value) const
     {
-        ITER_SLOTS_BEGIN(value, m_array, const, item, offset)
-        {
-            if (item.is_empty(offset)) {
-                return false;
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        return this->contains__impl(value, hash);
+    }
+
+    /**
+     * Do contains for many values at once. The items of the next values are
+     * prefetched while the current value is searched. See
+     * Map::lookup_ptr_batch.
+     */
+    void contains_batch(ArrayRef<T> values,
+                        MutableArrayRef<bool> r_results) const
+    {
+        assert(values.size() == r_results.size());
+        SizeT hashes[prefetch_distance];
+        for (size_t i = 0; i < values.size() + prefetch_distance; i++) {
+            if (i >= prefetch_distance) {
+                size_t done = i - prefetch_distance;
+                r_results[done] = this->contains__impl(
+                    values[done], hashes[done % prefetch_distance]);
             }
-            else if (item.has_value(offset, value)) {
-                return true;
+            if (i < values.size()) {
+                SizeT hash = fold_hash<SizeT>(Hash{}(values[i]));
+                hashes[i % prefetch_distance] = hash;
+                m_array.item(hash & m_array.item_mask()).prefetch();
             }
         }
-        ITER_SLOTS_END(offset);
     }
 
     /**
@@ -235,15 +493,17 @@ template<typename T, typename Allocator = RawAllocator> class Set {
     void remove(const T &value)
     {
         assert(this->contains(value));
-        ITER_SLOTS_BEGIN(value, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        this->prepare_modify(value, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.has_value(offset, value)) {
-                item.set_dummy(offset);
-                m_array.update__set_to_dummy();
+            int32_t offset = item.find_value(fragment, hash, value);
+            if (offset >= 0) {
+                this->remove_from_item(item, (uint32_t)offset);
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     Vector<T> to_vector() const
@@ -256,7 +516,7 @@ template<typename T, typename Allocator = RawAllocator> class Set {
         return vector;
     }
 
-    uint32_t size() const
+    SizeT size() const
     {
         return m_array.slots_set();
     }
@@ -289,22 +549,49 @@ template<typename T, typename Allocator = RawAllocator> class Set {
         return !Intersects(a, b);
     }
 
+    /**
+     * Compute statistics about the memory usage and the probe lengths. Every
+     * value is hashed again, so this should not be used in performance
+     * critical code.
+     */
+    HashTableStats compute_stats() const
+    {
+        HashTableStats stats = m_array.compute_base_stats();
+        for (const Item &item : m_array) {
+            for (uint32_t offset : item.set_slots()) {
+                stats.add_probe_length(
+                    count_collisions(m_array, *item.value(offset)));
+            }
+        }
+        if (m_old_array != nullptr) {
+            stats.bytes_allocated +=
+                m_old_array->compute_base_stats().bytes_allocated;
+            for (const Item &item : *m_old_array) {
+                for (uint32_t offset : item.set_slots()) {
+                    stats.add_probe_length(
+                        count_collisions(*m_old_array, *item.value(offset)));
+                }
+            }
+        }
+        return stats;
+    }
+
     void print_table() const
     {
         std::cout << "Hash Table:\n";
         std::cout << "  Size: " << m_array.slots_set() << '\n';
         std::cout << "  Capacity: " << m_array.slots_total() << '\n';
-        uint32_t item_index = 0;
+        SizeT item_index = 0;
         for (const Item &item : m_array) {
             std::cout << "   Item: " << item_index++ << '\n';
-            for (uint32_t offset = 0; offset < 4; offset++) {
+            for (uint32_t offset = 0; offset < ControlGroup::size; offset++) {
                 std::cout << "    " << offset << " \t";
                 if (item.is_empty(offset)) {
                     std::cout << "    <empty>\n";
                 }
                 else if (item.is_set(offset)) {
                     const T &value = *item.value(offset);
-                    uint32_t collisions = this->count_collisions(value);
+                    uint32_t collisions = count_collisions(m_array, value);
                     std::cout << "    " << value
                               << "  \t Collisions: " << collisions << '\n';
                 }
@@ -318,10 +605,10 @@ template<typename T, typename Allocator = RawAllocator> class Set {
     class Iterator {
       private:
         const Set *m_set;
-        uint32_t m_slot;
+        SizeT m_slot;
 
       public:
-        Iterator(const Set *set, uint32_t slot) : m_set(set), m_slot(slot)
+        Iterator(const Set *set, SizeT slot) : m_set(set), m_slot(slot)
         {
         }
 
@@ -333,9 +620,8 @@ template<typename T, typename Allocator = RawAllocator> class Set {
 
         const T &operator*() const
         {
-            uint32_t item_index = m_slot >> OFFSET_SHIFT;
-            uint32_t offset = m_slot & OFFSET_MASK;
-            const Item &item = m_set->m_array.item(item_index);
+            uint32_t offset = (uint32_t)(m_slot & OFFSET_MASK);
+            const Item &item = m_set->item_of_slot(m_slot);
             assert(item.is_set(offset));
             return *item.value(offset);
         }
@@ -361,17 +647,66 @@ template<typename T, typename Allocator = RawAllocator> class Set {
 
     Iterator end() const
     {
-        return Iterator(this, m_array.slots_total());
+        return Iterator(this, this->slots_end());
     }
 
   private:
-    uint32_t next_slot(uint32_t slot) const
+    bool contains__impl(const T &value, SizeT hash) const
+    {
+        if (contains_in_array(m_array, value, hash)) {
+            return true;
+        }
+        if (BAS_UNLIKELY(m_old_array != nullptr)) {
+            return contains_in_array(*m_old_array, value, hash);
+        }
+        return false;
+    }
+
+    /* Also used by FrozenSet, see Map::lookup_ptr_in_array. */
+    template<typename ArrayT>
+    static bool contains_in_array(const ArrayT &array,
+                                  const T &value,
+                                  SizeT hash)
+    {
+        ITER_ITEMS_BEGIN(hash, array, const, item, fragment)
+        {
+            if (item.find_value(fragment, hash, value) >= 0) {
+                return true;
+            }
+            if (item.find_empty() >= 0) {
+                return false;
+            }
+        }
+        ITER_ITEMS_END;
+    }
+
+    /**
+     * Slot indices of the old array follow the ones of the current array.
+     */
+    SizeT slots_end() const
+    {
+        SizeT end = m_array.slots_total();
+        if (m_old_array != nullptr) {
+            end += m_old_array->slots_total();
+        }
+        return end;
+    }
+
+    const Item &item_of_slot(SizeT slot) const
     {
-        for (; slot < m_array.slots_total(); slot++) {
-            uint32_t item_index = slot >> OFFSET_SHIFT;
-            uint32_t offset = slot & OFFSET_MASK;
-            const Item &item = m_array.item(item_index);
-            if (item.is_set(offset)) {
+        SizeT item_index = slot >> OFFSET_SHIFT;
+        if (item_index < m_array.item_amount()) {
+            return m_array.item(item_index);
+        }
+        return m_old_array->item(item_index - m_array.item_amount());
+    }
+
+    SizeT next_slot(SizeT slot) const
+    {
+        SizeT end = this->slots_end();
+        for (; slot < end; slot++) {
+            uint32_t offset = (uint32_t)(slot & OFFSET_MASK);
+            if (this->item_of_slot(slot).is_set(offset)) {
                 return slot;
             }
         }
@@ -380,19 +715,117 @@ template<typename T, typename Allocator = RawAllocator> class Set {
 
     void ensure_can_add()
     {
+        if (BAS_UNLIKELY(m_old_array != nullptr)) {
+            this->move_old_items_step();
+        }
         if (BAS_UNLIKELY(m_array.should_grow())) {
-            this->grow(this->size() + 1);
+            if (m_array.should_remove_dummies_instead_of_grow()) {
+                this->rehash_in_place();
+            }
+            else {
+                this->grow(m_array.slots_usable_after_grow());
+            }
         }
     }
 
-    BAS_NOINLINE void grow(uint32_t min_usable_slots)
+    /**
+     * Make sure that the given amount of elements can be added without
+     * checking whether the set has to grow before every element. See
+     * Map::ensure_can_add_multiple.
+     */
+    void ensure_can_add_multiple(SizeT amount)
     {
-        ArrayType new_array = m_array.init_reserved(min_usable_slots);
+        if (!m_array.can_add_without_grow(amount)) {
+            this->grow(std::max(m_array.slots_usable_after_grow(),
+                                this->size() + amount));
+        }
+    }
+
+    void remove_from_item(Item &item, uint32_t offset)
+    {
+        if (item.remove(offset)) {
+            m_array.update__set_to_empty();
+        }
+        else {
+            m_array.update__set_to_dummy();
+        }
+        if (BAS_UNLIKELY(m_old_array != nullptr)) {
+            this->move_old_items_step();
+        }
+    }
+
+    /**
+     * Remove all dummies without allocating a new array. First, all set
+     * slots are marked as dummies and all dummies become empty. Then every
+     * marked element is moved to the first item in its probe sequence that
+     * has a free slot. If that slot is still marked, the two elements are
+     * swapped and the element that is now in the current slot is processed
+     * next.
+     */
+    BAS_NOINLINE void rehash_in_place()
+    {
+        this->finish_incremental_grow();
+        for (Item &item : m_array) {
+            item.prepare_rehash_in_place();
+        }
+        for (Item &item : m_array) {
+            for (uint32_t offset = 0; offset < ControlGroup::size; offset++) {
+                while (item.is_dummy(offset)) {
+                    this->rehash_slot_in_place(item, offset);
+                }
+            }
+        }
+        m_array.update__dummies_to_empty();
+    }
 
-        for (Item &old_item : m_array) {
-            for (uint8_t offset = 0; offset < 4; offset++) {
-                if (old_item.is_set(offset)) {
-                    this->add_after_grow(*old_item.value(offset), new_array);
+    void rehash_slot_in_place(Item &item, uint32_t offset)
+    {
+        ITER_ITEMS_BEGIN(item.hash(offset), m_array, , dst, fragment)
+        {
+            int32_t dst_offset = dst.find_free();
+            if (dst_offset >= 0) {
+                if (&dst == &item) {
+                    item.set_fragment(offset, fragment);
+                }
+                else if (dst.is_empty((uint32_t)dst_offset)) {
+                    item.move_slot(
+                        offset, dst, (uint32_t)dst_offset, fragment);
+                }
+                else {
+                    item.swap_slot(offset, dst, (uint32_t)dst_offset);
+                    dst.set_fragment((uint32_t)dst_offset, fragment);
+                }
+                return;
+            }
+        }
+        ITER_ITEMS_END;
+    }
+
+    BAS_NOINLINE void grow(SizeT min_usable_slots)
+    {
+        this->finish_incremental_grow();
+        ArrayType new_array = m_array.init_reserved(min_usable_slots);
+        if (m_array.incremental_grow() &&
+            this->size() >= min_size_for_incremental_grow) {
+            m_old_array = this->allocate_old_array(std::move(m_array));
+            m_moved_items = 0;
+            m_array = std::move(new_array);
+            return;
+        }
+
+        if (should_grow_in_parallel(m_array)) {
+            auto move_with_probing = [&](Item &item, uint32_t offset) {
+                this->add_after_grow(
+                    *item.value(offset), item.hash(offset), new_array);
+            };
+            parallel_grow(m_array, new_array, move_with_probing);
+        }
+        else {
+            for (Item &old_item : m_array) {
+                for (uint32_t offset : old_item.set_slots()) {
+                    this->add_after_grow(*old_item.value(offset),
+                                         old_item.hash(offset),
+                                         new_array);
                 }
             }
         }
@@ -400,67 +833,156 @@ template<typename T, typename Allocator = RawAllocator> class Set {
         m_array = std::move(new_array);
     }
 
-    void add_after_grow(T &old_value, ArrayType &new_array)
+    /**
+     * Move the values of the next few items of the old array to the current
+     * array. The old array is freed after its last item.
+     */
+    void move_old_items_step()
+    {
+        SizeT end = std::min<SizeT>(m_moved_items + items_moved_per_step,
+                                    m_old_array->item_amount());
+        for (; m_moved_items < end; m_moved_items++) {
+            Item &item = m_old_array->item(m_moved_items);
+            for (uint32_t offset : item.set_slots()) {
+                this->move_old_slot(item, offset);
+            }
+        }
+        if (m_moved_items == m_old_array->item_amount()) {
+            this->free_old_array();
+        }
+    }
+
+    void move_old_slot(Item &item, uint32_t offset)
+    {
+        this->add_after_grow(*item.value(offset), item.hash(offset), m_array);
+        item.set_moved_to_dummy(offset);
+    }
+
+    /**
+     * Move the value to the current array if it is still in the old array.
+     * See Map::prepare_modify.
+     */
+    void prepare_modify(const T &value, SizeT hash)
+    {
+        if (m_old_array == nullptr) {
+            return;
+        }
+        ITER_ITEMS_BEGIN(hash, (*m_old_array), , item, fragment)
+        {
+            int32_t offset = item.find_value(fragment, hash, value);
+            if (offset >= 0) {
+                this->move_old_slot(item, (uint32_t)offset);
+                return;
+            }
+            if (item.find_empty() >= 0) {
+                return;
+            }
+        }
+        ITER_ITEMS_END;
+    }
+
+    static ArrayType *allocate_old_array(ArrayType array)
     {
-        ITER_SLOTS_BEGIN(old_value, new_array, , item, offset)
+        void *buffer = Allocator().allocate(sizeof(ArrayType),
+                                            alignof(ArrayType));
+        return new (buffer) ArrayType(std::move(array));
+    }
+
+    void free_old_array()
+    {
+        if (m_old_array != nullptr) {
+            m_old_array->~ArrayType();
+            Allocator().free(m_old_array);
+            m_old_array = nullptr;
+            m_moved_items = 0;
+        }
+    }
+
+    void add_after_grow(T &old_value, SizeT hash, ArrayType &new_array)
+    {
+        ITER_ITEMS_BEGIN(hash, new_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset, std::move(old_value));
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store(
+                    (uint32_t)offset, fragment, hash, std::move(old_value));
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
-    uint32_t count_collisions(const T &value) const
+    static uint32_t count_collisions(const ArrayType &array, const T &value)
     {
         uint32_t collisions = 0;
-        ITER_SLOTS_BEGIN(value, m_array, const, item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_ITEMS_BEGIN(hash, array, const, item, fragment)
         {
-            if (item.is_empty(offset) || item.has_value(offset, value)) {
+            if (item.find_value(fragment, hash, value) >= 0 ||
+                item.find_empty() >= 0) {
                 return collisions;
             }
             collisions++;
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardT> void add_new__impl(ForwardT &&value)
     {
-        assert(!this->contains(value));
         this->ensure_can_add();
+        this->add_new__no_grow(std::forward<ForwardT>(value));
+    }
+
+    template<typename ForwardT> void add_new__no_grow(ForwardT &&value)
+    {
+        assert(!this->contains(value));
 
-        ITER_SLOTS_BEGIN(value, m_array, , item, offset)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset, std::forward<ForwardT>(value));
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
+                           std::forward<ForwardT>(value));
                 m_array.update__empty_to_set();
                 return;
             }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 
     template<typename ForwardT> bool add__impl(ForwardT &&value)
     {
         this->ensure_can_add();
+        return this->add__no_grow(std::forward<ForwardT>(value));
+    }
 
-        ITER_SLOTS_BEGIN(value, m_array, , item, offset)
+    template<typename ForwardT> bool add__no_grow(ForwardT &&value)
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        this->prepare_modify(value, hash);
+        ITER_ITEMS_BEGIN(hash, m_array, , item, fragment)
         {
-            if (item.is_empty(offset)) {
-                item.store(offset, std::forward<ForwardT>(value));
+            if (item.find_value(fragment, hash, value) >= 0) {
+                return false;
+            }
+            int32_t offset = item.find_empty();
+            if (offset >= 0) {
+                item.store((uint32_t)offset,
+                           fragment,
+                           hash,
+                           std::forward<ForwardT>(value));
                 m_array.update__empty_to_set();
                 return true;
             }
-            else if (item.has_value(offset, value)) {
-                return false;
-            }
         }
-        ITER_SLOTS_END(offset);
+        ITER_ITEMS_END;
     }
 };
 
-#undef ITER_SLOTS_BEGIN
-#undef ITER_SLOTS_END
+#undef ITER_ITEMS_BEGIN
+#undef ITER_ITEMS_END
 
 }  // namespace bas
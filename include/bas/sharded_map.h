@@ -0,0 +1,204 @@
+#pragma once
+
+/**
+ * A ShardedMap splits its keys into a fixed number of shards based on their
+ * hash. Every shard is a Map with its own lock, so threads that insert
+ * different keys rarely have to wait for each other. This works best for
+ * write heavy parallel phases. Use ConcurrentMap when the map is mostly read.
+ *
+ * Every shard also has a LinearAllocator, which the callbacks of
+ * add_or_modify can use to allocate memory for the values. This memory is
+ * freed when the sharded map is destructed.
+ *
+ * After a parallel phase, all shards can be merged into a single Map.
+ */
+
+#include <mutex>
+#include <utility>
+
+#include "linear_allocator.h"
+#include "map.h"
+
+namespace bas {
+
+template<typename KeyT,
+         typename ValueT,
+         uint32_t ShardAmount = 64,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<KeyT>>
+class ShardedMap {
+  public:
+    using MapType = Map<KeyT, ValueT, Allocator, Hash>;
+
+  private:
+    static_assert(ShardAmount >= 1, "There has to be at least one shard.");
+
+    /* Shards are aligned to cache lines, so that threads that lock different
+     * shards do not access the same cache lines. */
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        MapType map;
+        LinearAllocator<Allocator> allocator;
+    };
+
+    Shard m_shards[ShardAmount];
+
+  public:
+    ShardedMap() = default;
+
+    ShardedMap(const ShardedMap &other) = delete;
+    ShardedMap &operator=(const ShardedMap &other) = delete;
+
+    /**
+     * Insert a new key-value-pair in the map.
+     * Asserts when the key existed before.
+     */
+    void add_new(const KeyT &key, const ValueT &value)
+    {
+        Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.map.add_new(key, value);
+    }
+
+    /**
+     * Insert a new key-value-pair in the map if the key does not exist yet.
+     * Returns true when the pair was newly inserted, otherwise false.
+     */
+    bool add(const KeyT &key, const ValueT &value)
+    {
+        Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.add(key, value);
+    }
+
+    /**
+     * Similar to add, but overrides the value for the key when it exists
+     * already.
+     */
+    bool add_override(const KeyT &key, const ValueT &value)
+    {
+        Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.add_override(key, value);
+    }
+
+    /**
+     * Same as Map::add_or_modify, but both callbacks get the linear
+     * allocator of the shard as second parameter. They are called while the
+     * shard is locked.
+     */
+    template<typename CreateValueF, typename ModifyValueF>
+    auto add_or_modify(const KeyT &key,
+                       const CreateValueF &create_value,
+                       const ModifyValueF &modify_value)
+        -> decltype(create_value(
+            nullptr, std::declval<LinearAllocator<Allocator> &>()))
+    {
+        Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.add_or_modify(
+            key,
+            [&](ValueT *r_value) {
+                return create_value(r_value, shard.allocator);
+            },
+            [&](ValueT *value) {
+                return modify_value(value, shard.allocator);
+            });
+    }
+
+    /**
+     * Get a copy of the value that is stored for the key, or the default
+     * value when the key does not exist.
+     */
+    ValueT lookup_default(const KeyT &key, const ValueT &default_value) const
+    {
+        const Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.lookup_default(key, default_value);
+    }
+
+    bool contains(const KeyT &key) const
+    {
+        const Shard &shard = this->shard_for_key(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.contains(key);
+    }
+
+    /**
+     * Number of entries in all shards. The shards are locked one after the
+     * other, so the result is only exact when no other thread modifies the
+     * map at the same time.
+     */
+    uint32_t size() const
+    {
+        uint32_t size = 0;
+        for (const Shard &shard : m_shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.map.size();
+        }
+        return size;
+    }
+
+    /**
+     * Call the function for every key-value-pair. Every shard is locked while
+     * its items are visited.
+     */
+    template<typename FuncT> void foreach_item(const FuncT &func) const
+    {
+        for (const Shard &shard : m_shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.map.foreach_item(func);
+        }
+    }
+
+    /**
+     * Move all key-value-pairs into a single map. The shards are empty
+     * afterwards. Memory that has been allocated by the callbacks of
+     * add_or_modify stays owned by this sharded map.
+     *
+     * Must not be called while other threads use the map.
+     */
+    MapType merge()
+    {
+        MapType merged;
+        merged.reserve(this->size());
+        for (Shard &shard : m_shards) {
+            for (auto item : shard.map.items()) {
+                merged.add_new(item.key, std::move(item.value));
+            }
+            shard.map.clear();
+        }
+        return merged;
+    }
+
+    static constexpr uint32_t shard_amount()
+    {
+        return ShardAmount;
+    }
+
+  private:
+    /**
+     * The shard is selected with the high bits of the product of the hash and
+     * a constant. The map in the shard uses the low bits of the hash and a
+     * product with a different constant, so the shard index does not
+     * correlate with the position in the shard.
+     */
+    static uint32_t shard_index(const KeyT &key)
+    {
+        uint64_t hash = (uint64_t)Hash{}(key);
+        uint64_t high = (hash * 0xD6E8FEB86659FD93ull) >> 32;
+        return (uint32_t)((high * ShardAmount) >> 32);
+    }
+
+    Shard &shard_for_key(const KeyT &key)
+    {
+        return m_shards[shard_index(key)];
+    }
+
+    const Shard &shard_for_key(const KeyT &key) const
+    {
+        return m_shards[shard_index(key)];
+    }
+};
+
+}  // namespace bas
@@ -0,0 +1,550 @@
+#pragma once
+
+/**
+ * Kernels for linear searches in arrays. ArrayRef, Vector and StringRef use
+ * them, so they rarely have to be called directly.
+ *
+ * Integers, enums and pointers are compared as raw bits, so that a whole
+ * vector register of them can be compared with one instruction. AVX2 is
+ * used when the compiler targets it, otherwise SSE2. Bytes are searched
+ * with memchr, which is vectorized by the C library. All other types,
+ * including floating point types whose equality is not bitwise, use a
+ * scalar loop.
+ *
+ * The minimum and maximum of integers with up to four bytes are computed
+ * with vector instructions when SSE4.1 or AVX2 is available.
+ *
+ * Strings are searched for chars of a CharSet by comparing every register
+ * with each char of the set. Sets with many chars use the table lookup of
+ * the CharSet instead.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "char_set.h"
+#include "utildefines.h"
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define BAS_SIMD_OP(name) _mm256_##name
+#    define BAS_SIMD_HAS_MIN_MAX
+#    define BAS_SIMD_HAS_CMPEQ_EPI64
+#elif defined(BAS_HAS_SSE2)
+#    include <emmintrin.h>
+#    define BAS_SIMD_OP(name) _mm_##name
+#    if defined(__SSE4_1__)
+#        include <smmintrin.h>
+#        define BAS_SIMD_HAS_MIN_MAX
+#        define BAS_SIMD_HAS_CMPEQ_EPI64
+#    endif
+#endif
+
+namespace bas {
+
+/**
+ * True for types whose equality is the same as the equality of their bits.
+ */
+template<typename T>
+struct is_bitwise_comparable
+    : std::integral_constant<bool,
+                             (std::is_integral<T>::value ||
+                              std::is_enum<T>::value ||
+                              std::is_pointer<T>::value) &&
+                                 (sizeof(T) == 1 || sizeof(T) == 2 ||
+                                  sizeof(T) == 4 || sizeof(T) == 8)> {
+};
+
+namespace simd_detail {
+
+#ifdef BAS_SIMD_OP
+
+#    if defined(__AVX2__)
+using Register = __m256i;
+
+inline Register load(const void *ptr)
+{
+    return _mm256_loadu_si256((const __m256i *)ptr);
+}
+
+inline Register zero()
+{
+    return _mm256_setzero_si256();
+}
+
+inline Register bit_and(Register a, Register b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+inline Register bit_or(Register a, Register b)
+{
+    return _mm256_or_si256(a, b);
+}
+#    else
+using Register = __m128i;
+
+inline Register load(const void *ptr)
+{
+    return _mm_loadu_si128((const __m128i *)ptr);
+}
+
+inline Register zero()
+{
+    return _mm_setzero_si128();
+}
+
+inline Register bit_and(Register a, Register b)
+{
+    return _mm_and_si128(a, b);
+}
+
+inline Register bit_or(Register a, Register b)
+{
+    return _mm_or_si128(a, b);
+}
+#    endif
+
+/* One bit per byte of the register. */
+inline uint32_t movemask(Register value)
+{
+    return (uint32_t)BAS_SIMD_OP(movemask_epi8)(value);
+}
+
+/* The movemask of a register in which all bytes are set. */
+constexpr uint32_t full_mask = (uint32_t)(((uint64_t)1 << sizeof(Register)) -
+                                          1);
+
+template<typename T> inline Register broadcast(const T &value)
+{
+    if constexpr (sizeof(T) == 1) {
+        int8_t bits;
+        memcpy(&bits, &value, 1);
+        return BAS_SIMD_OP(set1_epi8)(bits);
+    }
+    else if constexpr (sizeof(T) == 2) {
+        int16_t bits;
+        memcpy(&bits, &value, 2);
+        return BAS_SIMD_OP(set1_epi16)(bits);
+    }
+    else if constexpr (sizeof(T) == 4) {
+        int32_t bits;
+        memcpy(&bits, &value, 4);
+        return BAS_SIMD_OP(set1_epi32)(bits);
+    }
+    else {
+        long long bits;
+        memcpy(&bits, &value, 8);
+        return BAS_SIMD_OP(set1_epi64x)(bits);
+    }
+}
+
+/* All bytes of elements that are equal are set. */
+template<size_t Size> inline Register equal(Register a, Register b)
+{
+    if constexpr (Size == 1) {
+        return BAS_SIMD_OP(cmpeq_epi8)(a, b);
+    }
+    else if constexpr (Size == 2) {
+        return BAS_SIMD_OP(cmpeq_epi16)(a, b);
+    }
+    else if constexpr (Size == 4) {
+        return BAS_SIMD_OP(cmpeq_epi32)(a, b);
+    }
+    else {
+#    ifdef BAS_SIMD_HAS_CMPEQ_EPI64
+        return BAS_SIMD_OP(cmpeq_epi64)(a, b);
+#    else
+        /* Both halves of an element have to be equal. */
+        __m128i halves = _mm_cmpeq_epi32(a, b);
+        __m128i swapped = _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_and_si128(halves, swapped);
+#    endif
+    }
+}
+
+/* Lanes of equal elements are -1, so subtracting them counts matches. */
+template<size_t Size> inline Register subtract(Register a, Register b)
+{
+    if constexpr (Size == 1) {
+        return BAS_SIMD_OP(sub_epi8)(a, b);
+    }
+    else if constexpr (Size == 2) {
+        return BAS_SIMD_OP(sub_epi16)(a, b);
+    }
+    else if constexpr (Size == 4) {
+        return BAS_SIMD_OP(sub_epi32)(a, b);
+    }
+    else {
+        return BAS_SIMD_OP(sub_epi64)(a, b);
+    }
+}
+
+template<typename UInt> inline size_t sum_lanes_as(Register value)
+{
+    UInt lanes[sizeof(Register) / sizeof(UInt)];
+    memcpy(lanes, &value, sizeof(Register));
+    size_t sum = 0;
+    for (UInt lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+
+template<size_t Size> inline size_t sum_lanes(Register value)
+{
+    if constexpr (Size == 1) {
+        return sum_lanes_as<uint8_t>(value);
+    }
+    else if constexpr (Size == 2) {
+        return sum_lanes_as<uint16_t>(value);
+    }
+    else if constexpr (Size == 4) {
+        return sum_lanes_as<uint32_t>(value);
+    }
+    else {
+        return sum_lanes_as<uint64_t>(value);
+    }
+}
+
+#    ifdef BAS_SIMD_HAS_MIN_MAX
+template<typename T, bool IsMax>
+inline Register extreme(Register a, Register b)
+{
+    constexpr bool is_signed = std::is_signed<T>::value;
+    if constexpr (sizeof(T) == 1) {
+        if constexpr (IsMax) {
+            return is_signed ? BAS_SIMD_OP(max_epi8)(a, b) :
+                               BAS_SIMD_OP(max_epu8)(a, b);
+        }
+        return is_signed ? BAS_SIMD_OP(min_epi8)(a, b) :
+                           BAS_SIMD_OP(min_epu8)(a, b);
+    }
+    else if constexpr (sizeof(T) == 2) {
+        if constexpr (IsMax) {
+            return is_signed ? BAS_SIMD_OP(max_epi16)(a, b) :
+                               BAS_SIMD_OP(max_epu16)(a, b);
+        }
+        return is_signed ? BAS_SIMD_OP(min_epi16)(a, b) :
+                           BAS_SIMD_OP(min_epu16)(a, b);
+    }
+    else {
+        if constexpr (IsMax) {
+            return is_signed ? BAS_SIMD_OP(max_epi32)(a, b) :
+                               BAS_SIMD_OP(max_epu32)(a, b);
+        }
+        return is_signed ? BAS_SIMD_OP(min_epi32)(a, b) :
+                           BAS_SIMD_OP(min_epu32)(a, b);
+    }
+}
+#    endif
+
+#endif
+
+template<typename T, bool IsMax> T extreme_value(const T *data, size_t size)
+{
+    assert(size > 0);
+    T result = data[0];
+    size_t i = 1;
+#ifdef BAS_SIMD_HAS_MIN_MAX
+    if constexpr (std::is_integral<T>::value && sizeof(T) <= 4) {
+        constexpr size_t lanes = sizeof(Register) / sizeof(T);
+        if (size >= lanes) {
+            Register accumulated = load(data);
+            for (i = lanes; i + lanes <= size; i += lanes) {
+                accumulated = extreme<T, IsMax>(accumulated, load(data + i));
+            }
+            T values[lanes];
+            memcpy(values, &accumulated, sizeof(Register));
+            for (const T &value : values) {
+                result = (IsMax ? result < value : value < result) ? value :
+                                                                     result;
+            }
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        const T &value = data[i];
+        result = (IsMax ? result < value : value < result) ? value : result;
+    }
+    return result;
+}
+
+#ifdef BAS_SIMD_OP
+/**
+ * Finds the chars of a set that has all its chars in the list.
+ */
+class CharSetMatcher {
+  private:
+    Register m_patterns[CharSet::max_listed_chars];
+    uint32_t m_size;
+
+  public:
+    CharSetMatcher(const CharSet &set) : m_size(set.size())
+    {
+        assert(set.is_listed());
+        for (uint32_t i = 0; i < m_size; i++) {
+            m_patterns[i] = broadcast(set.listed_chars()[i]);
+        }
+    }
+
+    /* One bit per char in the block that is in the set. */
+    uint32_t match(const char *block) const
+    {
+        Register chars = load(block);
+        Register matches = zero();
+        for (uint32_t i = 0; i < m_size; i++) {
+            matches = bit_or(matches, equal<1>(chars, m_patterns[i]));
+        }
+        return movemask(matches);
+    }
+};
+#endif
+
+template<bool Contained>
+ssize_t find_first_in_set(const char *data, size_t size, const CharSet &set)
+{
+    /* Strings often start with a char that decides the search already, so
+     * it is checked before the patterns for the registers are set up. */
+    if (size > 0 && set.contains(data[0]) == Contained) {
+        return 0;
+    }
+    size_t i = 0;
+#ifdef BAS_SIMD_OP
+    if (set.is_listed()) {
+        CharSetMatcher matcher(set);
+        for (; i + sizeof(Register) <= size; i += sizeof(Register)) {
+            uint32_t mask = matcher.match(data + i);
+            if (!Contained) {
+                mask ^= full_mask;
+            }
+            if (mask != 0) {
+                return (ssize_t)(i + count_trailing_zeros(mask));
+            }
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (set.contains(data[i]) == Contained) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+template<bool Contained>
+ssize_t find_last_in_set(const char *data, size_t size, const CharSet &set)
+{
+    if (size > 0 && set.contains(data[size - 1]) == Contained) {
+        return (ssize_t)(size - 1);
+    }
+    size_t end = size;
+#ifdef BAS_SIMD_OP
+    if (set.is_listed()) {
+        CharSetMatcher matcher(set);
+        for (; end >= sizeof(Register); end -= sizeof(Register)) {
+            size_t start = end - sizeof(Register);
+            uint32_t mask = matcher.match(data + start);
+            if (!Contained) {
+                mask ^= full_mask;
+            }
+            if (mask != 0) {
+                return (ssize_t)(start + 31 - count_leading_zeros(mask));
+            }
+        }
+    }
+#endif
+    for (size_t i = end; i-- > 0;) {
+        if (set.contains(data[i]) == Contained) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+}  // namespace simd_detail
+
+/**
+ * Return the index of the first element that is equal to the value, or -1
+ * when there is none.
+ */
+template<typename T>
+inline ssize_t find_first_equal(const T *data, size_t size, const T &value)
+{
+    size_t i = 0;
+    if constexpr (is_bitwise_comparable<T>::value && sizeof(T) == 1) {
+        if (size == 0) {
+            return -1;
+        }
+        unsigned char byte;
+        memcpy(&byte, &value, 1);
+        const void *found = memchr((const void *)data, byte, size);
+        return found == nullptr ? -1 : (const T *)found - data;
+    }
+#ifdef BAS_SIMD_OP
+    if constexpr (is_bitwise_comparable<T>::value) {
+        using namespace simd_detail;
+        constexpr size_t lanes = sizeof(Register) / sizeof(T);
+        Register pattern = broadcast(value);
+        for (; i + lanes <= size; i += lanes) {
+            uint32_t mask = movemask(
+                equal<sizeof(T)>(load(data + i), pattern));
+            if (mask != 0) {
+                return (ssize_t)(i + count_trailing_zeros(mask) / sizeof(T));
+            }
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == value) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Count the elements that are equal to the value.
+ */
+template<typename T>
+inline size_t count_equal(const T *data, size_t size, const T &value)
+{
+    size_t i = 0;
+    size_t count = 0;
+#ifdef BAS_SIMD_OP
+    if constexpr (is_bitwise_comparable<T>::value) {
+        using namespace simd_detail;
+        constexpr size_t lanes = sizeof(Register) / sizeof(T);
+        /* Small lanes are summed up before they can overflow. */
+        constexpr size_t max_blocks = sizeof(T) == 1 ? 255 :
+                                      sizeof(T) == 2 ? 65535 :
+                                                       SIZE_MAX;
+        Register pattern = broadcast(value);
+        while (i + lanes <= size) {
+            size_t blocks = std::min((size - i) / lanes, max_blocks);
+            Register counts = zero();
+            for (size_t block = 0; block < blocks; block++, i += lanes) {
+                counts = subtract<sizeof(T)>(
+                    counts, equal<sizeof(T)>(load(data + i), pattern));
+            }
+            count += sum_lanes<sizeof(T)>(counts);
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == value) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Returns true when both arrays contain equal elements at every index.
+ */
+template<typename T>
+inline bool arrays_equal(const T *a, const T *b, size_t size)
+{
+    if constexpr (is_bitwise_comparable<T>::value) {
+        return size == 0 || memcmp(a, b, sizeof(T) * size) == 0;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Get the smallest element. Asserts that the array is not empty.
+ */
+template<typename T> inline T min_value(const T *data, size_t size)
+{
+    return simd_detail::extreme_value<T, false>(data, size);
+}
+
+/**
+ * Get the largest element. Asserts that the array is not empty.
+ */
+template<typename T> inline T max_value(const T *data, size_t size)
+{
+    return simd_detail::extreme_value<T, true>(data, size);
+}
+
+/**
+ * Return the index of the first char that is in the set, or -1 when there
+ * is none.
+ */
+inline ssize_t find_first_in(const char *data,
+                             size_t size,
+                             const CharSet &set)
+{
+    return simd_detail::find_first_in_set<true>(data, size, set);
+}
+
+/**
+ * Return the index of the first char that is not in the set, or -1 when
+ * there is none.
+ */
+inline ssize_t find_first_not_in(const char *data,
+                                 size_t size,
+                                 const CharSet &set)
+{
+    return simd_detail::find_first_in_set<false>(data, size, set);
+}
+
+/**
+ * Return the index of the last char that is not in the set, or -1 when
+ * there is none.
+ */
+inline ssize_t find_last_not_in(const char *data,
+                                size_t size,
+                                const CharSet &set)
+{
+    return simd_detail::find_last_in_set<false>(data, size, set);
+}
+
+/**
+ * Returns true when the chars are equal to the lower case chars, after
+ * converting the ASCII upper case letters in them to lower case.
+ */
+inline bool equal_lower_ascii(const char *chars,
+                              const char *lower_chars,
+                              size_t size)
+{
+    size_t i = 0;
+#ifdef BAS_SIMD_OP
+    using namespace simd_detail;
+    /* Chars are signed here, so bytes above 127 are never upper case. */
+    const Register before_upper = broadcast((char)('A' - 1));
+    const Register after_upper = broadcast((char)('Z' + 1));
+    const Register case_bit = broadcast((char)('a' - 'A'));
+    for (; i + sizeof(Register) <= size; i += sizeof(Register)) {
+        Register block = load(chars + i);
+        Register is_upper = bit_and(
+            BAS_SIMD_OP(cmpgt_epi8)(block, before_upper),
+            BAS_SIMD_OP(cmpgt_epi8)(after_upper, block));
+        Register lower = bit_or(block, bit_and(is_upper, case_bit));
+        if (movemask(equal<1>(lower, load(lower_chars + i))) != full_mask) {
+            return false;
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        char c = chars[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        if (c != lower_chars[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace bas
+
+#undef BAS_SIMD_OP
+#undef BAS_SIMD_HAS_MIN_MAX
+#undef BAS_SIMD_HAS_CMPEQ_EPI64
@@ -1,5 +1,7 @@
 
 
+#pragma once
+
 /**
  * This tries to solve the issue that a normal map with std::string as key
  * might do many allocations when the keys are longer than 16 bytes (the usual
@@ -34,7 +36,10 @@ namespace bas {
 
 // clang-format on
 
-template<typename T, typename Allocator = RawAllocator> class StringMap {
+template<typename T,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<StringRef>>
+class StringMap {
   private:
     static constexpr uint32_t OFFSET_MASK = 3;
     static constexpr uint32_t OFFSET_SHIFT = 2;
@@ -49,6 +54,8 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
 
       public:
         static constexpr uint32_t slots_per_item = 4;
+        static constexpr bool trivially_relocatable =
+            is_trivially_relocatable<T>::value;
 
         Item()
         {
@@ -122,15 +129,18 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
 
         bool has_exact_key(uint32_t offset,
                            StringRef key,
-                           const Vector<char, 4, Allocator> &chars) const
+                           const char *chars) const
         {
             return key == this->get_key(offset, chars);
         }
 
-        StringRefNull get_key(uint32_t offset,
-                              const Vector<char, 4, Allocator> &chars) const
+        /**
+         * The chars contain the length of every key, followed by the key
+         * and a null terminator.
+         */
+        StringRefNull get_key(uint32_t offset, const char *chars) const
         {
-            const char *ptr = chars.begin() + m_indices[offset];
+            const char *ptr = chars + m_indices[offset];
             uint32_t length = *(uint32_t *)ptr;
             const char *start = ptr + sizeof(uint32_t);
             return StringRefNull(start, length);
@@ -153,6 +163,8 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
     ArrayType m_array;
     Vector<char, 4, Allocator> m_chars;
 
+    template<typename, typename> friend class FrozenStringMap;
+
   public:
     StringMap() = default;
 
@@ -198,18 +210,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
      */
     bool contains(StringRef key) const
     {
-        uint32_t hash = this->compute_string_hash(key);
-        ITER_SLOTS_BEGIN(hash, m_array, const, item, offset)
-        {
-            if (item.is_empty(offset)) {
-                return false;
-            }
-            else if (item.has_hash(offset, hash) &&
-                     item.has_exact_key(offset, key, m_chars)) {
-                return true;
-            }
-        }
-        ITER_SLOTS_END(offset);
+        return this->lookup_ptr(key) != nullptr;
     }
 
     /**
@@ -236,7 +237,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
                      * exists once in some cases. */
                     found_value = item.value(offset);
                 }
-                else if (item.has_exact_key(offset, key, m_chars)) {
+                else if (item.has_exact_key(offset, key, m_chars.begin())) {
                     /* Found the hash more than once, now check for actual
                      * string equality. */
                     return *item.value(offset);
@@ -258,18 +259,8 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
      */
     const T *lookup_ptr(StringRef key) const
     {
-        uint32_t hash = this->compute_string_hash(key);
-        ITER_SLOTS_BEGIN(hash, m_array, const, item, offset)
-        {
-            if (item.is_empty(offset)) {
-                return nullptr;
-            }
-            else if (item.has_hash(offset, hash) &&
-                     item.has_exact_key(offset, key, m_chars)) {
-                return item.value(offset);
-            }
-        }
-        ITER_SLOTS_END(offset);
+        return lookup_ptr_in_array(
+            m_array, m_chars.begin(), key, compute_string_hash(key));
     }
 
     T *lookup_ptr(StringRef key)
@@ -312,7 +303,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
         for (const Item &item : m_array) {
             for (uint32_t offset = 0; offset < 4; offset++) {
                 if (item.is_set(offset) && value == *item.value(offset)) {
-                    return item.get_key(offset, m_chars);
+                    return item.get_key(offset, m_chars.begin());
                 }
             }
         }
@@ -342,7 +333,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
         for (Item &item : m_array) {
             for (uint32_t offset = 0; offset < 4; offset++) {
                 if (item.is_set(offset)) {
-                    StringRefNull key = item.get_key(offset, m_chars);
+                    StringRefNull key = item.get_key(offset, m_chars.begin());
                     func(key);
                 }
             }
@@ -357,7 +348,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
         for (Item &item : m_array) {
             for (uint32_t offset = 0; offset < 4; offset++) {
                 if (item.is_set(offset)) {
-                    StringRefNull key = item.get_key(offset, m_chars);
+                    StringRefNull key = item.get_key(offset, m_chars.begin());
                     T &value = *item.value(offset);
                     func(key, value);
                 }
@@ -370,7 +361,7 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
         for (const Item &item : m_array) {
             for (uint32_t offset = 0; offset < 4; offset++) {
                 if (item.is_set(offset)) {
-                    StringRefNull key = item.get_key(offset, m_chars);
+                    StringRefNull key = item.get_key(offset, m_chars.begin());
                     const T &value = *item.value(offset);
                     func(key, value);
                 }
@@ -378,16 +369,70 @@ template<typename T, typename Allocator = RawAllocator> class StringMap {
         }
     }
 
+    /**
+     * Compute statistics about the memory usage and the probe lengths. The
+     * memory that stores the keys is included. Every key is hashed again, so
+     * this should not be used in performance critical code.
+     */
+    HashTableStats compute_stats() const
+    {
+        HashTableStats stats = m_array.compute_base_stats();
+        this->foreach_item([&](StringRefNull key, const T & /*value*/) {
+            stats.add_probe_length(this->count_collisions(key));
+        });
+        uint64_t char_bytes = m_chars.allocated_bytes();
+        if (char_bytes > 0) {
+            stats.bytes_allocated += char_bytes;
+            stats.bytes_wasted += char_bytes - m_chars.size();
+        }
+        return stats;
+    }
+
   private:
-    uint32_t compute_string_hash(StringRef key) const
+    uint32_t count_collisions(StringRef key) const
+    {
+        uint32_t hash = this->compute_string_hash(key);
+        uint32_t collisions = 0;
+        ITER_SLOTS_BEGIN(hash, m_array, const, item, offset)
+        {
+            if (item.is_empty(offset)) {
+                return collisions;
+            }
+            else if (item.has_hash(offset, hash) &&
+                     item.has_exact_key(offset, key, m_chars.begin())) {
+                return collisions;
+            }
+            collisions++;
+        }
+        ITER_SLOTS_END(offset);
+    }
+
+    /**
+     * Probe in the given array. It is a template, so that frozen string maps
+     * can probe in items that are not owned by an OpenAddressingArray.
+     */
+    template<typename ArrayT>
+    static const T *lookup_ptr_in_array(const ArrayT &array,
+                                        const char *chars,
+                                        StringRef key,
+                                        uint32_t hash)
     {
-        /* TODO: check if this can be optimized more because we know the key
-         * length already. */
-        uint32_t hash = 5381;
-        for (char c : key) {
-            hash = hash * 33 + c;
+        ITER_SLOTS_BEGIN(hash, array, const, item, offset)
+        {
+            if (item.is_empty(offset)) {
+                return nullptr;
+            }
+            else if (item.has_hash(offset, hash) &&
+                     item.has_exact_key(offset, key, chars)) {
+                return item.value(offset);
+            }
         }
-        return hash;
+        ITER_SLOTS_END(offset);
+    }
+
+    static uint32_t compute_string_hash(StringRef key)
+    {
+        return fold_hash<uint32_t>(Hash{}(key));
     }
 
     uint32_t save_key_in_array(StringRef key)
@@ -1,14 +1,30 @@
 #pragma once
 
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <sstream>
 #include <string>
 
+#if __has_include(<charconv>)
+#    include <charconv>
+#endif
+
 #include "array_ref.h"
+#include "vector.h"
+
+/* Older standard libraries only parse integers with std::from_chars. */
+#if defined(__cpp_lib_to_chars)
+#    define BAS_HAS_FLOAT_FROM_CHARS
+#endif
 
 namespace bas {
 
 class StringRef;
+class StringSplit;
+class StringTokens;
 
 class StringRefBase {
   protected:
@@ -19,6 +35,11 @@ class StringRefBase {
     {
     }
 
+    static CharSet to_char_set(ArrayRef<char> chars)
+    {
+        return CharSet(chars.begin(), chars.size());
+    }
+
   public:
     /**
      * Return the (byte-)length of the referenced string, without any
@@ -102,13 +123,83 @@ class StringRefBase {
 
     StringRef substr(size_t start, size_t size) const;
 
-    StringRef lstrip(ArrayRef<char> chars = {' ', '\t', '\n', '\r'}) const;
-    StringRef rstrip(ArrayRef<char> chars = {' ', '\t', '\n', '\r'}) const;
-    StringRef strip(ArrayRef<char> chars = {' ', '\t', '\n', '\r'}) const;
+    StringRef lstrip(const CharSet &chars = CharSet::whitespace()) const;
+    StringRef rstrip(const CharSet &chars = CharSet::whitespace()) const;
+    StringRef strip(const CharSet &chars = CharSet::whitespace()) const;
+
+    /**
+     * Strip the chars of an array, e.g. an ArrayRef<char> or Vector<char>.
+     * This is a template, so that braced lists still create a CharSet.
+     */
+    template<typename Chars,
+             typename std::enable_if<std::is_convertible<
+                 const Chars &, ArrayRef<char>>::value>::type * = nullptr>
+    StringRef lstrip(const Chars &chars) const;
+    template<typename Chars,
+             typename std::enable_if<std::is_convertible<
+                 const Chars &, ArrayRef<char>>::value>::type * = nullptr>
+    StringRef rstrip(const Chars &chars) const;
+    template<typename Chars,
+             typename std::enable_if<std::is_convertible<
+                 const Chars &, ArrayRef<char>>::value>::type * = nullptr>
+    StringRef strip(const Chars &chars) const;
+
+    /**
+     * Iterate over the parts between the delimiters. Empty parts are kept,
+     * so a string with n delimiters always has n + 1 parts:
+     *
+     *   for (StringRef field : line.split(',')) { ... }
+     *
+     * No memory is allocated. The parts reference this string.
+     */
+    StringSplit split(char delimiter) const;
+
+    /**
+     * Iterate over the non-empty parts between chars of the set. Unlike
+     * split, consecutive delimiters do not produce empty parts.
+     */
+    StringTokens tokenize(
+        const CharSet &delimiters = CharSet::whitespace()) const;
 
+    /**
+     * Convert the string to a number with parse. Leading whitespace and a
+     * plus sign are skipped, and characters after the number are ignored.
+     *
+     * Unlike strtof and strtol, numbers that do not fit into the type are
+     * not clamped. Zero is returned and the conversion fails for them, just
+     * like when there is no number. Hexadecimal floats like "0x1p4" are not
+     * supported, only the leading "0" is converted.
+     */
     float to_float(bool *r_success = nullptr) const;
     int to_int(bool *r_success = nullptr) const;
 
+    /**
+     * Parse the number at the start of the string. This works like
+     * std::from_chars: whitespace and plus signs are not skipped, and the
+     * result does not depend on the locale. No memory is allocated.
+     *
+     * T can be any integer or floating point type. Floats are rounded
+     * correctly. Returns the number of chars that belong to the number, or
+     * zero when there is no number or it does not fit into the type. The
+     * value is only changed when parsing succeeds.
+     */
+    template<typename T> size_t parse(T &r_value) const;
+
+    /**
+     * Like parse, but for integers written with hexadecimal digits. An
+     * optional "0x" or "0X" prefix is consumed as well.
+     */
+    template<typename IntT> size_t parse_hex(IntT &r_value) const;
+
+    /**
+     * Parse every part between the delimiters and append the values, e.g.
+     * to read a row of numbers from a CSV file. Whitespace around the
+     * numbers is ignored. Returns false when a part is not a number. The
+     * values of the parts before it have been appended then.
+     */
+    template<typename T, size_t N, typename Allocator>
+    bool parse_split(char delimiter, Vector<T, N, Allocator> &r_values) const;
+
     bool contains(char c) const;
 
     size_t first_index_of(char c, size_t start = 0) const;
@@ -140,15 +231,21 @@ class StringRefNull : public StringRefBase {
     {
     }
 
-    StringRefNull lstrip(ArrayRef<char> chars = {' ', '\t', '\r', '\n'}) const
+    StringRefNull lstrip(const CharSet &chars = CharSet::whitespace()) const
     {
-        for (size_t i = 0; i < m_size; i++) {
-            char c = m_data[i];
-            if (!chars.contains(c)) {
-                return StringRefNull(m_data + i, m_size - i);
-            }
+        ssize_t index = find_first_not_in(m_data, m_size, chars);
+        if (index < 0) {
+            return "";
         }
-        return "";
+        return StringRefNull(m_data + index, m_size - (size_t)index);
+    }
+
+    template<typename Chars,
+             typename std::enable_if<std::is_convertible<
+                 const Chars &, ArrayRef<char>>::value>::type * = nullptr>
+    StringRefNull lstrip(const Chars &chars) const
+    {
+        return this->lstrip(to_char_set(chars));
     }
 };
 
@@ -209,6 +306,161 @@ class StringRef : public StringRefBase {
     }
 };
 
+/**
+ * The parts of a string between a delimiter char, see StringRef::split.
+ */
+class StringSplit {
+  private:
+    StringRef m_str;
+    char m_delimiter;
+
+  public:
+    StringSplit(StringRef str, char delimiter)
+        : m_str(str), m_delimiter(delimiter)
+    {
+    }
+
+    class Iterator {
+      private:
+        const char *m_part_begin;
+        const char *m_part_end;
+        const char *m_end;
+        char m_delimiter;
+        bool m_is_done;
+
+      public:
+        Iterator(StringRef str, char delimiter, bool is_done)
+            : m_part_begin(str.begin()),
+              m_end(str.end()),
+              m_delimiter(delimiter),
+              m_is_done(is_done)
+        {
+            this->find_part_end();
+        }
+
+        Iterator &operator++()
+        {
+            if (m_part_end == m_end) {
+                m_is_done = true;
+            }
+            else {
+                m_part_begin = m_part_end + 1;
+                this->find_part_end();
+            }
+            return *this;
+        }
+
+        bool operator!=(const Iterator &iterator) const
+        {
+            if (m_is_done || iterator.m_is_done) {
+                return m_is_done != iterator.m_is_done;
+            }
+            return m_part_begin != iterator.m_part_begin;
+        }
+
+        StringRef operator*() const
+        {
+            return StringRef(m_part_begin,
+                             (size_t)(m_part_end - m_part_begin));
+        }
+
+      private:
+        void find_part_end()
+        {
+            size_t size = (size_t)(m_end - m_part_begin);
+            ssize_t index = find_first_equal(m_part_begin, size, m_delimiter);
+            m_part_end = index < 0 ? m_end : m_part_begin + index;
+        }
+    };
+
+    Iterator begin() const
+    {
+        return Iterator(m_str, m_delimiter, false);
+    }
+
+    Iterator end() const
+    {
+        return Iterator(StringRef(), m_delimiter, true);
+    }
+};
+
+/**
+ * The non-empty parts of a string between chars of a set, see
+ * StringRef::tokenize.
+ */
+class StringTokens {
+  private:
+    StringRef m_str;
+    CharSet m_delimiters;
+
+  public:
+    StringTokens(StringRef str, const CharSet &delimiters)
+        : m_str(str), m_delimiters(delimiters)
+    {
+    }
+
+    class Iterator {
+      private:
+        const char *m_token_begin;
+        const char *m_token_end;
+        const char *m_end;
+        const CharSet *m_delimiters;
+
+      public:
+        Iterator(StringRef str, const CharSet &delimiters)
+            : m_token_end(str.begin()),
+              m_end(str.end()),
+              m_delimiters(&delimiters)
+        {
+            this->find_token();
+        }
+
+        Iterator &operator++()
+        {
+            this->find_token();
+            return *this;
+        }
+
+        /* The end iterator has no token. */
+        bool operator!=(const Iterator &iterator) const
+        {
+            return m_token_begin != iterator.m_token_begin;
+        }
+
+        StringRef operator*() const
+        {
+            return StringRef(m_token_begin,
+                             (size_t)(m_token_end - m_token_begin));
+        }
+
+      private:
+        void find_token()
+        {
+            size_t size = (size_t)(m_end - m_token_end);
+            ssize_t start = find_first_not_in(
+                m_token_end, size, *m_delimiters);
+            if (start < 0) {
+                m_token_begin = nullptr;
+                return;
+            }
+            m_token_begin = m_token_end + start;
+            size = (size_t)(m_end - m_token_begin);
+            ssize_t length = find_first_in(m_token_begin, size, *m_delimiters);
+            m_token_end = length < 0 ? m_end : m_token_begin + length;
+        }
+    };
+
+    Iterator begin() const
+    {
+        return Iterator(m_str, m_delimiters);
+    }
+
+    Iterator end() const
+    {
+        return Iterator(StringRef(), m_delimiters);
+    }
+};
+
 /* More inline functions
  ***************************************/
 
@@ -234,12 +486,7 @@ inline bool operator==(StringRef a, StringRef b)
     if (a.size() != b.size()) {
         return false;
     }
-    for (size_t i = 0; i < a.size(); i++) {
-        if (a[i] != b[i]) {
-            return false;
-        }
-    }
-    return true;
+    return arrays_equal(a.data(), b.data(), a.size());
 }
 
 inline bool operator!=(StringRef a, StringRef b)
@@ -252,12 +499,7 @@ inline bool StringRefBase::startswith(StringRef prefix) const
     if (m_size < prefix.m_size) {
         return false;
     }
-    for (size_t i = 0; i < prefix.m_size; i++) {
-        if (m_data[i] != prefix.m_data[i]) {
-            return false;
-        }
-    }
-    return true;
+    return arrays_equal(m_data, prefix.m_data, prefix.m_size);
 }
 
 inline char tolower_ascii(char c)
@@ -279,13 +521,7 @@ inline bool StringRefBase::startswith_lower_ascii(StringRef prefix) const
     if (m_size < prefix.m_size) {
         return false;
     }
-    for (size_t i = 0; i < prefix.m_size; i++) {
-        char c = tolower_ascii(m_data[i]);
-        if (c != prefix.m_data[i]) {
-            return false;
-        }
-    }
-    return true;
+    return equal_lower_ascii(m_data, prefix.m_data, prefix.m_size);
 }
 
 inline bool StringRefBase::startswith(char c) const
@@ -302,12 +538,7 @@ inline bool StringRefBase::endswith(StringRef suffix) const
         return false;
     }
     size_t offset = m_size - suffix.m_size;
-    for (size_t i = 0; i < suffix.m_size; i++) {
-        if (m_data[offset + i] != suffix.m_data[i]) {
-            return false;
-        }
-    }
-    return true;
+    return arrays_equal(m_data + offset, suffix.m_data, suffix.m_size);
 }
 
 inline bool StringRefBase::endswith(char c) const
@@ -324,59 +555,276 @@ inline StringRef StringRefBase::substr(size_t start, size_t size) const
     return StringRef(m_data + start, size);
 }
 
-inline StringRef StringRefBase::lstrip(ArrayRef<char> chars) const
+inline StringRef StringRefBase::lstrip(const CharSet &chars) const
 {
-    for (size_t i = 0; i < m_size; i++) {
-        char c = m_data[i];
-        if (!chars.contains(c)) {
-            return StringRef(m_data + i, m_size - i);
-        }
+    ssize_t index = find_first_not_in(m_data, m_size, chars);
+    if (index < 0) {
+        return "";
     }
-    return "";
+    return StringRef(m_data + index, m_size - (size_t)index);
 }
 
-inline StringRef StringRefBase::rstrip(ArrayRef<char> chars) const
+inline StringRef StringRefBase::rstrip(const CharSet &chars) const
 {
-    for (ssize_t i = m_size - 1; i >= 0; i--) {
-        char c = m_data[i];
-        if (!chars.contains(c)) {
-            return StringRef(m_data, i + 1);
-        }
+    ssize_t index = find_last_not_in(m_data, m_size, chars);
+    if (index < 0) {
+        return "";
     }
-    return "";
+    return StringRef(m_data, (size_t)index + 1);
 }
 
-inline StringRef StringRefBase::strip(ArrayRef<char> chars) const
+inline StringRef StringRefBase::strip(const CharSet &chars) const
 {
     StringRef lstripped = this->lstrip(chars);
     StringRef stripped = lstripped.rstrip(chars);
     return stripped;
 }
 
-inline float StringRefBase::to_float(bool *r_success) const
+template<typename Chars,
+         typename std::enable_if<std::is_convertible<
+             const Chars &, ArrayRef<char>>::value>::type *>
+inline StringRef StringRefBase::lstrip(const Chars &chars) const
+{
+    return this->lstrip(to_char_set(chars));
+}
+
+template<typename Chars,
+         typename std::enable_if<std::is_convertible<
+             const Chars &, ArrayRef<char>>::value>::type *>
+inline StringRef StringRefBase::rstrip(const Chars &chars) const
+{
+    return this->rstrip(to_char_set(chars));
+}
+
+template<typename Chars,
+         typename std::enable_if<std::is_convertible<
+             const Chars &, ArrayRef<char>>::value>::type *>
+inline StringRef StringRefBase::strip(const Chars &chars) const
+{
+    return this->strip(to_char_set(chars));
+}
+
+namespace parse_detail {
+
+/* Value of a digit in bases up to 36, or a value of at least 36 for chars
+ * that are not digits. */
+inline uint32_t digit_value(char c)
+{
+    uint32_t value = (uint32_t)(uint8_t)c - '0';
+    if (value < 10) {
+        return value;
+    }
+    /* Setting the case bit converts upper case letters to lower case. */
+    value = ((uint32_t)(uint8_t)c | 0x20) - 'a';
+    return value < 26 ? value + 10 : 36;
+}
+
+/**
+ * Parse the digits at the start of the string into a value that must not
+ * be larger than max. Returns the number of digits, or zero when there is
+ * no digit or the value is too large.
+ */
+template<uint32_t Base, typename UIntT>
+size_t parse_digits(const char *data, size_t size, UIntT max, UIntT &r_value)
+{
+    /* Numbers with fewer digits cannot overflow, so only the digits after
+     * them have to be checked. */
+    static_assert(Base == 10 || Base == 16, "unsupported base");
+    using Limits = std::numeric_limits<UIntT>;
+    constexpr size_t unchecked_digits = Base == 10 ? Limits::digits10 :
+                                                     Limits::digits / 4 - 1;
+    constexpr UIntT max_before_last_digit = Limits::max() / Base;
+    constexpr uint32_t max_last_digit = Limits::max() % Base;
+    UIntT value = 0;
+    size_t i = 0;
+    const size_t unchecked_end = std::min(size, unchecked_digits);
+    for (; i < unchecked_end; i++) {
+        uint32_t digit = digit_value(data[i]);
+        if (digit >= Base) {
+            break;
+        }
+        value = (UIntT)(value * Base + digit);
+    }
+    bool is_too_large = false;
+    if (i == unchecked_end) {
+        for (; i < size; i++) {
+            uint32_t digit = digit_value(data[i]);
+            if (digit >= Base) {
+                break;
+            }
+            if (value > max_before_last_digit ||
+                (value == max_before_last_digit && digit > max_last_digit)) {
+                is_too_large = true;
+            }
+            value = (UIntT)(value * Base + digit);
+        }
+    }
+    if (i == 0 || is_too_large || value > max) {
+        return 0;
+    }
+    r_value = value;
+    return i;
+}
+
+template<uint32_t Base, typename IntT>
+size_t parse_int(const char *data, size_t size, IntT &r_value)
+{
+    static_assert(std::is_integral<IntT>::value &&
+                      !std::is_same<IntT, bool>::value,
+                  "type is not an integer");
+    using UIntT = std::make_unsigned_t<IntT>;
+    constexpr UIntT max = (UIntT)std::numeric_limits<IntT>::max();
+    bool is_negative = std::is_signed<IntT>::value && size > 0 &&
+                       data[0] == '-';
+    size_t offset = is_negative ? 1 : 0;
+    if (Base == 16 && size >= offset + 3 && data[offset] == '0' &&
+        (data[offset + 1] | 0x20) == 'x' &&
+        digit_value(data[offset + 2]) < 16) {
+        offset += 2;
+    }
+    UIntT value = 0;
+    /* The magnitude of the smallest negative value is one larger than the
+     * largest positive value. */
+    size_t digits = parse_digits<Base>(
+        data + offset, size - offset, (UIntT)(max + is_negative), value);
+    if (digits == 0) {
+        return 0;
+    }
+    if (is_negative) {
+        if (value == (UIntT)(max + 1)) {
+            r_value = std::numeric_limits<IntT>::min();
+        }
+        else {
+            r_value = -(IntT)value;
+        }
+    }
+    else {
+        r_value = (IntT)value;
+    }
+    return offset + digits;
+}
+
+template<typename FloatT>
+size_t parse_float(const char *data, size_t size, FloatT &r_value)
 {
-    char *str_with_null = (char *)alloca(m_size + 1);
-    this->unsafe_copy(str_with_null);
+#ifdef BAS_HAS_FLOAT_FROM_CHARS
+    FloatT value;
+    std::from_chars_result result = std::from_chars(
+        data, data + size, value);
+    if (result.ec != std::errc()) {
+        return 0;
+    }
+    r_value = value;
+    return (size_t)(result.ptr - data);
+#else
+    /* The strto functions need a null terminated string. They skip what
+     * from_chars does not accept. */
+    if (size == 0 || data[0] == '+' ||
+        CharSet::whitespace().contains(data[0])) {
+        return 0;
+    }
+    char *str_with_null = (char *)alloca(size + 1);
+    memcpy(str_with_null, data, size);
+    str_with_null[size] = '\0';
     char *end;
-    float value = std::strtof(str_with_null, &end);
+    errno = 0;
+    FloatT value;
+    if constexpr (std::is_same<FloatT, float>::value) {
+        value = std::strtof(str_with_null, &end);
+    }
+    else if constexpr (std::is_same<FloatT, double>::value) {
+        value = std::strtod(str_with_null, &end);
+    }
+    else {
+        value = std::strtold(str_with_null, &end);
+    }
+    /* ERANGE is also set for subnormal values, which are fine. */
+    if (end == str_with_null || (errno == ERANGE && std::isinf(value))) {
+        return 0;
+    }
+    r_value = value;
+    return (size_t)(end - str_with_null);
+#endif
+}
+
+/* Matches strtol and strtof, which skip whitespace and a plus sign. */
+inline StringRef strip_number_prefix(const char *data, size_t size)
+{
+    StringRef stripped = StringRef(data, size).lstrip();
+    if (stripped.startswith('+') &&
+        !stripped.drop_prefix(1).startswith('-')) {
+        return stripped.drop_prefix(1);
+    }
+    return stripped;
+}
+
+}  // namespace parse_detail
+
+template<typename T> inline size_t StringRefBase::parse(T &r_value) const
+{
+    if constexpr (std::is_floating_point<T>::value) {
+        return parse_detail::parse_float(m_data, m_size, r_value);
+    }
+    else {
+        return parse_detail::parse_int<10>(m_data, m_size, r_value);
+    }
+}
+
+template<typename IntT>
+inline size_t StringRefBase::parse_hex(IntT &r_value) const
+{
+    return parse_detail::parse_int<16>(m_data, m_size, r_value);
+}
+
+template<typename T, size_t N, typename Allocator>
+inline bool StringRefBase::parse_split(char delimiter,
+                                       Vector<T, N, Allocator> &r_values) const
+{
+    size_t delimiter_amount = count_equal(m_data, m_size, delimiter);
+    r_values.reserve(r_values.size() + delimiter_amount + 1);
+    for (StringRef part : this->split(delimiter)) {
+        StringRef number = part.strip();
+        T value{};
+        if (number.size() == 0 || number.parse(value) != number.size()) {
+            return false;
+        }
+        r_values.append_unchecked(value);
+    }
+    return true;
+}
+
+inline float StringRefBase::to_float(bool *r_success) const
+{
+    float value = 0.0f;
+    StringRef number = parse_detail::strip_number_prefix(m_data, m_size);
+    size_t consumed = number.parse(value);
     if (r_success) {
-        *r_success = str_with_null != end;
+        *r_success = consumed > 0;
     }
     return value;
 }
 
 inline int StringRefBase::to_int(bool *r_success) const
 {
-    char *str_with_null = (char *)alloca(m_size + 1);
-    this->unsafe_copy(str_with_null);
-    char *end;
-    int value = std::strtol(str_with_null, &end, 10);
+    int value = 0;
+    StringRef number = parse_detail::strip_number_prefix(m_data, m_size);
+    size_t consumed = number.parse(value);
     if (r_success) {
-        *r_success = str_with_null != end;
+        *r_success = consumed > 0;
     }
     return value;
 }
 
+inline StringSplit StringRefBase::split(char delimiter) const
+{
+    return StringSplit(StringRef(m_data, m_size), delimiter);
+}
+
+inline StringTokens StringRefBase::tokenize(const CharSet &delimiters) const
+{
+    return StringTokens(StringRef(m_data, m_size), delimiters);
+}
+
 inline bool StringRefBase::contains(char c) const
 {
     return this->try_first_index_of(c) >= 0;
@@ -391,12 +839,11 @@ inline size_t StringRefBase::first_index_of(char c, size_t start) const
 
 inline ssize_t StringRefBase::try_first_index_of(char c, size_t start) const
 {
-    for (size_t i = start; i < m_size; i++) {
-        if (m_data[i] == c) {
-            return i;
-        }
+    if (start >= m_size) {
+        return -1;
     }
-    return -1;
+    ssize_t index = find_first_equal(m_data + start, m_size - start, c);
+    return index >= 0 ? index + (ssize_t)start : -1;
 }
 
 }  // namespace bas
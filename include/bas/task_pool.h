@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * A task pool runs small tasks on a fixed set of worker threads.
+ *
+ * Every worker has its own queue. New tasks that are spawned by a worker go
+ * to the back of its queue, and the worker takes tasks from the back as well.
+ * Workers that run out of tasks steal from the front of the queues of other
+ * workers. Since tasks that are spawned first are usually the largest ones
+ * (e.g. the first half of a range that is split recursively), thieves take
+ * big chunks of work and rarely have to steal again.
+ *
+ * Tasks are grouped with a TaskGroup. Waiting for a group does not block the
+ * thread: it runs queued tasks until all tasks of the group are done. This
+ * also makes it possible to wait for a group inside of a task.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "index_range.h"
+#include "vector.h"
+
+namespace bas {
+
+class TaskGroup;
+
+/**
+ * A task calls a function with a pointer to data that is owned by someone
+ * else, and a range that the task should process. The range is unused by
+ * tasks that are not part of a parallel loop.
+ */
+struct Task {
+    void (*function)(void *data, IndexRange range);
+    void *data;
+    IndexRange range;
+    TaskGroup *group;
+};
+
+class TaskPool : NonCopyable, NonMovable {
+  private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /* One queue per worker and one more at the end, that gets the tasks that
+     * are spawned by other threads. */
+    Vector<Queue *> m_queues;
+    Vector<std::thread> m_workers;
+
+    std::atomic<size_t> m_queued_tasks{0};
+    std::atomic<uint32_t> m_sleeping_workers{0};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wakeup;
+
+  public:
+    /**
+     * Start the given amount of worker threads. With zero workers, all tasks
+     * are run by the threads that wait for them.
+     */
+    explicit TaskPool(uint32_t worker_amount);
+    ~TaskPool();
+
+    /**
+     * A pool that is shared by all containers. It has one worker less than
+     * there are hardware threads, because the thread that waits for the
+     * tasks runs them as well.
+     */
+    static TaskPool &global();
+
+    uint32_t worker_amount() const
+    {
+        return (uint32_t)m_workers.size();
+    }
+
+    /**
+     * Queue a task. Usually, TaskGroup::spawn should be used instead.
+     */
+    void push(const Task &task);
+
+    /**
+     * Take a task from the queues and run it. Returns false when no task has
+     * been found.
+     */
+    bool run_one_task();
+
+  private:
+    void worker_main(uint32_t worker_index);
+    bool pop_task(Task &r_task);
+    static void run_task(const Task &task);
+};
+
+/**
+ * Keeps track of a set of tasks, so that one can wait until all of them are
+ * done.
+ */
+class TaskGroup : NonCopyable, NonMovable {
+  private:
+    TaskPool &m_pool;
+    std::atomic<size_t> m_pending_tasks{0};
+
+    friend TaskPool;
+
+  public:
+    explicit TaskGroup(TaskPool &pool = TaskPool::global()) : m_pool(pool)
+    {
+    }
+
+    /**
+     * Asserts that wait has been called when tasks were spawned.
+     */
+    ~TaskGroup()
+    {
+        assert(m_pending_tasks.load() == 0);
+    }
+
+    TaskPool &pool() const
+    {
+        return m_pool;
+    }
+
+    /**
+     * Run the function with the data and range in some thread of the pool.
+     * The data has to stay alive until wait returns.
+     */
+    void spawn(void (*function)(void *data, IndexRange range),
+               void *data,
+               IndexRange range = {})
+    {
+        m_pending_tasks.fetch_add(1, std::memory_order_relaxed);
+        m_pool.push(Task{function, data, range, this});
+    }
+
+    /**
+     * Run the callable in some thread of the pool. The callable is
+     * referenced, not copied, so it has to stay alive until wait returns.
+     */
+    template<typename FuncT> void spawn(const FuncT &func)
+    {
+        this->spawn(
+            [](void *data, IndexRange /*range*/) {
+                (*(const FuncT *)data)();
+            },
+            (void *)&func);
+    }
+
+    /**
+     * Run tasks until all tasks of this group are done.
+     */
+    void wait()
+    {
+        while (m_pending_tasks.load(std::memory_order_acquire) != 0) {
+            if (!m_pool.run_one_task()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+}  // namespace bas
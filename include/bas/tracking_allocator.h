@@ -0,0 +1,271 @@
+#pragma once
+
+/**
+ * A tracking allocator wraps another allocator and records how much memory
+ * is allocated through it. It can be passed as Allocator template parameter
+ * to every container.
+ *
+ * Containers construct their allocators themselves, so the statistics
+ * cannot be owned by the allocator instance. Instead, every tracking
+ * allocator has a tag type, and all allocators with the same tag share one
+ * AllocationStats object. A tag is a struct with a name:
+ *
+ *   struct MeshTag {
+ *       static constexpr const char *name = "mesh";
+ *   };
+ *   Map<int, float, TrackingAllocator<MeshTag>> map;
+ *
+ * The stats of all tags register themselves in a global registry, so that
+ * a long running process can print the memory usage per subsystem.
+ *
+ * Every allocation gets a small header that stores its size, because the
+ * allocator interface does not pass the size to free. The header is not
+ * counted in the statistics.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+#include "allocator.h"
+#include "string_ref.h"
+#include "vector.h"
+
+namespace bas {
+
+class AllocationStats : NonCopyable, NonMovable {
+  public:
+    /* Bucket i counts the allocations with a size in [2^i, 2^(i+1)).
+     * Allocations of zero bytes are counted in the first bucket. */
+    static constexpr uint32_t histogram_size = 48;
+
+  private:
+    const char *m_name;
+    std::atomic<uint64_t> m_live_bytes{0};
+    std::atomic<uint64_t> m_peak_bytes{0};
+    std::atomic<uint64_t> m_allocation_count{0};
+    std::atomic<uint64_t> m_free_count{0};
+    std::atomic<uint64_t> m_size_histogram[histogram_size] = {};
+
+  public:
+    /**
+     * Creates the stats and adds them to the global registry.
+     */
+    explicit AllocationStats(const char *name);
+
+    const char *name() const
+    {
+        return m_name;
+    }
+
+    /**
+     * Called by the allocator. The counters are updated atomically, so
+     * allocators in different threads can share the stats.
+     */
+    void record_allocation(size_t size)
+    {
+        m_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        m_size_histogram[histogram_bucket(size)].fetch_add(
+            1, std::memory_order_relaxed);
+        uint64_t live = m_live_bytes.fetch_add(size,
+                                               std::memory_order_relaxed) +
+                        size;
+        uint64_t peak = m_peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !m_peak_bytes.compare_exchange_weak(
+                                  peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void record_free(size_t size)
+    {
+        m_free_count.fetch_add(1, std::memory_order_relaxed);
+        m_live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /* Bytes that have been allocated and not freed yet. */
+    uint64_t live_bytes() const
+    {
+        return m_live_bytes.load(std::memory_order_relaxed);
+    }
+
+    /* The maximum of live_bytes since the start or the last reset_peak. */
+    uint64_t peak_bytes() const
+    {
+        return m_peak_bytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t allocation_count() const
+    {
+        return m_allocation_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t free_count() const
+    {
+        return m_free_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t live_allocation_count() const
+    {
+        return this->allocation_count() - this->free_count();
+    }
+
+    uint64_t size_histogram(uint32_t bucket) const
+    {
+        assert(bucket < histogram_size);
+        return m_size_histogram[bucket].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Start measuring the peak again from the current live bytes, e.g. at
+     * the start of a request.
+     */
+    void reset_peak()
+    {
+        m_peak_bytes.store(this->live_bytes(), std::memory_order_relaxed);
+    }
+
+    void print(std::ostream &stream = std::cout) const
+    {
+        stream << "Allocation Stats: " << m_name << '\n';
+        stream << "  Live Bytes: " << this->live_bytes() << '\n';
+        stream << "  Peak Bytes: " << this->peak_bytes() << '\n';
+        stream << "  Allocations: " << this->allocation_count() << '\n';
+        stream << "  Frees: " << this->free_count() << '\n';
+        stream << "  Size Histogram:\n";
+        for (uint32_t i = 0; i < histogram_size; i++) {
+            uint64_t count = this->size_histogram(i);
+            if (count > 0) {
+                stream << "    [" << ((uint64_t)1 << i) << ", "
+                       << ((uint64_t)1 << (i + 1)) << "): " << count << '\n';
+            }
+        }
+    }
+
+  private:
+    static uint32_t histogram_bucket(size_t size)
+    {
+        uint32_t bucket = (uint32_t)log2_floor_u((uint64_t)size);
+        return std::min(bucket, histogram_size - 1);
+    }
+};
+
+/**
+ * Knows the stats of all tags that have been used. Stats are never removed,
+ * because they live as long as the program.
+ */
+class AllocationRegistry : NonCopyable, NonMovable {
+  private:
+    mutable std::mutex m_mutex;
+    Vector<AllocationStats *> m_stats;
+
+  public:
+    static AllocationRegistry &global()
+    {
+        static AllocationRegistry registry;
+        return registry;
+    }
+
+    void add(AllocationStats &stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.append(&stats);
+    }
+
+    template<typename FuncT> void foreach_stats(const FuncT &func) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const AllocationStats *stats : m_stats) {
+            func(*stats);
+        }
+    }
+
+    /**
+     * Get the stats with the given name, or null when no allocator with
+     * that tag has been used yet.
+     */
+    const AllocationStats *lookup(StringRef name) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const AllocationStats *stats : m_stats) {
+            if (name == stats->name()) {
+                return stats;
+            }
+        }
+        return nullptr;
+    }
+
+    uint64_t total_live_bytes() const
+    {
+        uint64_t total = 0;
+        this->foreach_stats([&](const AllocationStats &stats) {
+            total += stats.live_bytes();
+        });
+        return total;
+    }
+
+    void print(std::ostream &stream = std::cout) const
+    {
+        this->foreach_stats(
+            [&](const AllocationStats &stats) { stats.print(stream); });
+    }
+};
+
+inline AllocationStats::AllocationStats(const char *name) : m_name(name)
+{
+    AllocationRegistry::global().add(*this);
+}
+
+/* Tag for allocations that are not assigned to a subsystem. */
+struct UntaggedAllocations {
+    static constexpr const char *name = "untagged";
+};
+
+template<typename Tag = UntaggedAllocations,
+         typename Allocator = RawAllocator>
+class TrackingAllocator {
+  private:
+    /* Stored right before the pointer that is returned. */
+    struct Header {
+        size_t size;
+        size_t offset;
+    };
+
+    Allocator m_allocator;
+
+  public:
+    /**
+     * The stats of all allocators with this tag.
+     */
+    static AllocationStats &stats()
+    {
+        static AllocationStats stats(Tag::name);
+        return stats;
+    }
+
+    void *allocate(size_t size, size_t alignment)
+    {
+        size_t offset = std::max(alignment, sizeof(Header));
+        char *buffer = (char *)m_allocator.allocate(
+            size + offset, std::max(alignment, alignof(Header)));
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+        Header *header = (Header *)(buffer + offset) - 1;
+        header->size = size;
+        header->offset = offset;
+        stats().record_allocation(size);
+        return buffer + offset;
+    }
+
+    void free(void *pointer)
+    {
+        if (pointer == nullptr) {
+            return;
+        }
+        Header *header = (Header *)pointer - 1;
+        stats().record_free(header->size);
+        m_allocator.free((char *)pointer - header->offset);
+    }
+};
+
+}  // namespace bas
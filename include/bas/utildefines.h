@@ -5,6 +5,15 @@
 #include <cstdint>
 #include <type_traits>
 
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define BAS_HAS_SSE2
+#endif
+
 namespace bas {
 
 #if defined(__GNUC__)
@@ -19,6 +28,15 @@ namespace bas {
 #    define BAS_UNLIKELY(x) (x)
 #endif
 
+/* Start loading the cache line that contains the address. */
+#if defined(__GNUC__)
+#    define BAS_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && defined(BAS_HAS_SSE2)
+#    define BAS_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+#else
+#    define BAS_PREFETCH(ptr) ((void)(ptr))
+#endif
+
 #define BAS_UNUSED_VAR(x) ((void)x)
 
 using std::size_t;
@@ -93,6 +111,46 @@ template<typename IntT> inline IntT log2_ceil_u(IntT x)
     }
 }
 
+/* Index of the lowest set bit. x must not be zero. */
+inline uint32_t count_trailing_zeros(uint32_t x)
+{
+    assert(x != 0);
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(x);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (uint32_t)index;
+#else
+    uint32_t count = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/* Number of zero bits above the highest set bit. x must not be zero. */
+inline uint32_t count_leading_zeros(uint32_t x)
+{
+    assert(x != 0);
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_clz(x);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return 31 - (uint32_t)index;
+#else
+    uint32_t count = 0;
+    while ((x & 0x80000000u) == 0) {
+        x <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
 template<typename T> inline uintptr_t ptr_to_int(T *ptr)
 {
     return (uintptr_t)ptr;
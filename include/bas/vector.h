@@ -450,12 +450,7 @@ class Vector {
      */
     ssize_t index_try(const T &value) const
     {
-        for (T *current = m_begin; current != m_end; current++) {
-            if (*current == value) {
-                return current - m_begin;
-            }
-        }
-        return -1;
+        return find_first_equal(m_begin, this->size(), value);
     }
 
     /**
@@ -488,12 +483,7 @@ class Vector {
         if (a.size() != b.size()) {
             return false;
         }
-        for (size_t i = 0; i < a.size(); i++) {
-            if (a[i] != b[i]) {
-                return false;
-            }
-        }
-        return true;
+        return arrays_equal(a.begin(), b.begin(), a.size());
     }
 
     const T &operator[](size_t index) const
@@ -539,6 +529,15 @@ class Vector {
         return IndexRange(this->size());
     }
 
+    /**
+     * Get the number of bytes that have been allocated on the heap for the
+     * elements. This is zero when the inline buffer is used.
+     */
+    size_t allocated_bytes() const
+    {
+        return this->is_small() ? 0 : sizeof(T) * this->capacity();
+    }
+
     void print_stats() const
     {
         std::cout << "Small Vector at " << (void *)this << ":" << std::endl;
@@ -579,6 +578,17 @@ class Vector {
 
         size_t size = this->size();
 
+        if constexpr (allocator_has_reallocate<Allocator>::value &&
+                      is_trivially_relocatable<T>::value) {
+            if (!this->is_small()) {
+                m_begin = (T *)m_allocator.reallocate(
+                    m_begin, min_capacity * sizeof(T), alignof(T));
+                m_end = m_begin + size;
+                m_capacity_end = m_begin + min_capacity;
+                return;
+            }
+        }
+
         T *new_array = (T *)m_allocator.allocate(
             min_capacity * (size_t)sizeof(T), std::alignment_of<T>::value);
         uninitialized_relocate_n(m_begin, size, new_array);
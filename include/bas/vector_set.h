@@ -5,6 +5,9 @@
  * continuous array, but every element exists at most once. The insertion order
  * is maintained, as long as there are no deletes. The expected time to check
  * if a value is in the VectorSet is O(1).
+ *
+ * SizeT is the type of hashes and indices. Use uint64_t for sets that can
+ * contain more than about a billion elements.
  */
 
 #include "hash.h"
@@ -15,30 +18,38 @@ namespace bas {
 
 // clang-format off
 
-#define ITER_SLOTS_BEGIN(VALUE, ARRAY, OPTIONAL_CONST, R_SLOT) \
-  uint32_t hash = DefaultHash<T>{}(VALUE); \
-  uint32_t perturb = hash; \
+#define ITER_SLOTS_BEGIN(HASH, ARRAY, OPTIONAL_CONST, R_SLOT) \
+  SizeT hash_copy = HASH; \
+  SizeT perturb = hash_copy; \
   while (true) { \
-    for (uint32_t i = 0; i < 4; i++) {\
-      uint32_t slot_index = (hash + i) & ARRAY.slot_mask(); \
+    for (SizeT i = 0; i < 4; i++) {\
+      SizeT slot_index = (hash_copy + i) & ARRAY.slot_mask(); \
       OPTIONAL_CONST Slot &R_SLOT = ARRAY.item(slot_index);
 
 #define ITER_SLOTS_END \
     } \
     perturb >>= 5; \
-    hash = hash * 5 + 1 + perturb; \
+    hash_copy = hash_copy * 5 + 1 + perturb; \
   } ((void)0)
 
 // clang-format on
 
-template<typename T, typename Allocator = RawAllocator> class VectorSet {
+template<typename T,
+         typename Allocator = RawAllocator,
+         typename Hash = DefaultHash<T>,
+         typename SizeT = uint32_t>
+class VectorSet {
   private:
-    static constexpr int32_t IS_EMPTY = -1;
-    static constexpr int32_t IS_DUMMY = -2;
+    using IndexT = typename std::make_signed<SizeT>::type;
+
+    static constexpr IndexT IS_EMPTY = -1;
+    static constexpr IndexT IS_DUMMY = -2;
+
+    using Hashes = StoredHashes<StoreHashInTable<T>::value, 1, SizeT>;
 
-    class Slot {
+    class Slot : Hashes {
       private:
-        int32_t m_value = IS_EMPTY;
+        IndexT m_value = IS_EMPTY;
 
       public:
         static constexpr uint32_t slots_per_item = 1;
@@ -58,31 +69,49 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
             return m_value == IS_DUMMY;
         }
 
-        bool has_value(const T &value, const Vector<T> &elements) const
+        bool has_value(const T &value,
+                       SizeT hash,
+                       const Vector<T, 4, Allocator> &elements) const
         {
-            return this->is_set() && elements[this->index()] == value;
+            return this->is_set() && this->hash_matches(0, hash) &&
+                   elements[this->index()] == value;
         }
 
-        bool has_index(uint32_t index) const
+        /**
+         * Get the hash of the value this slot points to. It is only
+         * recomputed when hashes are not stored for the value type.
+         */
+        SizeT hash(const Vector<T, 4, Allocator> &elements) const
         {
-            return m_value == (int32_t)index;
+            if constexpr (Hashes::stores_hashes) {
+                return this->stored_hash(0);
+            }
+            else {
+                return fold_hash<SizeT>(Hash{}(elements[this->index()]));
+            }
         }
 
-        uint32_t index() const
+        bool has_index(SizeT index) const
+        {
+            return m_value == (IndexT)index;
+        }
+
+        SizeT index() const
         {
             assert(this->is_set());
-            return (uint32_t)m_value;
+            return (SizeT)m_value;
         }
 
-        int32_t &index_ref()
+        IndexT &index_ref()
         {
             return m_value;
         }
 
-        void set_index(uint32_t index)
+        void set_index(SizeT index, SizeT hash)
         {
             assert(!this->is_set());
-            m_value = (int32_t)index;
+            m_value = (IndexT)index;
+            this->set_hash(0, hash);
         }
 
         void set_dummy()
@@ -92,7 +121,7 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
         }
     };
 
-    using ArrayType = OpenAddressingArray<Slot, 4, Allocator>;
+    using ArrayType = OpenAddressingArray<Slot, 4, Allocator, SizeT>;
     ArrayType m_array;
     Vector<T, 4, Allocator> m_elements;
 
@@ -121,13 +150,48 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
      * Allocate memory such that at least min_usable_slots can be added without
      * having to grow again.
      */
-    void reserve(uint32_t min_usable_slots)
+    void reserve(SizeT min_usable_slots)
     {
         if (m_array.slots_usable() < min_usable_slots) {
             this->grow(min_usable_slots);
         }
     }
 
+    /**
+     * Change the fraction of slots that can be used before the set has to
+     * grow. Higher values reduce the memory usage, lower values make probing
+     * faster. The default is 0.5.
+     */
+    void set_max_load_factor(float factor)
+    {
+        m_array.set_max_load_factor(factor);
+        if (m_array.should_grow()) {
+            this->grow(this->size() + 1);
+        }
+        /* A higher factor makes more slots usable without growing, and
+         * every usable slot needs space for its element. */
+        m_elements.reserve(m_array.slots_usable());
+    }
+
+    float max_load_factor() const
+    {
+        return m_array.max_load_factor();
+    }
+
+    /**
+     * Change by which factor the number of elements can increase before the
+     * set has to grow again. The default is 2.
+     */
+    void set_growth_factor(float factor)
+    {
+        m_array.set_growth_factor(factor);
+    }
+
+    float growth_factor() const
+    {
+        return m_array.growth_factor();
+    }
+
     /**
      * Add a new element. The method assumes that the value did not exist
      * before.
@@ -155,12 +219,27 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     }
 
     /**
-     * Add multiple values. Duplicates will not be inserted.
+     * Add multiple values. Duplicates will not be inserted. The set grows at
+     * most once before the values are inserted.
      */
     void add_multiple(ArrayRef<T> values)
     {
+        this->ensure_can_add_multiple((SizeT)values.size());
+        for (const T &value : values) {
+            this->add__no_grow(value);
+        }
+    }
+
+    /**
+     * Add multiple new values. The set grows at most once before the values
+     * are inserted.
+     * Asserts that none of the values existed before.
+     */
+    void add_multiple_new(ArrayRef<T> values)
+    {
+        this->ensure_can_add_multiple((SizeT)values.size());
         for (const T &value : values) {
-            this->add(value);
+            this->add_new__no_grow(value);
         }
     }
 
@@ -169,12 +248,13 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
      */
     bool contains(const T &value) const
     {
-        ITER_SLOTS_BEGIN(value, m_array, const, slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, const, slot)
         {
             if (slot.is_empty()) {
                 return false;
             }
-            else if (slot.has_value(value, m_elements)) {
+            else if (slot.has_value(value, hash, m_elements)) {
                 return true;
             }
         }
@@ -188,11 +268,12 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     void remove(const T &value)
     {
         assert(this->contains(value));
-        ITER_SLOTS_BEGIN(value, m_array, , slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, , slot)
         {
-            if (slot.has_value(value, m_elements)) {
-                uint32_t old_index = (uint32_t)m_elements.size() - 1;
-                uint32_t new_index = slot.index();
+            if (slot.has_value(value, hash, m_elements)) {
+                SizeT old_index = (SizeT)m_elements.size() - 1;
+                SizeT new_index = slot.index();
 
                 m_elements.remove_and_reorder(new_index);
                 slot.set_dummy();
@@ -215,9 +296,10 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     {
         assert(this->size() > 0);
         T value = m_elements.pop_last();
-        uint32_t old_index = (uint32_t)m_elements.size();
+        SizeT old_index = (SizeT)m_elements.size();
 
-        ITER_SLOTS_BEGIN(value, m_array, , slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, , slot)
         {
             if (slot.has_index(old_index)) {
                 slot.set_dummy();
@@ -232,12 +314,13 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
      * Get the index of the value in the vector. It is assumed that the value
      * is in the vector.
      */
-    uint32_t index(const T &value) const
+    SizeT index(const T &value) const
     {
         assert(this->contains(value));
-        ITER_SLOTS_BEGIN(value, m_array, const, slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, const, slot)
         {
-            if (slot.has_value(value, m_elements)) {
+            if (slot.has_value(value, hash, m_elements)) {
                 return slot.index();
             }
         }
@@ -248,12 +331,13 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
      * Get the index of the value in the vector. If it does not exist return
      * -1.
      */
-    int index_try(const T &value) const
+    IndexT index_try(const T &value) const
     {
-        ITER_SLOTS_BEGIN(value, m_array, const, slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, const, slot)
         {
-            if (slot.has_value(value, m_elements)) {
-                return slot.index();
+            if (slot.has_value(value, hash, m_elements)) {
+                return (IndexT)slot.index();
             }
             else if (slot.is_empty()) {
                 return -1;
@@ -265,7 +349,7 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     /**
      * Get the number of elements in the set-vector.
      */
-    uint32_t size() const
+    SizeT size() const
     {
         return m_array.slots_set();
     }
@@ -280,7 +364,7 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
         return m_elements.end();
     }
 
-    const T &operator[](uint32_t index) const
+    const T &operator[](SizeT index) const
     {
         return m_elements[index];
     }
@@ -295,24 +379,40 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
         return m_elements;
     }
 
+    /**
+     * Compute statistics about the memory usage and the probe lengths. The
+     * memory of the element vector is included. Every value is hashed again,
+     * so this should not be used in performance critical code.
+     */
+    HashTableStats compute_stats() const
+    {
+        HashTableStats stats = m_array.compute_base_stats();
+        for (const T &value : m_elements) {
+            stats.add_probe_length(this->count_collisions(value));
+        }
+        uint64_t element_bytes = m_elements.allocated_bytes();
+        if (element_bytes > 0) {
+            stats.bytes_allocated += element_bytes;
+            stats.bytes_wasted += element_bytes -
+                                  sizeof(T) * (uint64_t)m_elements.size();
+        }
+        return stats;
+    }
+
     void print_stats() const
     {
-        std::cout << "VectorSet at " << (void *)this << ":\n";
-        std::cout << "  Size: " << this->size() << "\n";
-        std::cout << "  Usable Slots: " << m_array.slots_usable() << "\n";
-        std::cout << "  Total Slots: " << m_array.slots_total() << "\n";
-        std::cout << "  Average Collisions: "
-                  << this->compute_average_collisions() << "\n";
+        this->compute_stats().print("VectorSet");
     }
 
   private:
-    void update_slot_index(T &value, uint32_t old_index, uint32_t new_index)
+    void update_slot_index(T &value, SizeT old_index, SizeT new_index)
     {
-        ITER_SLOTS_BEGIN(value, m_array, , slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, , slot)
         {
-            int32_t &stored_index = slot.index_ref();
-            if (stored_index == (int32_t)old_index) {
-                stored_index = new_index;
+            IndexT &stored_index = slot.index_ref();
+            if (stored_index == (IndexT)old_index) {
+                stored_index = (IndexT)new_index;
                 return;
             }
         }
@@ -320,10 +420,10 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     }
 
     template<typename ForwardT>
-    void add_new_in_slot(Slot &slot, ForwardT &&value)
+    void add_new_in_slot(Slot &slot, SizeT hash, ForwardT &&value)
     {
-        uint32_t index = (uint32_t)m_elements.size();
-        slot.set_index(index);
+        SizeT index = (SizeT)m_elements.size();
+        slot.set_index(index, hash);
         m_elements.append_unchecked(std::forward<ForwardT>(value));
         m_array.update__empty_to_set();
     }
@@ -331,54 +431,57 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     void ensure_can_add()
     {
         if (BAS_UNLIKELY(m_array.should_grow())) {
-            this->grow(this->size() + 1);
+            this->grow(m_array.slots_usable_after_grow());
+        }
+    }
+
+    /**
+     * Make sure that the given amount of values can be added without
+     * checking whether the set has to grow before every value. See
+     * Map::ensure_can_add_multiple.
+     */
+    void ensure_can_add_multiple(SizeT amount)
+    {
+        if (!m_array.can_add_without_grow(amount)) {
+            this->grow(std::max(m_array.slots_usable_after_grow(),
+                                this->size() + amount));
         }
     }
 
-    BAS_NOINLINE void grow(uint32_t min_usable_slots)
+    BAS_NOINLINE void grow(SizeT min_usable_slots)
     {
         ArrayType new_array = m_array.init_reserved(min_usable_slots);
 
-        for (uint32_t i = 0; i < (uint32_t)m_elements.size(); i++) {
-            this->add_after_grow(i, new_array);
+        for (const Slot &slot : m_array) {
+            if (slot.is_set()) {
+                this->add_after_grow(
+                    slot.index(), slot.hash(m_elements), new_array);
+            }
         }
 
         m_array = std::move(new_array);
         m_elements.reserve(m_array.slots_usable());
     }
 
-    void add_after_grow(uint32_t index, ArrayType &new_array)
+    void add_after_grow(SizeT index, SizeT hash, ArrayType &new_array)
     {
-        const T &value = m_elements[index];
-        ITER_SLOTS_BEGIN(value, new_array, , slot)
+        ITER_SLOTS_BEGIN(hash, new_array, , slot)
         {
             if (slot.is_empty()) {
-                slot.set_index(index);
+                slot.set_index(index, hash);
                 return;
             }
         }
         ITER_SLOTS_END;
     }
 
-    float compute_average_collisions() const
-    {
-        if (m_elements.size() == 0u) {
-            return 0.0f;
-        }
-
-        uint32_t collisions_sum = 0;
-        for (const T &value : m_elements) {
-            collisions_sum += this->count_collisions(value);
-        }
-        return (float)collisions_sum / (float)m_elements.size();
-    }
-
     uint32_t count_collisions(const T &value) const
     {
         uint32_t collisions = 0;
-        ITER_SLOTS_BEGIN(value, m_array, const, slot)
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, const, slot)
         {
-            if (slot.is_empty() || slot.has_value(value, m_elements)) {
+            if (slot.is_empty() || slot.has_value(value, hash, m_elements)) {
                 return collisions;
             }
             collisions++;
@@ -388,12 +491,19 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
 
     template<typename ForwardT> void add_new__impl(ForwardT &&value)
     {
-        assert(!this->contains(value));
         this->ensure_can_add();
-        ITER_SLOTS_BEGIN(value, m_array, , slot)
+        this->add_new__no_grow(std::forward<ForwardT>(value));
+    }
+
+    template<typename ForwardT> void add_new__no_grow(ForwardT &&value)
+    {
+        assert(!this->contains(value));
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, , slot)
         {
             if (slot.is_empty()) {
-                this->add_new_in_slot(slot, std::forward<ForwardT>(value));
+                this->add_new_in_slot(
+                    slot, hash, std::forward<ForwardT>(value));
                 return;
             }
         }
@@ -403,13 +513,20 @@ template<typename T, typename Allocator = RawAllocator> class VectorSet {
     template<typename ForwardT> bool add__impl(ForwardT &&value)
     {
         this->ensure_can_add();
-        ITER_SLOTS_BEGIN(value, m_array, , slot)
+        return this->add__no_grow(std::forward<ForwardT>(value));
+    }
+
+    template<typename ForwardT> bool add__no_grow(ForwardT &&value)
+    {
+        SizeT hash = fold_hash<SizeT>(Hash{}(value));
+        ITER_SLOTS_BEGIN(hash, m_array, , slot)
         {
             if (slot.is_empty()) {
-                this->add_new_in_slot(slot, std::forward<ForwardT>(value));
+                this->add_new_in_slot(
+                    slot, hash, std::forward<ForwardT>(value));
                 return true;
             }
-            else if (slot.has_value(value, m_elements)) {
+            else if (slot.has_value(value, hash, m_elements)) {
                 return false;
             }
         }
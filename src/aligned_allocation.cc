@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "bas/aligned_allocation.h"
 
@@ -24,6 +25,39 @@ void *aligned_malloc_fallback(size_t size, size_t alignment)
     return int_to_ptr<void>(aligned_ptr);
 }
 
+void *aligned_realloc_fallback(void *pointer,
+                               size_t new_size,
+                               size_t alignment)
+{
+    if (pointer == nullptr) {
+        return aligned_malloc_fallback(new_size, alignment);
+    }
+    uintptr_t aligned_ptr = ptr_to_int(pointer);
+    MemHeader *head = int_to_ptr<MemHeader>(aligned_ptr - sizeof(MemHeader));
+    uintptr_t old_offset = (uintptr_t)head->offset;
+    size_t malloc_size = new_size + sizeof(MemHeader) + alignment - 1;
+    uintptr_t real_ptr = ptr_to_int(
+        realloc(int_to_ptr<void>(aligned_ptr - old_offset), malloc_size));
+    if (real_ptr == 0) {
+        return nullptr;
+    }
+
+    /* The new buffer might have another alignment, then the data has to be
+     * moved within it. */
+    uintptr_t new_aligned_ptr = (real_ptr + sizeof(MemHeader) + alignment -
+                                 1) &
+                                ~(alignment - 1);
+    uintptr_t new_offset = new_aligned_ptr - real_ptr;
+    if (new_offset != old_offset) {
+        memmove(int_to_ptr<void>(new_aligned_ptr),
+                int_to_ptr<void>(real_ptr + old_offset),
+                new_size);
+    }
+    head = int_to_ptr<MemHeader>(new_aligned_ptr - sizeof(MemHeader));
+    head->offset = (int)new_offset;
+    return int_to_ptr<void>(new_aligned_ptr);
+}
+
 void aligned_free_fallback(void *pointer)
 {
     uintptr_t aligned_ptr = ptr_to_int(pointer);
@@ -41,6 +75,14 @@ static void *aligned_malloc_internal(size_t size, size_t alignment)
     return _aligned_malloc_dbg(size, alignment, __FILE__, __LINE__);
 }
 
+static void *aligned_realloc_internal(void *pointer,
+                                      size_t new_size,
+                                      size_t alignment)
+{
+    return _aligned_realloc_dbg(
+        pointer, new_size, alignment, __FILE__, __LINE__);
+}
+
 static void aligned_free_internal(void *pointer)
 {
     _aligned_free_dbg(pointer);
@@ -57,6 +99,24 @@ static void *aligned_malloc_internal(size_t size, size_t alignment)
     return pointer;
 }
 
+/* Buffers from posix_memalign can be passed to realloc, but the result is
+ * only aligned like the result of malloc. */
+static void *aligned_realloc_internal(void *pointer,
+                                      size_t new_size,
+                                      size_t alignment)
+{
+    void *new_pointer = realloc(pointer, new_size);
+    if (new_pointer == nullptr || is_aligned(new_pointer, alignment)) {
+        return new_pointer;
+    }
+    void *aligned_pointer = aligned_malloc_internal(new_size, alignment);
+    if (aligned_pointer != nullptr) {
+        memcpy(aligned_pointer, new_pointer, new_size);
+    }
+    free(new_pointer);
+    return aligned_pointer;
+}
+
 static void aligned_free_internal(void *pointer)
 {
     free(pointer);
@@ -69,6 +129,13 @@ static void *aligned_malloc_internal(size_t size, size_t alignment)
     return aligned_malloc_fallback(size, alignment);
 }
 
+static void *aligned_realloc_internal(void *pointer,
+                                      size_t new_size,
+                                      size_t alignment)
+{
+    return aligned_realloc_fallback(pointer, new_size, alignment);
+}
+
 static void aligned_free_internal(void *pointer)
 {
     return aligned_free_fallback(pointer);
@@ -85,6 +152,15 @@ void *aligned_malloc(size_t size, size_t alignment)
     return aligned_malloc_internal(size, alignment);
 }
 
+void *aligned_realloc(void *pointer, size_t new_size, size_t alignment)
+{
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+
+    return aligned_realloc_internal(pointer, new_size, alignment);
+}
+
 void aligned_free(void *pointer)
 {
     aligned_free_internal(pointer);
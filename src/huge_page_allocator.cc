@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "bas/huge_page_allocator.h"
+
+#if defined(__linux__)
+#    include <sys/mman.h>
+#    define BAS_HAS_MMAP
+#endif
+
+namespace bas {
+
+/* Stored right before every pointer that is returned. */
+struct HugePageHeader {
+    size_t size;
+    /* Distance from the start of the buffer, combined with the flags. The
+     * offset is a multiple of 16, so the lower bits are free. */
+    size_t offset_and_flags;
+};
+
+static constexpr size_t is_mapped_flag = 1;
+static constexpr size_t is_huge_tlb_flag = 2;
+static constexpr size_t flags_mask = 15;
+
+static std::atomic<bool> explicit_huge_pages{false};
+
+void HugePageAllocator::set_use_explicit_huge_pages(bool enabled)
+{
+    explicit_huge_pages.store(enabled, std::memory_order_relaxed);
+}
+
+bool HugePageAllocator::use_explicit_huge_pages()
+{
+    return explicit_huge_pages.load(std::memory_order_relaxed);
+}
+
+static HugePageHeader *header_of(const void *pointer)
+{
+    return (HugePageHeader *)pointer - 1;
+}
+
+static size_t offset_for_alignment(size_t alignment)
+{
+    return std::max(alignment, sizeof(HugePageHeader));
+}
+
+static void *init_header(char *buffer,
+                         size_t size,
+                         size_t offset,
+                         size_t flags)
+{
+    HugePageHeader *header = header_of(buffer + offset);
+    header->size = size;
+    header->offset_and_flags = offset | flags;
+    return buffer + offset;
+}
+
+static void *allocate_with_malloc(size_t size, size_t alignment)
+{
+    size_t offset = offset_for_alignment(alignment);
+    char *buffer = (char *)aligned_malloc(
+        size + offset, std::max(alignment, alignof(HugePageHeader)));
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    return init_header(buffer, size, offset, 0);
+}
+
+bool HugePageAllocator::is_mapped(const void *pointer)
+{
+    return (header_of(pointer)->offset_and_flags & is_mapped_flag) != 0;
+}
+
+#ifdef BAS_HAS_MMAP
+
+static size_t mapped_size_for(size_t size, size_t offset)
+{
+    size_t page = HugePageAllocator::huge_page_size;
+    return (size + offset + page - 1) / page * page;
+}
+
+static void advise_huge_pages(void *buffer, size_t size)
+{
+#    ifdef MADV_HUGEPAGE
+    madvise(buffer, size, MADV_HUGEPAGE);
+#    else
+    BAS_UNUSED_VAR(buffer);
+    BAS_UNUSED_VAR(size);
+#    endif
+}
+
+/**
+ * Map memory that starts at a huge page boundary. More memory than needed
+ * is mapped first, and the unaligned parts at both ends are unmapped again.
+ */
+static char *map_huge_page_aligned(size_t mapped_size)
+{
+    size_t page = HugePageAllocator::huge_page_size;
+    size_t reserved_size = mapped_size + page;
+    void *reserved = mmap(nullptr,
+                          reserved_size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+    if (reserved == MAP_FAILED) {
+        return nullptr;
+    }
+    uintptr_t begin = ptr_to_int(reserved);
+    uintptr_t aligned_begin = (begin + page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t aligned_end = aligned_begin + mapped_size;
+    uintptr_t end = begin + reserved_size;
+    if (aligned_begin > begin) {
+        munmap(reserved, aligned_begin - begin);
+    }
+    if (end > aligned_end) {
+        munmap(int_to_ptr<void>(aligned_end), end - aligned_end);
+    }
+    advise_huge_pages(int_to_ptr<void>(aligned_begin), mapped_size);
+    return int_to_ptr<char>(aligned_begin);
+}
+
+static char *map_huge_tlb(size_t mapped_size)
+{
+#    ifdef MAP_HUGETLB
+    void *buffer = mmap(nullptr,
+                        mapped_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                        -1,
+                        0);
+    return buffer == MAP_FAILED ? nullptr : (char *)buffer;
+#    else
+    BAS_UNUSED_VAR(mapped_size);
+    return nullptr;
+#    endif
+}
+
+void *HugePageAllocator::huge_page_allocate(size_t size, size_t alignment)
+{
+    if (size < min_mapped_size || alignment > huge_page_size) {
+        return allocate_with_malloc(size, alignment);
+    }
+    size_t offset = offset_for_alignment(alignment);
+    size_t mapped_size = mapped_size_for(size, offset);
+    if (use_explicit_huge_pages()) {
+        char *buffer = map_huge_tlb(mapped_size);
+        if (buffer != nullptr) {
+            return init_header(
+                buffer, size, offset, is_mapped_flag | is_huge_tlb_flag);
+        }
+    }
+    char *buffer = map_huge_page_aligned(mapped_size);
+    if (buffer == nullptr) {
+        return allocate_with_malloc(size, alignment);
+    }
+    return init_header(buffer, size, offset, is_mapped_flag);
+}
+
+void HugePageAllocator::huge_page_free(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+    HugePageHeader *header = header_of(pointer);
+    size_t offset = header->offset_and_flags & ~flags_mask;
+    char *buffer = (char *)pointer - offset;
+    if (header->offset_and_flags & is_mapped_flag) {
+        munmap(buffer, mapped_size_for(header->size, offset));
+    }
+    else {
+        aligned_free(buffer);
+    }
+}
+
+/**
+ * Grow or shrink a mapping that is not backed by explicit huge pages. The
+ * kernel can move the mapping without copying. Returns null when this is
+ * not possible.
+ */
+static void *remap(void *pointer, size_t new_size, size_t alignment)
+{
+    HugePageHeader *header = header_of(pointer);
+    size_t flags = header->offset_and_flags & flags_mask;
+    size_t offset = header->offset_and_flags & ~flags_mask;
+    /* The mapping might move to an address that is only aligned to the size
+     * of normal pages. */
+    const size_t min_page_size = 4096;
+    if (flags != is_mapped_flag || alignment > min_page_size ||
+        offset % alignment != 0 ||
+        new_size < HugePageAllocator::min_mapped_size) {
+        return nullptr;
+    }
+
+    size_t old_mapped_size = mapped_size_for(header->size, offset);
+    size_t new_mapped_size = mapped_size_for(new_size, offset);
+    char *buffer = (char *)pointer - offset;
+    if (new_mapped_size != old_mapped_size) {
+        void *new_buffer = mremap(
+            buffer, old_mapped_size, new_mapped_size, MREMAP_MAYMOVE);
+        if (new_buffer == MAP_FAILED) {
+            return nullptr;
+        }
+        buffer = (char *)new_buffer;
+        advise_huge_pages(buffer, new_mapped_size);
+    }
+    header_of(buffer + offset)->size = new_size;
+    return buffer + offset;
+}
+
+#else
+
+void *HugePageAllocator::huge_page_allocate(size_t size, size_t alignment)
+{
+    return allocate_with_malloc(size, alignment);
+}
+
+void HugePageAllocator::huge_page_free(void *pointer)
+{
+    if (pointer != nullptr) {
+        HugePageHeader *header = header_of(pointer);
+        aligned_free((char *)pointer - header->offset_and_flags);
+    }
+}
+
+static void *remap(void * /*pointer*/,
+                   size_t /*new_size*/,
+                   size_t /*alignment*/)
+{
+    return nullptr;
+}
+
+#endif
+
+void *HugePageAllocator::huge_page_reallocate(void *pointer,
+                                              size_t new_size,
+                                              size_t alignment)
+{
+    if (pointer == nullptr) {
+        return huge_page_allocate(new_size, alignment);
+    }
+    if (HugePageAllocator::is_mapped(pointer)) {
+        void *remapped = remap(pointer, new_size, alignment);
+        if (remapped != nullptr) {
+            return remapped;
+        }
+    }
+    void *new_pointer = huge_page_allocate(new_size, alignment);
+    if (new_pointer != nullptr) {
+        memcpy(new_pointer,
+               pointer,
+               std::min(header_of(pointer)->size, new_size));
+        huge_page_free(pointer);
+    }
+    return new_pointer;
+}
+
+}  // namespace bas
@@ -0,0 +1,79 @@
+#include <fstream>
+
+#include "bas/aligned_allocation.h"
+#include "bas/mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define BAS_HAS_MMAP
+#endif
+
+namespace bas {
+
+#ifdef BAS_HAS_MMAP
+
+MappedFile::MappedFile(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+        size_t size = (size_t)file_stat.st_size;
+        void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = (const char *)data;
+            m_size = size;
+        }
+    }
+    /* The mapping stays valid after the file is closed. */
+    ::close(fd);
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr) {
+        munmap((void *)m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const char *path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        return;
+    }
+    size_t size = (size_t)stream.tellg();
+    if (size == 0) {
+        return;
+    }
+    char *data = (char *)aligned_malloc(size, 64);
+    stream.seekg(0);
+    if (!stream.read(data, (std::streamsize)size)) {
+        aligned_free(data);
+        return;
+    }
+    m_data = data;
+    m_size = size;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr) {
+        aligned_free((void *)m_data);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+#endif
+
+}  // namespace bas
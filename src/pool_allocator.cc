@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <mutex>
+
+#include "bas/pool_allocator.h"
+
+namespace bas {
+
+/* The header is as large as the maximum alignment, so that the pointer
+ * after it stays aligned. */
+struct BlockHeader {
+    uint32_t size_class;
+    /* Distance from the buffer that aligned_malloc returned, for blocks that
+     * are not in a pool. */
+    uint32_t large_offset;
+    uint64_t padding;
+};
+
+static_assert(sizeof(BlockHeader) == PoolAllocator::max_pooled_alignment,
+              "The header should keep the alignment of the block.");
+
+static constexpr uint32_t large_size_class = UINT32_MAX;
+static constexpr size_t slab_size = 64 * 1024;
+
+/* Sizes of the blocks in every size class, including the header. The steps
+ * between the sizes grow, so that not more than 25% of a block is wasted
+ * for larger sizes. */
+static constexpr size_t class_sizes[] = {32,   48,   64,   80,   96,   112,
+                                         128,  160,  192,  224,  256,  320,
+                                         384,  448,  512,  640,  768,  896,
+                                         1024, 1280, 1536, 1792, 2048};
+static constexpr uint32_t class_amount = sizeof(class_sizes) /
+                                         sizeof(class_sizes[0]);
+
+static_assert(class_sizes[class_amount - 1] == PoolAllocator::max_pooled_size,
+              "The largest size class should match the maximum size.");
+
+/* Maps the block size, rounded up to a multiple of 16, to a size class. */
+struct SizeClassTable {
+    uint8_t class_by_16_bytes[PoolAllocator::max_pooled_size / 16 + 1] = {};
+
+    constexpr SizeClassTable()
+    {
+        uint32_t size_class = 0;
+        for (size_t i = 0; i <= PoolAllocator::max_pooled_size / 16; i++) {
+            while (class_sizes[size_class] < i * 16) {
+                size_class++;
+            }
+            class_by_16_bytes[i] = (uint8_t)size_class;
+        }
+    }
+};
+
+static constexpr SizeClassTable size_class_table;
+
+static uint32_t size_class_of(size_t block_size)
+{
+    return size_class_table.class_by_16_bytes[(block_size + 15) >> 4];
+}
+
+/* Amount of blocks that is moved between a thread and the shared lists at
+ * once. */
+static uint32_t batch_size(uint32_t size_class)
+{
+    return std::max<uint32_t>(4, (uint32_t)(8192 / class_sizes[size_class]));
+}
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+/* A linked list of free blocks that are moved together. */
+struct FreeList {
+    FreeBlock *first = nullptr;
+    uint32_t size = 0;
+
+    void push(FreeBlock *block)
+    {
+        block->next = first;
+        first = block;
+        size++;
+    }
+
+    FreeBlock *pop()
+    {
+        FreeBlock *block = first;
+        first = block->next;
+        size--;
+        return block;
+    }
+
+    /* Move up to the given amount of blocks from the front of this list to
+     * the front of the other one. */
+    void move_to(FreeList &other, uint32_t amount)
+    {
+        for (uint32_t i = 0; i < amount && first != nullptr; i++) {
+            other.push(this->pop());
+        }
+    }
+};
+
+struct SharedPool {
+    std::mutex mutex;
+    FreeList list;
+};
+
+/* The shared pools are never destructed, because blocks might be freed
+ * during the destruction of other static objects. */
+static SharedPool *shared_pools()
+{
+    static SharedPool *pools = new SharedPool[class_amount];
+    return pools;
+}
+
+/* Plain data, so that it stays accessible until the thread ends. */
+struct ThreadCache {
+    FreeList lists[class_amount];
+    bool is_registered = false;
+    bool has_exited = false;
+};
+
+static thread_local ThreadCache thread_cache;
+
+/* Gives the blocks of a thread back to the shared pools when it exits. */
+struct ThreadCacheReleaser {
+    ~ThreadCacheReleaser()
+    {
+        for (uint32_t size_class = 0; size_class < class_amount;
+             size_class++) {
+            SharedPool &pool = shared_pools()[size_class];
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            FreeList &list = thread_cache.lists[size_class];
+            list.move_to(pool.list, list.size);
+        }
+        thread_cache.has_exited = true;
+    }
+};
+
+static thread_local ThreadCacheReleaser thread_cache_releaser;
+
+static void split_new_slab(uint32_t size_class, FreeList &r_list)
+{
+    size_t block_size = class_sizes[size_class];
+    char *slab = (char *)aligned_malloc(slab_size,
+                                        PoolAllocator::max_pooled_alignment);
+    for (size_t offset = 0; offset + block_size <= slab_size;
+         offset += block_size) {
+        r_list.push((FreeBlock *)(slab + offset));
+    }
+}
+
+/* Called when the list of the thread is empty. */
+static BAS_NOINLINE FreeBlock *take_from_shared_pool(uint32_t size_class)
+{
+    ThreadCache &cache = thread_cache;
+    FreeList taken;
+    {
+        SharedPool &pool = shared_pools()[size_class];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (cache.has_exited) {
+            /* Static objects are destructed after the thread cache. */
+            if (pool.list.size == 0) {
+                split_new_slab(size_class, pool.list);
+            }
+            return pool.list.pop();
+        }
+        pool.list.move_to(taken, batch_size(size_class));
+    }
+    if (taken.size == 0) {
+        split_new_slab(size_class, taken);
+    }
+    if (!cache.is_registered) {
+        /* Accessing the releaser makes sure that it is destructed at the end
+         * of the thread. */
+        (void)&thread_cache_releaser;
+        cache.is_registered = true;
+    }
+    FreeBlock *block = taken.pop();
+    taken.move_to(cache.lists[size_class], taken.size);
+    return block;
+}
+
+static BAS_NOINLINE void give_blocks_to_shared_pool(uint32_t size_class)
+{
+    SharedPool &pool = shared_pools()[size_class];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    FreeList &list = thread_cache.lists[size_class];
+    if (thread_cache.has_exited) {
+        list.move_to(pool.list, list.size);
+    }
+    else {
+        /* Keep the block that has just been freed, because it is probably
+         * still in the cache. */
+        FreeBlock *freed_block = list.pop();
+        list.move_to(pool.list, batch_size(size_class));
+        list.push(freed_block);
+    }
+}
+
+void *PoolAllocator::pool_allocate(size_t size, size_t alignment)
+{
+    size_t block_size = size + sizeof(BlockHeader);
+    if (block_size <= max_pooled_size && alignment <= max_pooled_alignment) {
+        uint32_t size_class = size_class_of(block_size);
+        FreeList &list = thread_cache.lists[size_class];
+        FreeBlock *block = list.size > 0 ?
+                               list.pop() :
+                               take_from_shared_pool(size_class);
+        BlockHeader *header = (BlockHeader *)block;
+        header->size_class = size_class;
+        return header + 1;
+    }
+
+    /* The header is put right before the returned pointer. */
+    size_t offset = std::max(alignment, sizeof(BlockHeader));
+    char *buffer = (char *)aligned_malloc(size + offset, alignment);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    BlockHeader *header = (BlockHeader *)(buffer + offset) - 1;
+    header->size_class = large_size_class;
+    header->large_offset = (uint32_t)offset;
+    return buffer + offset;
+}
+
+void PoolAllocator::pool_free(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+    BlockHeader *header = (BlockHeader *)pointer - 1;
+    uint32_t size_class = header->size_class;
+    if (size_class == large_size_class) {
+        aligned_free((char *)pointer - header->large_offset);
+        return;
+    }
+
+    FreeList &list = thread_cache.lists[size_class];
+    list.push((FreeBlock *)header);
+    if (list.size > 4 * batch_size(size_class) || thread_cache.has_exited) {
+        give_blocks_to_shared_pool(size_class);
+    }
+}
+
+}  // namespace bas
@@ -0,0 +1,135 @@
+#include "bas/task_pool.h"
+
+namespace bas {
+
+/* The pool and queue index of the worker that runs in the current thread, if
+ * any. */
+struct CurrentWorker {
+    const TaskPool *pool = nullptr;
+    uint32_t index = 0;
+};
+
+static thread_local CurrentWorker current_worker;
+
+TaskPool::TaskPool(uint32_t worker_amount)
+{
+    for (uint32_t i = 0; i <= worker_amount; i++) {
+        m_queues.append(new Queue());
+    }
+    for (uint32_t i = 0; i < worker_amount; i++) {
+        m_workers.append(std::thread([this, i]() { this->worker_main(i); }));
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+    for (Queue *queue : m_queues) {
+        assert(queue->tasks.empty());
+        delete queue;
+    }
+}
+
+TaskPool &TaskPool::global()
+{
+    static TaskPool pool([]() {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        return hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }());
+    return pool;
+}
+
+void TaskPool::push(const Task &task)
+{
+    uint32_t queue_index = current_worker.pool == this ?
+                               current_worker.index :
+                               (uint32_t)m_workers.size();
+    Queue &queue = *m_queues[queue_index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    m_queued_tasks.fetch_add(1);
+    if (m_sleeping_workers.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_wakeup.notify_one();
+    }
+}
+
+bool TaskPool::run_one_task()
+{
+    Task task;
+    if (!this->pop_task(task)) {
+        return false;
+    }
+    run_task(task);
+    return true;
+}
+
+/**
+ * A worker takes the newest task from its own queue first. Otherwise, the
+ * oldest task of another queue is stolen.
+ */
+bool TaskPool::pop_task(Task &r_task)
+{
+    if (m_queued_tasks.load() == 0) {
+        return false;
+    }
+
+    uint32_t queue_amount = (uint32_t)m_queues.size();
+    uint32_t own_index = current_worker.pool == this ? current_worker.index :
+                                                       queue_amount - 1;
+    {
+        Queue &queue = *m_queues[own_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            r_task = queue.tasks.back();
+            queue.tasks.pop_back();
+            m_queued_tasks.fetch_sub(1);
+            return true;
+        }
+    }
+    for (uint32_t i = 1; i < queue_amount; i++) {
+        Queue &queue = *m_queues[(own_index + i) % queue_amount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            r_task = queue.tasks.front();
+            queue.tasks.pop_front();
+            m_queued_tasks.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::run_task(const Task &task)
+{
+    task.function(task.data, task.range);
+    task.group->m_pending_tasks.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskPool::worker_main(uint32_t worker_index)
+{
+    current_worker.pool = this;
+    current_worker.index = worker_index;
+    while (!m_stop.load()) {
+        if (this->run_one_task()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping_workers.fetch_add(1);
+        m_wakeup.wait(lock, [&]() {
+            return m_queued_tasks.load() > 0 || m_stop.load();
+        });
+        m_sleeping_workers.fetch_sub(1);
+    }
+}
+
+}  // namespace bas
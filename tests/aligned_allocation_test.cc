@@ -55,3 +55,42 @@ TEST(aligned_allocation, AlignedAllocationFallback)
         test_aligned_allocation_fallback(alignment);
     }
 }
+
+using ReallocFunc = void *(*)(void *, size_t, size_t);
+using FreeFunc = void (*)(void *);
+
+static void test_aligned_realloc(size_t alignment,
+                                 ReallocFunc realloc_func,
+                                 FreeFunc free_func)
+{
+    char *ptr = (char *)realloc_func(nullptr, 10, alignment);
+    EXPECT_TRUE(is_aligned(ptr, alignment));
+    for (int i = 0; i < 10; i++) {
+        ptr[i] = (char)i;
+    }
+    for (size_t size : {100, 5000, 300000, 50}) {
+        ptr = (char *)realloc_func(ptr, size, alignment);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(is_aligned(ptr, alignment));
+        for (int i = 0; i < 10; i++) {
+            EXPECT_EQ(ptr[i], (char)i);
+        }
+    }
+    free_func(ptr);
+}
+
+TEST(aligned_allocation, AlignedRealloc)
+{
+    for (size_t alignment = 1; alignment < 32768; alignment *= 2) {
+        test_aligned_realloc(alignment, aligned_realloc, aligned_free);
+    }
+}
+
+TEST(aligned_allocation, AlignedReallocFallback)
+{
+    for (size_t alignment = 1; alignment < 32768; alignment *= 2) {
+        test_aligned_realloc(alignment,
+                             aligned_realloc_fallback,
+                             aligned_free_fallback);
+    }
+}
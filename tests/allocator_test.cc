@@ -20,3 +20,20 @@ TEST(raw_allocator, AlignedAllocation)
     allocator.free(ptr2);
     allocator.free(ptr3);
 }
+
+TEST(raw_allocator, Reallocate)
+{
+    EXPECT_TRUE(allocator_has_reallocate<RawAllocator>::value);
+    RawAllocator allocator;
+
+    int *ptr = (int *)allocator.allocate(sizeof(int) * 4, 64);
+    for (int i = 0; i < 4; i++) {
+        ptr[i] = i;
+    }
+    ptr = (int *)allocator.reallocate(ptr, sizeof(int) * 100000, 64);
+    EXPECT_TRUE(is_aligned(ptr, 64));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(ptr[i], i);
+    }
+    allocator.free(ptr);
+}
@@ -266,6 +266,17 @@ TEST(array_ref, FirstIndex)
     EXPECT_EQ(a_ref.first_index(2), 3);
 }
 
+TEST(array_ref, MinMax)
+{
+    std::array<int, 5> a = {4, -5, 9, 2, 5};
+    ArrayRef<int> a_ref(a);
+
+    EXPECT_EQ(a_ref.min(), -5);
+    EXPECT_EQ(a_ref.max(), 9);
+    EXPECT_EQ(a_ref.take_front(1).min(), 4);
+    EXPECT_EQ(a_ref.take_front(1).max(), 4);
+}
+
 TEST(array_ref, CastSameSize)
 {
     int value = 0;
@@ -75,6 +75,20 @@ TEST(array, MoveConstructor)
     EXPECT_EQ(new_array[3], 8);
 }
 
+TEST(array, MoveConstructorUniquePtrs)
+{
+    Array<std::unique_ptr<int>, 4> array(3);
+    for (int i = 0; i < 3; i++) {
+        array[i] = std::unique_ptr<int>(new int(i));
+    }
+    Array<std::unique_ptr<int>, 4> new_array(std::move(array));
+    EXPECT_EQ(array.size(), 0);
+    ASSERT_EQ(new_array.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(*new_array[i], i);
+    }
+}
+
 TEST(array, CopyAssignment)
 {
     Array<int> array = {1, 2, 3};
@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+
+#include "bas/char_set.h"
+
+using namespace bas;
+
+TEST(char_set, DefaultConstructor)
+{
+    CharSet set;
+    EXPECT_EQ(set.size(), 0u);
+    EXPECT_FALSE(set.contains('a'));
+    EXPECT_FALSE(set.contains('\0'));
+}
+
+TEST(char_set, InitializerList)
+{
+    CharSet set = {'a', 'b', 'a'};
+    EXPECT_EQ(set.size(), 2u);
+    EXPECT_TRUE(set.contains('a'));
+    EXPECT_TRUE(set.contains('b'));
+    EXPECT_FALSE(set.contains('c'));
+}
+
+TEST(char_set, AllByteValues)
+{
+    CharSet set;
+    for (int i = 0; i < 256; i += 3) {
+        set.add((char)i);
+    }
+    EXPECT_EQ(set.size(), 86u);
+    for (int i = 0; i < 256; i++) {
+        EXPECT_EQ(set.contains((char)i), i % 3 == 0);
+    }
+}
+
+TEST(char_set, Listed)
+{
+    CharSet set("abcdefgh", 8);
+    EXPECT_TRUE(set.is_listed());
+    EXPECT_EQ(set.listed_chars()[7], 'h');
+    set.add('i');
+    EXPECT_FALSE(set.is_listed());
+    EXPECT_TRUE(set.contains('i'));
+}
+
+TEST(char_set, Whitespace)
+{
+    const CharSet &set = CharSet::whitespace();
+    EXPECT_EQ(set.size(), 4u);
+    EXPECT_TRUE(set.contains(' '));
+    EXPECT_TRUE(set.contains('\t'));
+    EXPECT_TRUE(set.contains('\n'));
+    EXPECT_TRUE(set.contains('\r'));
+    EXPECT_FALSE(set.contains('a'));
+}
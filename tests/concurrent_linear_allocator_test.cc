@@ -0,0 +1,71 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "bas/concurrent_linear_allocator.h"
+#include "bas/set.h"
+
+using namespace bas;
+
+TEST(concurrent_linear_allocator, AllocationAlignment)
+{
+    ConcurrentLinearAllocator<> allocator;
+    EXPECT_TRUE(is_aligned(allocator.allocate(10, 4), 4));
+    EXPECT_TRUE(is_aligned(allocator.allocate(10, 8), 8));
+    EXPECT_TRUE(is_aligned(allocator.allocate(10, 64), 64));
+    EXPECT_TRUE(is_aligned(allocator.allocate(10, 1), 1));
+    EXPECT_TRUE(is_aligned(allocator.allocate(10, 128), 128));
+    EXPECT_TRUE(is_aligned(allocator.allocate(5000, 32), 32));
+    EXPECT_TRUE(is_aligned(allocator.allocate(100000000, 256), 256));
+}
+
+TEST(concurrent_linear_allocator, PackedInSameThread)
+{
+    ConcurrentLinearAllocator<> allocator;
+    uintptr_t ptr1 = (uintptr_t)allocator.allocate(10, 4);
+    uintptr_t ptr2 = (uintptr_t)allocator.allocate(10, 4);
+    EXPECT_EQ(ptr2 - ptr1, 12u);
+}
+
+TEST(concurrent_linear_allocator, CopyString)
+{
+    ConcurrentLinearAllocator<> allocator;
+    StringRefNull a = allocator.copy_string("Hello");
+    StringRefNull b = allocator.copy_string("World");
+    EXPECT_EQ(a, "Hello");
+    EXPECT_EQ(b, "World");
+}
+
+TEST(concurrent_linear_allocator, ManyThreads)
+{
+    ConcurrentLinearAllocator<> allocator;
+    const uint32_t thread_amount = 4;
+    const uint32_t allocations_per_thread = 20000;
+    Vector<Vector<uint64_t *>> pointers(thread_amount);
+    Vector<std::thread> threads;
+    for (uint32_t thread = 0; thread < thread_amount; thread++) {
+        threads.append(std::thread([&, thread]() {
+            for (uint32_t i = 0; i < allocations_per_thread; i++) {
+                /* Mix small allocations with some that are too large for
+                 * the chunk of the thread. */
+                size_t size = (i % 100 == 0) ? 8000 : 8;
+                uint64_t *value = (uint64_t *)allocator.allocate(size, 8);
+                *value = (uint64_t)thread * allocations_per_thread + i;
+                pointers[thread].append(value);
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    Set<uint64_t *> unique_pointers;
+    for (uint32_t thread = 0; thread < thread_amount; thread++) {
+        for (uint32_t i = 0; i < allocations_per_thread; i++) {
+            uint64_t *value = pointers[thread][i];
+            EXPECT_EQ(*value, (uint64_t)thread * allocations_per_thread + i);
+            unique_pointers.add(value);
+        }
+    }
+    EXPECT_EQ(unique_pointers.size(), thread_amount * allocations_per_thread);
+}
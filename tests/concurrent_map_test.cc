@@ -0,0 +1,135 @@
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "bas/concurrent_map.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+TEST(concurrent_map, DefaultConstructor)
+{
+    ConcurrentMap<int, float> map;
+    EXPECT_EQ(map.size(), 0u);
+    EXPECT_FALSE(map.contains(4));
+    EXPECT_EQ(map.lookup_ptr(4), nullptr);
+}
+
+TEST(concurrent_map, AddAndLookup)
+{
+    ConcurrentMap<int, float> map;
+    EXPECT_TRUE(map.add(2, 5.0f));
+    EXPECT_TRUE(map.add(4, 1.0f));
+    EXPECT_FALSE(map.add(2, 7.0f));
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.lookup(2), 5.0f);
+    EXPECT_EQ(map.lookup(4), 1.0f);
+    EXPECT_EQ(map.lookup_default(3, 9.0f), 9.0f);
+}
+
+TEST(concurrent_map, GrowKeepsReferences)
+{
+    ConcurrentMap<uint32_t, std::string> map;
+    map.add(0, "zero");
+    const std::string &zero = map.lookup(0);
+    for (uint32_t i = 1; i < 10000; i++) {
+        map.add(i, std::to_string(i));
+    }
+    EXPECT_EQ(map.size(), 10000u);
+    EXPECT_EQ(&map.lookup(0), &zero);
+    for (uint32_t i = 1; i < 10000; i++) {
+        EXPECT_EQ(map.lookup(i), std::to_string(i));
+    }
+}
+
+TEST(concurrent_map, LookupOrAdd)
+{
+    ConcurrentMap<std::string, int> map;
+    int calls = 0;
+    auto create = [&]() { return ++calls; };
+    EXPECT_EQ(map.lookup_or_add("a", create), 1);
+    EXPECT_EQ(map.lookup_or_add("b", create), 2);
+    EXPECT_EQ(map.lookup_or_add("a", create), 1);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(concurrent_map, ForeachItem)
+{
+    ConcurrentMap<int, int> map(100);
+    for (int i = 0; i < 100; i++) {
+        map.add(i, i * 2);
+    }
+    int sum = 0;
+    map.foreach_item([&](int key, int value) {
+        EXPECT_EQ(value, key * 2);
+        sum += key;
+    });
+    EXPECT_EQ(sum, 4950);
+}
+
+TEST(concurrent_map, ParallelAddSameKeys)
+{
+    ConcurrentMap<uint32_t, uint32_t> map;
+    const uint32_t thread_amount = 8;
+    const uint32_t key_amount = 20000;
+    Vector<uint32_t> added(thread_amount);
+    Vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_amount; t++) {
+        threads.append(std::thread([&, t]() {
+            uint32_t amount = 0;
+            for (uint32_t i = 0; i < key_amount; i++) {
+                /* Every thread adds the keys in a different order. */
+                uint32_t key = (i * 7919 + t * 104729) % key_amount;
+                amount += map.add(key, t) ? 1 : 0;
+                EXPECT_TRUE(map.contains(key));
+            }
+            added[t] = amount;
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    uint32_t total_added = 0;
+    for (uint32_t amount : added) {
+        total_added += amount;
+    }
+    EXPECT_EQ(total_added, key_amount);
+    EXPECT_EQ(map.size(), key_amount);
+    for (uint32_t i = 0; i < key_amount; i++) {
+        EXPECT_LT(map.lookup(i), thread_amount);
+    }
+}
+
+TEST(concurrent_map, ParallelReadWhileGrowing)
+{
+    ConcurrentMap<uint32_t, uint32_t> map;
+    const uint32_t key_amount = 50000;
+    std::atomic<uint32_t> added{0};
+
+    std::thread writer([&]() {
+        for (uint32_t i = 0; i < key_amount; i++) {
+            map.add(i, i + 1);
+            added.store(i + 1, std::memory_order_release);
+        }
+    });
+    Vector<std::thread> readers;
+    for (uint32_t t = 0; t < 4; t++) {
+        readers.append(std::thread([&]() {
+            while (added.load(std::memory_order_acquire) < key_amount) {
+                uint32_t known = added.load(std::memory_order_acquire);
+                for (uint32_t i = 0; i < known; i += 97) {
+                    const uint32_t *value = map.lookup_ptr(i);
+                    ASSERT_NE(value, nullptr);
+                    ASSERT_EQ(*value, i + 1);
+                }
+            }
+        }));
+    }
+    writer.join();
+    for (std::thread &thread : readers) {
+        thread.join();
+    }
+    EXPECT_EQ(map.size(), key_amount);
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include "bas/control_group.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+static Vector<uint32_t> mask_to_vector(SlotMask mask)
+{
+    Vector<uint32_t> offsets;
+    for (uint32_t offset : mask) {
+        offsets.append(offset);
+    }
+    return offsets;
+}
+
+TEST(control_group, DefaultIsEmpty)
+{
+    ControlGroup group;
+    EXPECT_EQ(mask_to_vector(group.match_empty()).size(), 16u);
+    EXPECT_FALSE(group.match_set().has_any());
+    EXPECT_TRUE(group.is_empty(0));
+    EXPECT_TRUE(group.is_empty(15));
+}
+
+TEST(control_group, MatchFragment)
+{
+    ControlGroup group;
+    group.set(2, 7);
+    group.set(5, 100);
+    group.set(11, 7);
+
+    Vector<uint32_t> offsets = mask_to_vector(group.match(7));
+    EXPECT_EQ(offsets.size(), 2u);
+    EXPECT_EQ(offsets[0], 2u);
+    EXPECT_EQ(offsets[1], 11u);
+
+    EXPECT_EQ(group.match(100).first(), 5u);
+    EXPECT_FALSE(group.match(0).has_any());
+    EXPECT_EQ(mask_to_vector(group.match_set()).size(), 3u);
+    EXPECT_EQ(mask_to_vector(group.match_empty()).size(), 13u);
+}
+
+TEST(control_group, Dummy)
+{
+    ControlGroup group;
+    group.set(3, 42);
+    group.set_dummy(3);
+    EXPECT_TRUE(group.is_dummy(3));
+    EXPECT_FALSE(group.is_set(3));
+    EXPECT_FALSE(group.is_empty(3));
+    EXPECT_FALSE(group.match(42).has_any());
+    EXPECT_FALSE(group.match_set().has_any());
+    EXPECT_EQ(mask_to_vector(group.match_empty()).size(), 15u);
+}
+
+TEST(control_group, FragmentIsInRange)
+{
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_LT(ControlGroup::fragment(i * 7919u), 128u);
+    }
+}
+
+TEST(control_group, Fragment64IsInRange)
+{
+    for (uint64_t i = 0; i < 1000; i++) {
+        EXPECT_LT(ControlGroup::fragment(i << 40), 128u);
+    }
+    EXPECT_NE(ControlGroup::fragment((uint64_t)1 << 40),
+              ControlGroup::fragment((uint64_t)2 << 40));
+}
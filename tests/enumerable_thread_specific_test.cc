@@ -0,0 +1,64 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "bas/enumerable_thread_specific.h"
+#include "bas/linear_allocator.h"
+
+using namespace bas;
+
+TEST(enumerable_thread_specific, SameInstanceInSameThread)
+{
+    EnumerableThreadSpecific<int> values;
+    EXPECT_EQ(values.size(), 0u);
+    values.local() = 5;
+    EXPECT_EQ(values.local(), 5);
+    EXPECT_EQ(values.size(), 1u);
+}
+
+TEST(enumerable_thread_specific, InstancePerThread)
+{
+    EnumerableThreadSpecific<uint64_t> sums;
+    Vector<std::thread> threads;
+    for (uint32_t thread = 0; thread < 4; thread++) {
+        threads.append(std::thread([&sums, thread]() {
+            for (uint64_t i = 0; i < 1000; i++) {
+                sums.local() += thread;
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sums.size(), 4u);
+    uint64_t total = 0;
+    sums.foreach([&](uint64_t sum) {
+        EXPECT_EQ(sum % 1000, 0u);
+        total += sum;
+    });
+    EXPECT_EQ(total, 6000u);
+}
+
+TEST(enumerable_thread_specific, PerThreadArenas)
+{
+    EnumerableThreadSpecific<LinearAllocator<>> allocators;
+    Vector<std::thread> threads;
+    for (uint32_t thread = 0; thread < 3; thread++) {
+        threads.append(std::thread([&allocators]() {
+            LinearAllocator<> &allocator = allocators.local();
+            for (int i = 0; i < 100; i++) {
+                *allocator.construct<int>() = i;
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(allocators.size(), 3u);
+}
+
+TEST(enumerable_thread_specific, InstancesAreAligned)
+{
+    EnumerableThreadSpecific<char> values;
+    EXPECT_TRUE(is_aligned(&values.local(), 64));
+}
@@ -0,0 +1,199 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "bas/frozen_map.h"
+#include "bas/mapped_file.h"
+
+using namespace bas;
+
+/* Copy what has been written into an aligned buffer, like a mapped file. */
+class FrozenBuffer {
+  private:
+    Vector<uint64_t> m_buffer;
+    const char *m_start;
+    size_t m_size;
+
+  public:
+    explicit FrozenBuffer(const std::string &data)
+        : m_buffer(data.size() / sizeof(uint64_t) + 8), m_size(data.size())
+    {
+        char *begin = (char *)m_buffer.begin();
+        char *aligned = begin + (64 - ptr_to_int(begin) % 64) % 64;
+        std::copy(data.begin(), data.end(), aligned);
+        m_start = aligned;
+    }
+
+    ArrayRef<char> buffer() const
+    {
+        return ArrayRef<char>(m_start, m_size);
+    }
+};
+
+TEST(frozen_map, LookupAfterWrite)
+{
+    Map<int, float> map;
+    for (int i = 0; i < 1000; i++) {
+        map.add_new(i * 3, (float)i);
+    }
+    map.remove(30);
+
+    std::ostringstream stream;
+    EXPECT_TRUE((FrozenMap<int, float>::write(stream, map)));
+    FrozenBuffer data(stream.str());
+    ASSERT_TRUE((FrozenMap<int, float>::is_valid(data.buffer())));
+
+    FrozenMap<int, float> frozen(data.buffer());
+    EXPECT_EQ(frozen.size(), 999);
+    EXPECT_FALSE(frozen.is_empty());
+    for (int i = 0; i < 1000; i++) {
+        if (i == 10) {
+            EXPECT_FALSE(frozen.contains(30));
+            continue;
+        }
+        EXPECT_EQ(frozen.lookup(i * 3), (float)i);
+        EXPECT_EQ(frozen.lookup_ptr(i * 3 + 1), nullptr);
+    }
+    EXPECT_EQ(frozen.lookup_default(-1, 5.0f), 5.0f);
+
+    int count = 0;
+    frozen.foreach_item([&](int key, float value) {
+        EXPECT_EQ(key, (int)value * 3);
+        count++;
+    });
+    EXPECT_EQ(count, 999);
+}
+
+TEST(frozen_map, EmptyMap)
+{
+    Map<int, int> map;
+    std::ostringstream stream;
+    FrozenMap<int, int>::write(stream, map);
+    FrozenBuffer data(stream.str());
+    FrozenMap<int, int> frozen(data.buffer());
+    EXPECT_TRUE(frozen.is_empty());
+    EXPECT_FALSE(frozen.contains(0));
+}
+
+TEST(frozen_map, OtherAllocatorAndSizeType)
+{
+    Map<uint64_t, uint64_t, RawAllocator, DefaultHash<uint64_t>, uint64_t>
+        map;
+    for (uint64_t i = 0; i < 100; i++) {
+        map.add_new(i << 40, i);
+    }
+    std::ostringstream stream;
+    FrozenMap<uint64_t, uint64_t, DefaultHash<uint64_t>, uint64_t>::write(
+        stream, map);
+    FrozenBuffer data(stream.str());
+    FrozenMap<uint64_t, uint64_t, DefaultHash<uint64_t>, uint64_t> frozen(
+        data.buffer());
+    EXPECT_EQ(frozen.size(), 100);
+    EXPECT_EQ(frozen.lookup((uint64_t)42 << 40), 42);
+    EXPECT_FALSE((FrozenMap<uint64_t, uint64_t>::is_valid(data.buffer())));
+}
+
+TEST(frozen_map, RejectInvalidBuffers)
+{
+    Map<int, int> map;
+    map.add_new(1, 2);
+    std::ostringstream stream;
+    FrozenMap<int, int>::write(stream, map);
+    std::string data = stream.str();
+
+    EXPECT_TRUE((FrozenMap<int, int>::is_valid(FrozenBuffer(data).buffer())));
+    EXPECT_FALSE((FrozenMap<int16_t, int>::is_valid(
+        FrozenBuffer(data).buffer())));
+    EXPECT_FALSE((FrozenMap<int, int64_t>::is_valid(
+        FrozenBuffer(data).buffer())));
+    EXPECT_FALSE((FrozenSet<int>::is_valid(FrozenBuffer(data).buffer())));
+    EXPECT_FALSE((FrozenMap<int, int>::is_valid(
+        FrozenBuffer(data.substr(0, data.size() - 1)).buffer())));
+    EXPECT_FALSE((FrozenMap<int, int>::is_valid(
+        FrozenBuffer(data.substr(0, 10)).buffer())));
+
+    std::string corrupted = data;
+    corrupted[0] = 'X';
+    EXPECT_FALSE(
+        (FrozenMap<int, int>::is_valid(FrozenBuffer(corrupted).buffer())));
+
+    /* The items have to be aligned. */
+    FrozenBuffer shifted(" " + data);
+    EXPECT_FALSE((FrozenMap<int, int>::is_valid(shifted.buffer().drop_front(
+        1))));
+}
+
+TEST(frozen_map, MappedFile)
+{
+    std::string path = testing::TempDir() + "bas_frozen_map_test.bin";
+    {
+        Map<int, int> map;
+        for (int i = 0; i < 10000; i++) {
+            map.add_new(i, -i);
+        }
+        std::ofstream stream(path, std::ios::binary);
+        EXPECT_TRUE((FrozenMap<int, int>::write(stream, map)));
+    }
+    MappedFile file(path.c_str());
+    ASSERT_TRUE(file.is_open());
+    ASSERT_TRUE((FrozenMap<int, int>::is_valid(file.buffer())));
+    FrozenMap<int, int> frozen(file.buffer());
+    EXPECT_EQ(frozen.size(), 10000);
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_EQ(frozen.lookup(i), -i);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(frozen_set, ContainsAfterWrite)
+{
+    Set<uint32_t> set;
+    for (uint32_t i = 0; i < 500; i++) {
+        set.add_new(i * i);
+    }
+    std::ostringstream stream;
+    EXPECT_TRUE(FrozenSet<uint32_t>::write(stream, set));
+    FrozenBuffer data(stream.str());
+    ASSERT_TRUE(FrozenSet<uint32_t>::is_valid(data.buffer()));
+
+    FrozenSet<uint32_t> frozen(data.buffer());
+    EXPECT_EQ(frozen.size(), 500);
+    EXPECT_TRUE(frozen.contains(49));
+    EXPECT_FALSE(frozen.contains(50));
+    uint64_t sum = 0;
+    frozen.foreach_value([&](uint32_t value) { sum += value; });
+    uint64_t expected_sum = 0;
+    for (uint32_t value : set) {
+        expected_sum += value;
+    }
+    EXPECT_EQ(sum, expected_sum);
+}
+
+TEST(frozen_string_map, LookupAfterWrite)
+{
+    StringMap<int> map;
+    for (int i = 0; i < 300; i++) {
+        map.add_new("key_" + std::to_string(i), i);
+    }
+    std::ostringstream stream;
+    EXPECT_TRUE(FrozenStringMap<int>::write(stream, map));
+    FrozenBuffer data(stream.str());
+    ASSERT_TRUE(FrozenStringMap<int>::is_valid(data.buffer()));
+
+    FrozenStringMap<int> frozen(data.buffer());
+    EXPECT_EQ(frozen.size(), 300);
+    EXPECT_EQ(frozen.lookup("key_0"), 0);
+    EXPECT_EQ(frozen.lookup("key_123"), 123);
+    EXPECT_FALSE(frozen.contains("key_300"));
+    EXPECT_FALSE(frozen.contains(""));
+    EXPECT_EQ(frozen.lookup_default("other", -1), -1);
+
+    int count = 0;
+    frozen.foreach_item([&](StringRefNull key, int value) {
+        EXPECT_EQ(key, "key_" + std::to_string(value));
+        count++;
+    });
+    EXPECT_EQ(count, 300);
+}
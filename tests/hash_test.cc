@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include "bas/hash.h"
+#include "bas/map.h"
+#include "bas/set.h"
+#include "bas/string_map.h"
+#include "bas/vector_set.h"
+
+using namespace bas;
+
+TEST(hash, HashBytesIsDeterministic)
+{
+    std::string str = "https://example.com/some/long/path?with=a&query=string";
+    EXPECT_EQ(hash_bytes(str.data(), str.size()),
+              hash_bytes(str.data(), str.size()));
+    EXPECT_NE(hash_bytes(str.data(), str.size(), 0),
+              hash_bytes(str.data(), str.size(), 1));
+}
+
+TEST(hash, HashBytesDependsOnEveryByte)
+{
+    char buffer[100] = {0};
+    Set<uint64_t> hashes;
+    for (size_t size = 0; size <= 100; size++) {
+        hashes.add_new(hash_bytes(buffer, size));
+    }
+    for (size_t i = 0; i < 100; i++) {
+        buffer[i] = 1;
+        hashes.add_new(hash_bytes(buffer, 100));
+        buffer[i] = 0;
+    }
+    EXPECT_EQ(hashes.size(), 201u);
+}
+
+TEST(hash, StringTypesHashEqually)
+{
+    std::string str = "hello world";
+    uint64_t hash = DefaultHash<std::string>{}(str);
+    EXPECT_EQ(DefaultHash<StringRef>{}(StringRef(str)), hash);
+    EXPECT_EQ(DefaultHash<StringRefNull>{}(StringRefNull(str)), hash);
+}
+
+TEST(hash, LargeIntegersUseUpperBits)
+{
+    uint64_t a = (uint64_t)1 << 40;
+    uint64_t b = (uint64_t)1 << 41;
+    EXPECT_NE(DefaultHash<uint64_t>{}(a), DefaultHash<uint64_t>{}(b));
+    EXPECT_EQ(DefaultHash<uint64_t>{}(5), 5u);
+    EXPECT_NE(DefaultHash<int64_t>{}(-1), DefaultHash<int64_t>{}(0));
+}
+
+TEST(hash, FoldHash)
+{
+    uint64_t hash = ((uint64_t)3 << 32) | 5;
+    EXPECT_EQ(fold_hash<uint64_t>(hash), hash);
+    EXPECT_NE(fold_hash<uint32_t>(hash), 5u);
+    EXPECT_EQ(fold_hash<uint32_t>((uint64_t)5), 5u);
+    EXPECT_EQ(fold_hash<uint64_t>(5u), 5u);
+}
+
+TEST(hash, MixedHashSpreadsBits)
+{
+    MixedHash<uint32_t> hash;
+    EXPECT_NE(hash(1) & 0xFF, hash(2) & 0xFF);
+    EXPECT_NE(MixedHash<uint64_t>{}(0), MixedHash<uint64_t>{}(1));
+}
+
+TEST(hash, ContainersWithCustomHash)
+{
+    Map<uint32_t, int, RawAllocator, MixedHash<uint32_t>> map;
+    Set<uint32_t, RawAllocator, MixedHash<uint32_t>> set;
+    VectorSet<uint32_t, RawAllocator, MixedHash<uint32_t>> vector_set;
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.add_new(i << 20, (int)i);
+        set.add_new(i << 20);
+        vector_set.add_new(i << 20);
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup(i << 20), (int)i);
+        EXPECT_TRUE(set.contains(i << 20));
+        EXPECT_EQ(vector_set.index(i << 20), i);
+    }
+}
+
+struct FirstCharHash {
+    uint32_t operator()(StringRef str) const
+    {
+        return str.size() > 0 ? (uint32_t)str[0] : 0;
+    }
+};
+
+TEST(hash, StringMapWithCustomHash)
+{
+    StringMap<int, RawAllocator, FirstCharHash> map;
+    map.add_new("apple", 1);
+    map.add_new("avocado", 2);
+    map.add_new("banana", 3);
+    EXPECT_EQ(map.lookup("apple"), 1);
+    EXPECT_EQ(map.lookup("avocado"), 2);
+    EXPECT_EQ(map.lookup("banana"), 3);
+    EXPECT_FALSE(map.contains("apricot"));
+}
@@ -0,0 +1,91 @@
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "bas/huge_page_allocator.h"
+#include "bas/map.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+TEST(huge_page_allocator, SmallAllocation)
+{
+    HugePageAllocator allocator;
+    void *pointer = allocator.allocate(100, 32);
+    EXPECT_TRUE(is_aligned(pointer, 32));
+    EXPECT_FALSE(HugePageAllocator::is_mapped(pointer));
+    memset(pointer, 1, 100);
+    allocator.free(pointer);
+    allocator.free(nullptr);
+}
+
+TEST(huge_page_allocator, LargeAllocation)
+{
+    HugePageAllocator allocator;
+    size_t size = 5 * HugePageAllocator::min_mapped_size + 123;
+    for (size_t alignment : {8, 64, 4096}) {
+        char *pointer = (char *)allocator.allocate(size, alignment);
+        ASSERT_NE(pointer, nullptr);
+        EXPECT_TRUE(is_aligned(pointer, alignment));
+#ifdef __linux__
+        EXPECT_TRUE(HugePageAllocator::is_mapped(pointer));
+#endif
+        memset(pointer, 2, size);
+        EXPECT_EQ(pointer[size - 1], 2);
+        allocator.free(pointer);
+    }
+}
+
+TEST(huge_page_allocator, ReallocateKeepsContent)
+{
+    HugePageAllocator allocator;
+    uint32_t *values = (uint32_t *)allocator.allocate(1000 * 4, 4);
+    for (uint32_t i = 0; i < 1000; i++) {
+        values[i] = i;
+    }
+    /* From a small buffer to a mapped one, then grow the mapping. */
+    for (uint32_t amount : {1u << 20, 1u << 23, 1u << 21}) {
+        values = (uint32_t *)allocator.reallocate(values, amount * 4, 4);
+        ASSERT_NE(values, nullptr);
+        for (uint32_t i = 0; i < 1000; i++) {
+            EXPECT_EQ(values[i], i);
+        }
+        values[amount - 1] = amount;
+        EXPECT_EQ(values[amount - 1], amount);
+    }
+    values = (uint32_t *)allocator.reallocate(values, 2000 * 4, 4);
+    EXPECT_EQ(values[999], 999u);
+    allocator.free(values);
+}
+
+TEST(huge_page_allocator, ExplicitHugePagesFallBack)
+{
+    HugePageAllocator::set_use_explicit_huge_pages(true);
+    EXPECT_TRUE(HugePageAllocator::use_explicit_huge_pages());
+    HugePageAllocator allocator;
+    size_t size = 3 * HugePageAllocator::huge_page_size;
+    char *pointer = (char *)allocator.allocate(size, 8);
+    ASSERT_NE(pointer, nullptr);
+    memset(pointer, 3, size);
+    pointer = (char *)allocator.reallocate(pointer, size * 2, 8);
+    EXPECT_EQ(pointer[size - 1], 3);
+    allocator.free(pointer);
+    HugePageAllocator::set_use_explicit_huge_pages(false);
+}
+
+TEST(huge_page_allocator, Containers)
+{
+    Vector<uint32_t, 4, HugePageAllocator> vector;
+    for (uint32_t i = 0; i < 2000000; i++) {
+        vector.append(i);
+    }
+    for (uint32_t i = 0; i < 2000000; i += 1000) {
+        EXPECT_EQ(vector[i], i);
+    }
+
+    Map<uint32_t, uint32_t, HugePageAllocator> map;
+    for (uint32_t i = 0; i < 200000; i++) {
+        map.add_new(i, i + 1);
+    }
+    EXPECT_EQ(map.lookup(199999), 200000u);
+}
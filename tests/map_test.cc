@@ -222,6 +222,18 @@ TEST(map, MoveConstructorSmall)
     EXPECT_EQ(map1.lookup_ptr(4), nullptr);
 }
 
+TEST(map, MoveConstructorSmallUniquePtrs)
+{
+    Map<int, std::unique_ptr<int>> map1;
+    map1.add_new(1, std::unique_ptr<int>(new int(10)));
+    map1.add_new(2, std::unique_ptr<int>(new int(20)));
+    Map<int, std::unique_ptr<int>> map2(std::move(map1));
+    EXPECT_EQ(map2.size(), 2u);
+    EXPECT_EQ(*map2.lookup(1), 10);
+    EXPECT_EQ(*map2.lookup(2), 20);
+    EXPECT_EQ(map1.size(), 0u);
+}
+
 TEST(map, MoveConstructorLarge)
 {
     Map<int, float> map1;
@@ -286,3 +298,502 @@ TEST(map, UniquePtrValue)
     EXPECT_EQ(map.lookup(1).get(), value1_ptr);
     EXPECT_EQ(map.lookup_ptr(100), nullptr);
 }
+
+TEST(map, ManyKeysWithSameLowBits)
+{
+    Map<uint32_t, uint32_t> map;
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.add_new(i << 16, i);
+    }
+    EXPECT_EQ(map.size(), 1000u);
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup(i << 16), i);
+        EXPECT_FALSE(map.contains((i << 16) + 1));
+    }
+}
+
+TEST(map, RemoveAndAddAgain)
+{
+    Map<int, int> map;
+    for (int i = 0; i < 500; i++) {
+        map.add_new(i, i);
+    }
+    for (int i = 0; i < 500; i += 2) {
+        map.remove(i);
+    }
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(map.contains(i), i % 2 == 1);
+    }
+    for (int i = 0; i < 500; i += 2) {
+        EXPECT_TRUE(map.add(i, -i));
+    }
+    EXPECT_EQ(map.size(), 500u);
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(map.lookup(i), (i % 2 == 1) ? i : -i);
+    }
+}
+
+struct HashCountingKey {
+    int value;
+    static int hash_calls;
+
+    friend bool operator==(const HashCountingKey &a, const HashCountingKey &b)
+    {
+        return a.value == b.value;
+    }
+};
+
+int HashCountingKey::hash_calls = 0;
+
+namespace bas {
+template<> struct DefaultHash<HashCountingKey> {
+    uint32_t operator()(const HashCountingKey &key) const
+    {
+        HashCountingKey::hash_calls++;
+        return (uint32_t)key.value;
+    }
+};
+
+template<> struct StoreHashInTable<HashCountingKey> {
+    static constexpr bool value = true;
+};
+}  // namespace bas
+
+TEST(map, StoredHashesAreReusedWhenGrowing)
+{
+    HashCountingKey::hash_calls = 0;
+    Map<HashCountingKey, int> map;
+    for (int i = 0; i < 1000; i++) {
+        map.add({i}, i);
+    }
+    EXPECT_EQ(HashCountingKey::hash_calls, 1000);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup({i}), i);
+    }
+    EXPECT_FALSE(map.contains({1000}));
+}
+
+TEST(map, StringKeys)
+{
+    Map<std::string, int> map;
+    for (int i = 0; i < 100; i++) {
+        map.add_new(std::to_string(i), i);
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(map.lookup(std::to_string(i)), i);
+    }
+    EXPECT_FALSE(map.contains("100"));
+    map.remove("50");
+    EXPECT_FALSE(map.contains("50"));
+    EXPECT_EQ(map.size(), 99u);
+}
+
+TEST(map, SizeT64)
+{
+    Map<uint64_t, int, RawAllocator, DefaultHash<uint64_t>, uint64_t> map;
+    for (int i = 0; i < 1000; i++) {
+        map.add_new((uint64_t)i << 40, i);
+    }
+    uint64_t size = map.size();
+    EXPECT_EQ(size, 1000u);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup((uint64_t)i << 40), i);
+    }
+    EXPECT_FALSE(map.contains(1));
+    int sum = 0;
+    for (int value : map.values()) {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+}
+
+TEST(map, MaxLoadFactor)
+{
+    Map<uint64_t, uint32_t> map;
+    map.set_max_load_factor(0.875f);
+    EXPECT_EQ(map.max_load_factor(), 0.875f);
+    for (uint32_t i = 0; i < 10000; i++) {
+        map.add_new(i * 7, i);
+    }
+    for (uint32_t i = 0; i < 10000; i++) {
+        EXPECT_EQ(map.lookup(i * 7), i);
+    }
+    map.set_max_load_factor(0.25f);
+    EXPECT_EQ(map.size(), 10000u);
+    for (uint32_t i = 0; i < 10000; i++) {
+        EXPECT_EQ(map.lookup(i * 7), i);
+    }
+    map.clear();
+    EXPECT_EQ(map.max_load_factor(), 0.25f);
+}
+
+TEST(map, GrowthFactor)
+{
+    Map<int, int> map;
+    map.set_growth_factor(8.0f);
+    EXPECT_EQ(map.growth_factor(), 8.0f);
+    for (int i = 0; i < 1000; i++) {
+        map.add_new(i, i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup(i), i);
+    }
+}
+
+namespace {
+
+struct CountingAllocator {
+    static int allocations;
+
+    void *allocate(size_t size, size_t alignment) const
+    {
+        allocations++;
+        return RawAllocator().allocate(size, alignment);
+    }
+
+    void free(void *pointer) const
+    {
+        RawAllocator().free(pointer);
+    }
+};
+
+int CountingAllocator::allocations = 0;
+
+/* Puts all keys into the same probe sequence, so that groups become full. */
+struct ClusteringHash {
+    uint32_t operator()(uint32_t value) const
+    {
+        return value / 1000;
+    }
+};
+
+}  // namespace
+
+TEST(map, ChurnDoesNotReallocate)
+{
+    Map<uint32_t, uint32_t, CountingAllocator, ClusteringHash> map;
+    for (uint32_t i = 0; i < 100; i++) {
+        map.add_new(i, i);
+    }
+    CountingAllocator::allocations = 0;
+    for (uint32_t i = 100; i < 20000; i++) {
+        map.add_new(i, i);
+        EXPECT_EQ(map.pop(i - 100), i - 100);
+    }
+    EXPECT_LE(CountingAllocator::allocations, 1);
+    EXPECT_EQ(map.size(), 100u);
+    for (uint32_t i = 0; i < 20000; i++) {
+        EXPECT_EQ(map.contains(i), i >= 20000 - 100);
+    }
+}
+
+TEST(map, RemoveFromFullGroups)
+{
+    Map<uint32_t, std::string> map;
+    map.reserve(1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.add_new(i << 20, std::to_string(i));
+    }
+    for (uint32_t i = 0; i < 1000; i += 2) {
+        map.remove(i << 20);
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.contains(i << 20), i % 2 == 1);
+    }
+    for (uint32_t i = 0; i < 1000; i += 2) {
+        map.add_new(i << 20, std::to_string(i));
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup(i << 20), std::to_string(i));
+    }
+}
+
+TEST(map, ComputeStats)
+{
+    Map<int, int> map;
+    HashTableStats empty_stats = map.compute_stats();
+    EXPECT_EQ(empty_stats.size, 0u);
+    EXPECT_EQ(empty_stats.bytes_allocated, 0u);
+
+    for (int i = 0; i < 1000; i++) {
+        map.add_new(i, i);
+    }
+    map.remove(5);
+    HashTableStats stats = map.compute_stats();
+    EXPECT_EQ(stats.size, 999u);
+    EXPECT_GE(stats.capacity, 1998u);
+    EXPECT_FLOAT_EQ(stats.load_factor,
+                    (float)stats.size / (float)stats.capacity);
+    EXPECT_EQ(stats.max_load_factor, 0.5f);
+    EXPECT_GT(stats.bytes_allocated, 1000 * 2 * sizeof(int));
+    EXPECT_LT(stats.bytes_wasted, stats.bytes_allocated);
+    EXPECT_NEAR((double)stats.bytes_wasted,
+                (double)stats.bytes_allocated * (1.0 - stats.load_factor),
+                1.0);
+
+    uint64_t histogram_sum = 0;
+    for (uint64_t amount : stats.probe_length_histogram) {
+        histogram_sum += amount;
+    }
+    EXPECT_EQ(histogram_sum, 999u);
+    EXPECT_EQ(stats.probe_length_histogram.size(),
+              stats.max_probe_length + 1);
+    EXPECT_LE(stats.average_probe_length(), (double)stats.max_probe_length);
+}
+
+TEST(map, ComputeStatsWithCollisions)
+{
+    Map<uint32_t, int, RawAllocator, ClusteringHash> map;
+    for (uint32_t i = 0; i < 100; i++) {
+        map.add_new(i, 0);
+    }
+    HashTableStats stats = map.compute_stats();
+    /* All keys have the same hash, so they fill 7 groups one by one. */
+    EXPECT_EQ(stats.max_probe_length, 6u);
+    EXPECT_EQ(stats.probe_length_histogram[0], 16u);
+    EXPECT_EQ(stats.probe_length_histogram[6], 4u);
+}
+
+TEST(map, AverageProbeLengthOfManyElements)
+{
+    HashTableStats stats;
+    for (uint32_t i = 0; i < 20000000; i++) {
+        stats.add_probe_length(i % 2);
+    }
+    EXPECT_EQ(stats.average_probe_length(), 0.5);
+}
+
+TEST(map, LookupPtrBatch)
+{
+    Map<int, int> map;
+    for (int i = 0; i < 1000; i += 2) {
+        map.add_new(i, i * 10);
+    }
+    for (int amount : {0, 5, 16, 17, 1000}) {
+        Vector<int> keys;
+        for (int i = 0; i < amount; i++) {
+            keys.append(i);
+        }
+        Vector<const int *> values(amount, nullptr);
+        const Map<int, int> &const_map = map;
+        const_map.lookup_ptr_batch(keys, values);
+        for (int i = 0; i < amount; i++) {
+            if (i % 2 == 0) {
+                ASSERT_NE(values[i], nullptr);
+                EXPECT_EQ(*values[i], i * 10);
+            }
+            else {
+                EXPECT_EQ(values[i], nullptr);
+            }
+        }
+    }
+}
+
+TEST(map, LookupPtrBatchMutable)
+{
+    Map<std::string, int> map;
+    map.add_new("a", 1);
+    map.add_new("b", 2);
+    Vector<std::string> keys = {"a", "c", "b"};
+    Vector<int *> values(3, nullptr);
+    map.lookup_ptr_batch(keys, values);
+    EXPECT_EQ(values[1], nullptr);
+    *values[0] = 10;
+    *values[2] = 20;
+    EXPECT_EQ(map.lookup("a"), 10);
+    EXPECT_EQ(map.lookup("b"), 20);
+}
+
+TEST(map, AddMultiple)
+{
+    Map<int, std::string> map;
+    map.add(3, "a");
+    map.add_multiple({1, 2, 3, 2}, {"b", "c", "d", "e"});
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(map.lookup(1), "b");
+    EXPECT_EQ(map.lookup(2), "c");
+    EXPECT_EQ(map.lookup(3), "a");
+}
+
+TEST(map, AddMultipleNewGrowsOnce)
+{
+    Vector<uint32_t> keys;
+    Vector<uint32_t> values;
+    for (uint32_t i = 0; i < 10000; i++) {
+        keys.append(i * 3);
+        values.append(i);
+    }
+
+    Map<uint32_t, uint32_t, CountingAllocator> map;
+    CountingAllocator::allocations = 0;
+    map.add_multiple_new(keys, values);
+    EXPECT_EQ(CountingAllocator::allocations, 1);
+    EXPECT_EQ(map.size(), 10000u);
+    for (uint32_t i = 0; i < 10000; i++) {
+        EXPECT_EQ(map.lookup(i * 3), i);
+        EXPECT_FALSE(map.contains(i * 3 + 1));
+    }
+}
+
+TEST(map, AddMultipleAfterRemove)
+{
+    Map<uint32_t, uint32_t, CountingAllocator, ClusteringHash> map;
+    Vector<uint32_t> keys;
+    for (uint32_t i = 0; i < 1000; i++) {
+        keys.append(i);
+    }
+    map.add_multiple_new(keys, keys);
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.remove(i);
+    }
+    map.add_multiple(keys, keys);
+    EXPECT_EQ(map.size(), 1000u);
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.lookup(i), i);
+    }
+}
+
+TEST(map, ParallelGrow)
+{
+    Map<uint32_t, std::string> map;
+    map.set_grow_threads(4);
+    EXPECT_EQ(map.grow_threads(), 4u);
+    for (uint32_t i = 0; i < 300000; i++) {
+        map.add_new(i, std::to_string(i));
+    }
+    EXPECT_EQ(map.size(), 300000u);
+    for (uint32_t i = 0; i < 300000; i++) {
+        EXPECT_EQ(map.lookup(i), std::to_string(i));
+    }
+    EXPECT_FALSE(map.contains(300000));
+
+    map.clear();
+    EXPECT_EQ(map.grow_threads(), 4u);
+}
+
+namespace {
+
+/* Puts 64 keys into the same home item. */
+struct SmallClusterHash {
+    uint32_t operator()(uint32_t value) const
+    {
+        return value / 64;
+    }
+};
+
+}  // namespace
+
+TEST(map, ParallelGrowWithFullHomeItems)
+{
+    /* Most keys do not fit into their home item, so they are moved by the
+     * fallback that probes. */
+    Map<uint32_t, uint32_t, RawAllocator, SmallClusterHash> map;
+    map.set_grow_threads(3);
+    for (uint32_t i = 0; i < 100000; i++) {
+        map.add_new(i, i * 2);
+    }
+    map.reserve(300000);
+    EXPECT_EQ(map.size(), 100000u);
+    for (uint32_t i = 0; i < 100000; i++) {
+        EXPECT_EQ(map.lookup(i), i * 2);
+    }
+}
+
+TEST(map, IncrementalGrow)
+{
+    Map<uint32_t, std::string> map;
+    map.set_incremental_grow(true);
+    EXPECT_TRUE(map.incremental_grow());
+    bool was_growing = false;
+    for (uint32_t i = 0; i < 100000; i++) {
+        map.add_new(i, std::to_string(i));
+        was_growing |= map.is_growing_incrementally();
+    }
+    EXPECT_TRUE(was_growing);
+    EXPECT_EQ(map.size(), 100000u);
+    for (uint32_t i = 0; i < 100000; i++) {
+        EXPECT_EQ(map.lookup(i), std::to_string(i));
+    }
+    map.clear();
+    EXPECT_TRUE(map.incremental_grow());
+}
+
+TEST(map, RemoveFinishesIncrementalGrow)
+{
+    Map<uint32_t, uint32_t> map;
+    map.set_incremental_grow(true);
+    uint32_t amount = 0;
+    while (!map.is_growing_incrementally()) {
+        map.add_new(amount, amount);
+        amount++;
+    }
+    /* Removals move old items as well, so the old array does not stay
+     * around when nothing is added anymore. */
+    uint32_t key = 0;
+    for (; key < amount && map.is_growing_incrementally(); key++) {
+        if (key % 2 == 0) {
+            map.remove(key);
+        }
+        else {
+            EXPECT_EQ(map.pop(key), key);
+        }
+    }
+    EXPECT_FALSE(map.is_growing_incrementally());
+    EXPECT_LT(key, amount);
+    EXPECT_EQ(map.size(), amount - key);
+    for (uint32_t i = key; i < amount; i++) {
+        EXPECT_EQ(map.lookup(i), i);
+    }
+}
+
+TEST(map, ModifyWhileGrowingIncrementally)
+{
+    Map<uint32_t, uint32_t> map;
+    map.set_incremental_grow(true);
+    uint32_t i = 0;
+    while (!map.is_growing_incrementally()) {
+        map.add_new(i, i);
+        i++;
+    }
+    uint32_t amount = i;
+
+    /* The first key has not been moved yet, when its item is not the first
+     * one in the old array. Modifying it has to move it anyway. */
+    EXPECT_FALSE(map.add(amount - 1, 0));
+    map.lookup(amount - 1) += 10;
+    EXPECT_EQ(map.lookup(amount - 1), amount + 9);
+    map.add_override(amount - 2, 7);
+    EXPECT_EQ(map.lookup(amount - 2), 7u);
+    EXPECT_EQ(map.pop(amount - 3), amount - 3);
+    map.remove(amount - 4);
+    EXPECT_FALSE(map.contains(amount - 3));
+    EXPECT_FALSE(map.contains(amount - 4));
+    EXPECT_EQ(map.size(), amount - 2);
+
+    uint32_t iterated = 0;
+    for (auto item : map.items()) {
+        EXPECT_TRUE(map.contains(item.key));
+        iterated++;
+    }
+    EXPECT_EQ(iterated, amount - 2);
+
+    Map<uint32_t, uint32_t> copied = map;
+    Map<uint32_t, uint32_t> moved = std::move(map);
+    EXPECT_TRUE(moved.is_growing_incrementally());
+    EXPECT_FALSE(map.is_growing_incrementally());
+    for (Map<uint32_t, uint32_t> *other : {&copied, &moved}) {
+        EXPECT_EQ(other->size(), amount - 2);
+        EXPECT_EQ(other->lookup(0), 0u);
+        EXPECT_EQ(other->lookup(amount - 2), 7u);
+        EXPECT_FALSE(other->contains(amount - 4));
+    }
+
+    copied.finish_incremental_grow();
+    EXPECT_FALSE(copied.is_growing_incrementally());
+    EXPECT_EQ(copied.size(), amount - 2);
+    for (uint32_t key = 0; key < amount - 4; key++) {
+        EXPECT_TRUE(copied.contains(key));
+    }
+    HashTableStats stats = moved.compute_stats();
+    EXPECT_GT(stats.bytes_allocated, copied.compute_stats().bytes_allocated);
+}
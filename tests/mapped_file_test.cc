@@ -0,0 +1,37 @@
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "bas/mapped_file.h"
+
+using namespace bas;
+
+TEST(mapped_file, MapFile)
+{
+    std::string path = testing::TempDir() + "bas_mapped_file_test.txt";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "Hello World";
+    }
+    MappedFile file(path.c_str());
+    ASSERT_TRUE(file.is_open());
+    EXPECT_EQ(file.size(), 11);
+    EXPECT_TRUE(is_aligned(file.data(), 64));
+    EXPECT_EQ(std::string(file.data(), file.size()), "Hello World");
+
+    MappedFile moved = std::move(file);
+    EXPECT_FALSE(file.is_open());
+    EXPECT_EQ(moved.buffer().size(), 11);
+    EXPECT_EQ(moved.buffer()[6], 'W');
+    moved.close();
+    EXPECT_FALSE(moved.is_open());
+    std::remove(path.c_str());
+}
+
+TEST(mapped_file, MissingFile)
+{
+    MappedFile file("/this/file/does/not/exist");
+    EXPECT_FALSE(file.is_open());
+    EXPECT_EQ(file.size(), 0);
+}
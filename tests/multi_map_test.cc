@@ -65,6 +65,39 @@ TEST(multi_map, AddMultiple)
     EXPECT_EQ(map.lookup_default(2)[4], 1);
 }
 
+TEST(multi_map, AddMultipleGrowsValues)
+{
+    MultiMap<int, std::string> map;
+    map.add(1, "a");
+    map.add_multiple(1, {"b", "c", "d", "e"});
+    map.add_multiple(1, {});
+    map.add_multiple(2, {});
+    EXPECT_EQ(map.key_amount(), 1u);
+    ArrayRef<std::string> values = map.lookup(1);
+    EXPECT_EQ(values.size(), 5u);
+    EXPECT_EQ(values[0], "a");
+    EXPECT_EQ(values[4], "e");
+    map.add(1, "f");
+    EXPECT_EQ(map.lookup(1).size(), 6u);
+    EXPECT_EQ(map.lookup(1)[5], "f");
+}
+
+TEST(multi_map, AddMultipleFromOther)
+{
+    MultiMap<int, int> a;
+    for (int i = 0; i < 100; i++) {
+        a.add(i % 30, i);
+    }
+    MultiMap<int, int> b;
+    b.add(5, -1);
+    b.add_multiple(a);
+    EXPECT_EQ(b.key_amount(), 30u);
+    EXPECT_EQ(b.lookup(5).size(), 5u);
+    EXPECT_EQ(b.lookup(5)[0], -1);
+    EXPECT_EQ(b.lookup(5)[1], 5);
+    EXPECT_EQ(b.lookup(29).size(), 3u);
+}
+
 TEST(multi_map, AddMultipleNew)
 {
     MultiMap<int, int> map;
@@ -108,3 +141,13 @@ TEST(multi_map, Keys)
     EXPECT_TRUE(values.contains(4));
     EXPECT_TRUE(values.contains(2));
 }
+
+TEST(multi_map, ComputeStats)
+{
+    MultiMap<int, int> map;
+    map.add(1, 2);
+    map.add(1, 3);
+    map.add(2, 4);
+    HashTableStats stats = map.compute_stats();
+    EXPECT_EQ(stats.size, 2u);
+}
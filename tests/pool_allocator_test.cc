@@ -0,0 +1,92 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "bas/map.h"
+#include "bas/pool_allocator.h"
+#include "bas/set.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+TEST(pool_allocator, Alignment)
+{
+    PoolAllocator allocator;
+    for (size_t size : {1, 8, 17, 100, 1000, 2032, 2033, 5000}) {
+        for (size_t alignment : {1, 4, 8, 16, 64, 512}) {
+            void *pointer = allocator.allocate(size, alignment);
+            EXPECT_TRUE(is_aligned(pointer, alignment));
+            memset(pointer, 0xFF, size);
+            allocator.free(pointer);
+        }
+    }
+    allocator.free(nullptr);
+}
+
+TEST(pool_allocator, ReusesFreedBlocks)
+{
+    PoolAllocator allocator;
+    void *a = allocator.allocate(40, 8);
+    allocator.free(a);
+    void *b = allocator.allocate(40, 8);
+    EXPECT_EQ(a, b);
+    allocator.free(b);
+}
+
+TEST(pool_allocator, DistinctBlocks)
+{
+    PoolAllocator allocator;
+    Vector<uint64_t *> pointers;
+    for (uint64_t i = 0; i < 10000; i++) {
+        uint64_t *pointer = (uint64_t *)allocator.allocate(
+            sizeof(uint64_t) * (i % 50 + 1), 8);
+        pointer[0] = i;
+        pointers.append(pointer);
+    }
+    for (uint64_t i = 0; i < 10000; i++) {
+        EXPECT_EQ(pointers[i][0], i);
+        allocator.free(pointers[i]);
+    }
+}
+
+TEST(pool_allocator, Containers)
+{
+    Vector<int, 4, PoolAllocator> vector;
+    for (int i = 0; i < 1000; i++) {
+        vector.append(i);
+    }
+    EXPECT_EQ(vector.size(), 1000u);
+    EXPECT_EQ(vector[999], 999);
+
+    Map<int, int, PoolAllocator> map;
+    Set<int, PoolAllocator> set;
+    for (int i = 0; i < 1000; i++) {
+        map.add_new(i, i * 2);
+        set.add_new(i);
+    }
+    EXPECT_EQ(map.lookup(500), 1000);
+    EXPECT_TRUE(set.contains(999));
+}
+
+TEST(pool_allocator, FreeInOtherThread)
+{
+    PoolAllocator allocator;
+    Vector<void *> pointers;
+    for (int i = 0; i < 5000; i++) {
+        pointers.append(allocator.allocate(64, 8));
+    }
+    std::thread thread([&]() {
+        for (void *pointer : pointers) {
+            allocator.free(pointer);
+        }
+        /* Blocks that are cached by this thread are given back when it
+         * exits. */
+        for (int i = 0; i < 100; i++) {
+            pointers[i] = allocator.allocate(64, 8);
+        }
+    });
+    thread.join();
+    for (int i = 0; i < 100; i++) {
+        allocator.free(pointers[i]);
+    }
+}
@@ -152,6 +152,90 @@ TEST(set, AddMultipleNew)
     EXPECT_TRUE(a.contains(6));
 }
 
+TEST(set, AddMultipleMany)
+{
+    Vector<int> values;
+    for (int i = 0; i < 10000; i++) {
+        values.append(i % 7000);
+    }
+    Set<int> set;
+    set.add(3);
+    set.add_multiple(values);
+    EXPECT_EQ(set.size(), 7000u);
+    for (int i = 0; i < 7000; i++) {
+        EXPECT_TRUE(set.contains(i));
+    }
+    EXPECT_FALSE(set.contains(7000));
+
+    set.add_multiple(values);
+    EXPECT_EQ(set.size(), 7000u);
+}
+
+TEST(set, ParallelGrow)
+{
+    Set<std::string> set;
+    set.set_grow_threads(4);
+    for (int i = 0; i < 200000; i++) {
+        set.add_new(std::to_string(i));
+    }
+    EXPECT_EQ(set.size(), 200000u);
+    for (int i = 0; i < 200000; i++) {
+        EXPECT_TRUE(set.contains(std::to_string(i)));
+    }
+    EXPECT_FALSE(set.contains("-1"));
+}
+
+TEST(set, RemoveFinishesIncrementalGrow)
+{
+    Set<int> set;
+    set.set_incremental_grow(true);
+    int amount = 0;
+    while (!set.is_growing_incrementally()) {
+        set.add_new(amount);
+        amount++;
+    }
+    int value = 0;
+    for (; value < amount && set.is_growing_incrementally(); value++) {
+        set.remove(value);
+    }
+    EXPECT_FALSE(set.is_growing_incrementally());
+    EXPECT_LT(value, amount);
+    EXPECT_EQ((int)set.size(), amount - value);
+    for (int i = value; i < amount; i++) {
+        EXPECT_TRUE(set.contains(i));
+    }
+}
+
+TEST(set, IncrementalGrow)
+{
+    Set<std::string> set;
+    set.set_incremental_grow(true);
+    bool was_growing = false;
+    for (int i = 0; i < 50000; i++) {
+        set.add_new(std::to_string(i));
+        was_growing |= set.is_growing_incrementally();
+        if (i % 7 == 0) {
+            EXPECT_FALSE(set.add(std::to_string(i / 2)));
+        }
+    }
+    EXPECT_TRUE(was_growing);
+    EXPECT_EQ(set.size(), 50000u);
+    for (int i = 0; i < 50000; i++) {
+        EXPECT_TRUE(set.contains(std::to_string(i)));
+    }
+
+    while (!set.is_growing_incrementally()) {
+        set.add(std::to_string(set.size()));
+    }
+    set.remove("0");
+    EXPECT_FALSE(set.contains("0"));
+    Set<std::string> copied = set;
+    EXPECT_EQ(copied.to_vector().size(), set.size());
+    set.set_incremental_grow(false);
+    EXPECT_FALSE(set.is_growing_incrementally());
+    EXPECT_EQ(set.to_vector().size(), copied.size());
+}
+
 TEST(set, ToVector)
 {
     Set<int> a = {5, 2, 8};
@@ -198,3 +282,96 @@ TEST(set, UniquePtrValues)
 
     EXPECT_EQ(set.size(), 3u);
 }
+
+TEST(set, StringValues)
+{
+    Set<std::string> set;
+    for (int i = 0; i < 100; i++) {
+        set.add(std::to_string(i));
+    }
+    EXPECT_EQ(set.size(), 100u);
+    EXPECT_TRUE(set.contains("42"));
+    EXPECT_FALSE(set.contains("100"));
+    set.remove("42");
+    EXPECT_FALSE(set.contains("42"));
+}
+
+TEST(set, SizeT64)
+{
+    Set<std::string, RawAllocator, DefaultHash<std::string>, uint64_t> set;
+    for (int i = 0; i < 100; i++) {
+        set.add(std::to_string(i));
+    }
+    uint64_t size = set.size();
+    EXPECT_EQ(size, 100u);
+    EXPECT_TRUE(set.contains("42"));
+    EXPECT_FALSE(set.contains("100"));
+    set.remove("42");
+    EXPECT_FALSE(set.contains("42"));
+}
+
+TEST(set, MaxLoadFactor)
+{
+    Set<int> set;
+    set.set_max_load_factor(0.9f);
+    set.set_growth_factor(4.0f);
+    for (int i = 0; i < 1000; i++) {
+        set.add_new(i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(set.contains(i));
+    }
+    EXPECT_FALSE(set.contains(1000));
+    Set<int> copied = set;
+    EXPECT_EQ(copied.max_load_factor(), 0.9f);
+    EXPECT_EQ(copied.growth_factor(), 4.0f);
+}
+
+/* Puts all strings into the same probe sequence. */
+struct FirstCharStringHash {
+    uint32_t operator()(const std::string &value) const
+    {
+        return (uint32_t)value[0];
+    }
+};
+
+TEST(set, ChurnWithStrings)
+{
+    Set<std::string, RawAllocator, FirstCharStringHash> set;
+    for (int i = 0; i < 10000; i++) {
+        set.add_new(std::to_string(i));
+        if (i >= 50) {
+            set.remove(std::to_string(i - 50));
+        }
+    }
+    EXPECT_EQ(set.size(), 50u);
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_EQ(set.contains(std::to_string(i)), i >= 10000 - 50);
+    }
+}
+
+TEST(set, ComputeStats)
+{
+    Set<int> set = {1, 2, 3, 4};
+    HashTableStats stats = set.compute_stats();
+    EXPECT_EQ(stats.size, 4u);
+    EXPECT_EQ(stats.probe_length_histogram[0], 4u);
+    EXPECT_EQ(stats.average_probe_length(), 0.0);
+}
+
+TEST(set, ContainsBatch)
+{
+    Set<int> set;
+    for (int i = 0; i < 100; i += 3) {
+        set.add_new(i);
+    }
+    Vector<int> values;
+    for (int i = 0; i < 100; i++) {
+        values.append(i);
+    }
+    Vector<bool> results(100);
+    set.contains_batch(values, results);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(results[i], i % 3 == 0);
+    }
+}
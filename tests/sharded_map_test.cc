@@ -0,0 +1,86 @@
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "bas/sharded_map.h"
+
+using namespace bas;
+
+TEST(sharded_map, DefaultConstructor)
+{
+    ShardedMap<int, float> map;
+    EXPECT_EQ(map.size(), 0u);
+    EXPECT_FALSE(map.contains(3));
+}
+
+TEST(sharded_map, AddAndLookup)
+{
+    ShardedMap<int, std::string, 4> map;
+    EXPECT_TRUE(map.add(1, "a"));
+    EXPECT_FALSE(map.add(1, "b"));
+    map.add_new(2, "c");
+    EXPECT_FALSE(map.add_override(2, "d"));
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.lookup_default(1, ""), "a");
+    EXPECT_EQ(map.lookup_default(2, ""), "d");
+    EXPECT_EQ(map.lookup_default(3, "x"), "x");
+}
+
+TEST(sharded_map, KeysAreDistributed)
+{
+    ShardedMap<int, int, 8> map;
+    for (int i = 0; i < 1000; i++) {
+        map.add_new(i, i);
+    }
+    Map<int, int> merged = map.merge();
+    EXPECT_EQ(merged.size(), 1000u);
+    EXPECT_EQ(map.size(), 0u);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(merged.lookup(i), i);
+    }
+}
+
+TEST(sharded_map, AddOrModifyWithAllocator)
+{
+    ShardedMap<int, int *> map;
+    for (int i = 0; i < 10; i++) {
+        map.add_or_modify(
+            i % 3,
+            [&](int **r_value, LinearAllocator<> &allocator) {
+                *r_value = allocator.allocate<int>();
+                **r_value = 1;
+            },
+            [&](int **value, LinearAllocator<> & /*allocator*/) {
+                **value += 1;
+            });
+    }
+    EXPECT_EQ(*map.lookup_default(0, nullptr), 4);
+    EXPECT_EQ(*map.lookup_default(1, nullptr), 3);
+    EXPECT_EQ(*map.lookup_default(2, nullptr), 3);
+}
+
+TEST(sharded_map, ParallelAdd)
+{
+    ShardedMap<uint32_t, uint32_t> map;
+    const uint32_t keys_per_thread = 10000;
+    Vector<std::thread> threads;
+    for (uint32_t t = 0; t < 8; t++) {
+        threads.append(std::thread([&, t]() {
+            for (uint32_t i = 0; i < keys_per_thread; i++) {
+                uint32_t key = t * keys_per_thread + i;
+                map.add_new(key, t);
+                EXPECT_FALSE(map.add(key, 100));
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(map.size(), 8 * keys_per_thread);
+    Map<uint32_t, uint32_t> merged = map.merge();
+    for (uint32_t i = 0; i < 8 * keys_per_thread; i++) {
+        EXPECT_EQ(merged.lookup(i), i / keys_per_thread);
+    }
+}
@@ -0,0 +1,208 @@
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "bas/simd_search.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+enum class Color : uint16_t { Red, Green, Blue };
+
+/* Compare every kernel with a scalar loop for all sizes and positions, so
+ * that the vectorized parts and the remainders are both covered. */
+template<typename T> static void test_kernels(const Vector<T> &values)
+{
+    for (size_t size = 0; size <= values.size(); size++) {
+        const T *data = values.begin();
+        for (const T &value : values) {
+            ssize_t expected_index = -1;
+            size_t expected_count = 0;
+            for (size_t i = 0; i < size; i++) {
+                if (data[i] == value) {
+                    if (expected_index == -1) {
+                        expected_index = (ssize_t)i;
+                    }
+                    expected_count++;
+                }
+            }
+            EXPECT_EQ(find_first_equal(data, size, value), expected_index);
+            EXPECT_EQ(count_equal(data, size, value), expected_count);
+        }
+        EXPECT_TRUE(arrays_equal(data, data, size));
+    }
+}
+
+template<typename T> static Vector<T> make_values(size_t size)
+{
+    Vector<T> values;
+    for (size_t i = 0; i < size; i++) {
+        values.append((T)((i * 7) % 23));
+    }
+    return values;
+}
+
+TEST(simd_search, FindAndCountIntegers)
+{
+    test_kernels(make_values<int8_t>(70));
+    test_kernels(make_values<uint8_t>(70));
+    test_kernels(make_values<int16_t>(70));
+    test_kernels(make_values<uint32_t>(70));
+    test_kernels(make_values<int64_t>(70));
+    test_kernels(make_values<uint64_t>(70));
+}
+
+TEST(simd_search, FindAndCountOtherTypes)
+{
+    test_kernels(make_values<float>(40));
+    test_kernels(make_values<double>(40));
+
+    Vector<Color> colors;
+    Vector<const int *> pointers;
+    int ints[5];
+    for (int i = 0; i < 40; i++) {
+        colors.append((Color)(i % 3));
+        pointers.append(ints + i % 5);
+    }
+    test_kernels(colors);
+    test_kernels(pointers);
+}
+
+TEST(simd_search, FindFloatsByValue)
+{
+    Vector<float> values = {1.0f, -0.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+    EXPECT_EQ(find_first_equal(values.begin(), values.size(), 0.0f), 1);
+    EXPECT_EQ(count_equal(values.begin(), values.size(), 0.0f), 1u);
+}
+
+TEST(simd_search, FindLargeValues)
+{
+    Vector<uint64_t> values(100, 0);
+    values[77] = (uint64_t)1 << 40;
+    values[90] = 1;
+    EXPECT_EQ(find_first_equal(values.begin(), 100, (uint64_t)1 << 40), 77);
+    EXPECT_EQ(find_first_equal(values.begin(), 100, (uint64_t)1), 90);
+    EXPECT_EQ(find_first_equal(values.begin(), 100, (uint64_t)2), -1);
+    EXPECT_EQ(count_equal(values.begin(), 100, (uint64_t)0), 98u);
+}
+
+TEST(simd_search, CountManySmallValues)
+{
+    Vector<int8_t> bytes(100000, 3);
+    Vector<uint16_t> shorts(300000, 3);
+    bytes[500] = 4;
+    shorts[70000] = 4;
+    EXPECT_EQ(count_equal(bytes.begin(), bytes.size(), (int8_t)3), 99999u);
+    EXPECT_EQ(count_equal(shorts.begin(), shorts.size(), (uint16_t)3),
+              299999u);
+}
+
+TEST(simd_search, ArraysEqual)
+{
+    Vector<int> a = make_values<int>(50);
+    Vector<int> b = a;
+    EXPECT_TRUE(arrays_equal(a.begin(), b.begin(), 50));
+    b[49] = -1;
+    EXPECT_FALSE(arrays_equal(a.begin(), b.begin(), 50));
+    EXPECT_TRUE(arrays_equal(a.begin(), b.begin(), 49));
+
+    Vector<float> c = {0.0f, 1.0f};
+    Vector<float> d = {-0.0f, 1.0f};
+    EXPECT_TRUE(arrays_equal(c.begin(), d.begin(), 2));
+}
+
+/* Compare the char set kernels with scalar loops for all sizes. */
+static void test_char_set_kernels(const std::string &str, const CharSet &set)
+{
+    for (size_t size = 0; size <= str.size(); size++) {
+        const char *data = str.data();
+        ssize_t first_in = -1;
+        ssize_t first_not_in = -1;
+        ssize_t last_not_in = -1;
+        for (size_t i = 0; i < size; i++) {
+            bool contained = set.contains(data[i]);
+            if (contained && first_in == -1) {
+                first_in = (ssize_t)i;
+            }
+            if (!contained) {
+                if (first_not_in == -1) {
+                    first_not_in = (ssize_t)i;
+                }
+                last_not_in = (ssize_t)i;
+            }
+        }
+        EXPECT_EQ(find_first_in(data, size, set), first_in);
+        EXPECT_EQ(find_first_not_in(data, size, set), first_not_in);
+        EXPECT_EQ(find_last_not_in(data, size, set), last_not_in);
+    }
+}
+
+TEST(simd_search, CharSetKernels)
+{
+    std::string text = "  \t  some words,\tand\n\r\n   more  ; text "
+                       "with  \xe4 bytes  \xff  ";
+    std::string spaces(70, ' ');
+    std::string middle = spaces + "x" + spaces;
+    for (const std::string &str : {text, spaces, middle}) {
+        test_char_set_kernels(str, CharSet::whitespace());
+        test_char_set_kernels(str, {' '});
+        test_char_set_kernels(str, {});
+        test_char_set_kernels(str, {',', ';', (char)0xff});
+        test_char_set_kernels(str, CharSet(" \t\n\rabcdefgh", 12));
+    }
+}
+
+TEST(simd_search, EqualLowerAscii)
+{
+    std::string lower = "hello world, this is @[` {ascii}\xc4 text!";
+    std::string mixed = "HeLLo WORLD, this Is @[` {ASCII}\xc4 TexT!";
+    for (size_t size = 0; size <= lower.size(); size++) {
+        EXPECT_TRUE(equal_lower_ascii(mixed.data(), lower.data(), size));
+        EXPECT_TRUE(equal_lower_ascii(lower.data(), lower.data(), size));
+    }
+    for (size_t i = 0; i < lower.size(); i++) {
+        std::string other = lower;
+        other[i] = '#';
+        EXPECT_FALSE(
+            equal_lower_ascii(mixed.data(), other.data(), lower.size()));
+    }
+    /* Only A-Z are converted. */
+    EXPECT_FALSE(equal_lower_ascii("@[", "`{", 2));
+    EXPECT_FALSE(equal_lower_ascii("\xc4", "\xe4", 1));
+}
+
+template<typename T> static void test_min_max(const Vector<T> &values)
+{
+    for (size_t size = 1; size <= values.size(); size++) {
+        T expected_min = values[0];
+        T expected_max = values[0];
+        for (size_t i = 0; i < size; i++) {
+            expected_min = std::min(expected_min, values[i]);
+            expected_max = std::max(expected_max, values[i]);
+        }
+        EXPECT_EQ(min_value(values.begin(), size), expected_min);
+        EXPECT_EQ(max_value(values.begin(), size), expected_max);
+    }
+}
+
+TEST(simd_search, MinMax)
+{
+    Vector<int32_t> signed_values;
+    Vector<uint32_t> unsigned_values;
+    Vector<int8_t> bytes;
+    Vector<uint16_t> shorts;
+    Vector<double> doubles;
+    for (int i = 0; i < 100; i++) {
+        int value = (i * 37) % 101 - 50;
+        signed_values.append(value * 1000);
+        unsigned_values.append((uint32_t)value);
+        bytes.append((int8_t)value);
+        shorts.append((uint16_t)(value * 600));
+        doubles.append(value * 0.5);
+    }
+    test_min_max(signed_values);
+    test_min_max(unsigned_values);
+    test_min_max(bytes);
+    test_min_max(shorts);
+    test_min_max(doubles);
+}
@@ -232,3 +232,14 @@ TEST(string_map, UniquePtrValues)
     std::unique_ptr<int> *b = map.lookup_ptr("A");
     EXPECT_EQ(a.get(), b->get());
 }
+
+TEST(string_map, ComputeStats)
+{
+    StringMap<int> map;
+    map.add_new("A", 1);
+    map.add_new("Hello World", 2);
+    HashTableStats stats = map.compute_stats();
+    EXPECT_EQ(stats.size, 2u);
+    EXPECT_EQ(stats.dummy_amount, 0u);
+    EXPECT_GT(stats.bytes_allocated, 0u);
+}
@@ -1,3 +1,6 @@
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "bas/string_ref.h"
@@ -298,6 +301,125 @@ TEST(string_ref, Strip)
     EXPECT_EQ(ref.strip({' ', '\t', '\n', 't'}), "es");
 }
 
+TEST(string_ref, StripLong)
+{
+    std::string spaces(100, ' ');
+    std::string str = spaces + "\t a b \n" + spaces;
+    StringRef ref = str;
+    EXPECT_EQ(ref.lstrip(), "a b \n" + spaces);
+    EXPECT_EQ(ref.rstrip(), spaces + "\t a b");
+    EXPECT_EQ(ref.strip(), "a b");
+    EXPECT_EQ(StringRef(spaces).strip(), "");
+    EXPECT_EQ(ref.strip({' ', '\t', '\n', 'a', 'b'}), "");
+}
+
+TEST(string_ref, StripManyChars)
+{
+    StringRef ref("0123456789abc9876543210");
+    CharSet digits("0123456789", 10);
+    EXPECT_EQ(ref.lstrip(digits), "abc9876543210");
+    EXPECT_EQ(ref.rstrip(digits), "0123456789abc");
+    EXPECT_EQ(ref.strip(digits), "abc");
+}
+
+TEST(string_ref, StripArrayOfChars)
+{
+    StringRef ref("xyhelloyx");
+    Vector<char> chars = {'x', 'y'};
+    ArrayRef<char> chars_ref = chars;
+    EXPECT_EQ(ref.lstrip(chars), "helloyx");
+    EXPECT_EQ(ref.rstrip(chars_ref), "xyhello");
+    EXPECT_EQ(ref.strip(chars), "hello");
+    EXPECT_EQ(StringRefNull("yxa").lstrip(chars_ref), "a");
+}
+
+TEST(string_ref, EqualsLong)
+{
+    std::string a(100, 'a');
+    std::string b = a;
+    EXPECT_EQ(StringRef(a), StringRef(b));
+    b[99] = 'b';
+    EXPECT_NE(StringRef(a), StringRef(b));
+    EXPECT_TRUE(StringRef(b).startswith(a.substr(0, 99)));
+    EXPECT_FALSE(StringRef(b).endswith(a.substr(0, 99)));
+}
+
+TEST(string_ref, StartsWithLowerAsciiLong)
+{
+    StringRef ref("Content-Type: Text/Plain; Charset=UTF-8");
+    EXPECT_TRUE(ref.startswith_lower_ascii("content-type: text/plain"));
+    EXPECT_FALSE(ref.startswith_lower_ascii("content-type: text/html"));
+    EXPECT_FALSE(ref.startswith_lower_ascii(
+        "content-type: text/plain; charset=utf-8 and more"));
+}
+
+static std::vector<std::string> split_to_vector(StringRef str, char c)
+{
+    std::vector<std::string> parts;
+    for (StringRef part : str.split(c)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+TEST(string_ref, Split)
+{
+    using Parts = std::vector<std::string>;
+    EXPECT_EQ(split_to_vector("a,b,c", ','), Parts({"a", "b", "c"}));
+    EXPECT_EQ(split_to_vector("a,,b,", ','), Parts({"a", "", "b", ""}));
+    EXPECT_EQ(split_to_vector(",", ','), Parts({"", ""}));
+    EXPECT_EQ(split_to_vector("abc", ','), Parts({"abc"}));
+    EXPECT_EQ(split_to_vector("", ','), Parts({""}));
+    EXPECT_EQ(split_to_vector(StringRef(), ','), Parts({""}));
+}
+
+TEST(string_ref, SplitReferencesString)
+{
+    StringRef str = "key=value";
+    auto split = str.split('=');
+    auto it = split.begin();
+    EXPECT_EQ((*it).data(), str.data());
+    ++it;
+    EXPECT_EQ((*it).data(), str.data() + 4);
+    ++it;
+    EXPECT_FALSE(it != split.end());
+}
+
+static std::vector<std::string> tokenize_to_vector(StringRef str,
+                                                   const CharSet &set)
+{
+    std::vector<std::string> tokens;
+    for (StringRef token : str.tokenize(set)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+TEST(string_ref, Tokenize)
+{
+    using Tokens = std::vector<std::string>;
+    const CharSet &spaces = CharSet::whitespace();
+    EXPECT_EQ(tokenize_to_vector("  a bc\t\n d ", spaces),
+              Tokens({"a", "bc", "d"}));
+    EXPECT_EQ(tokenize_to_vector("abc", spaces), Tokens({"abc"}));
+    EXPECT_EQ(tokenize_to_vector("", spaces), Tokens());
+    EXPECT_EQ(tokenize_to_vector(" \t ", spaces), Tokens());
+    EXPECT_EQ(tokenize_to_vector("a;b,,c", {',', ';'}),
+              Tokens({"a", "b", "c"}));
+    EXPECT_EQ(tokenize_to_vector("1a22b333", CharSet("abcdefghij", 10)),
+              Tokens({"1", "22", "333"}));
+}
+
+TEST(string_ref, TokenizeDefault)
+{
+    size_t count = 0;
+    for (StringRef token : StringRef("the  quick\nbrown fox").tokenize()) {
+        EXPECT_FALSE(token.contains(' '));
+        count++;
+    }
+    EXPECT_EQ(count, 4u);
+}
+
 TEST(string_ref_null, Strip)
 {
     StringRefNull ref1("  test  ");
@@ -330,6 +452,185 @@ TEST(string_ref, ToFloat)
     test_invalid_float_conversion("");
 }
 
+TEST(string_ref, ToFloatSkipsPrefix)
+{
+    test_valid_float_conversion("  \t1.5", 1.5f);
+    test_valid_float_conversion("+1.5", 1.5f);
+    test_valid_float_conversion("-1.5abc", -1.5f);
+    test_invalid_float_conversion("+-1.5");
+}
+
+TEST(string_ref, ToFloatOutOfRange)
+{
+    test_invalid_float_conversion("1e100");
+    test_invalid_float_conversion("-1e100");
+}
+
+TEST(string_ref, ToFloatHex)
+{
+    /* Only the leading zero is a number in the general format. */
+    test_valid_float_conversion("0x1p4", 0.0f);
+}
+
+TEST(string_ref, ToInt)
+{
+    bool success = false;
+    EXPECT_EQ(StringRef("42").to_int(&success), 42);
+    EXPECT_TRUE(success);
+    EXPECT_EQ(StringRef(" +7 apples").to_int(&success), 7);
+    EXPECT_TRUE(success);
+    EXPECT_EQ(StringRef("-2147483648").to_int(&success), INT32_MIN);
+    EXPECT_TRUE(success);
+    EXPECT_EQ(StringRef("2147483648").to_int(&success), 0);
+    EXPECT_FALSE(success);
+    EXPECT_EQ(StringRef("x1").to_int(&success), 0);
+    EXPECT_FALSE(success);
+}
+
+template<typename T>
+static void test_parse(StringRef str, T expected, size_t expected_consumed)
+{
+    T value = 0;
+    EXPECT_EQ(str.parse(value), expected_consumed);
+    EXPECT_EQ(value, expected);
+}
+
+template<typename T> static void test_parse_fails(StringRef str)
+{
+    T value = 3;
+    EXPECT_EQ(str.parse(value), 0u);
+    EXPECT_EQ(value, 3);
+}
+
+TEST(string_ref, ParseInt)
+{
+    test_parse<int>("123", 123, 3);
+    test_parse<int>("-123,5", -123, 4);
+    test_parse<int>("007", 7, 3);
+    test_parse<int8_t>("127", 127, 3);
+    test_parse<int8_t>("-128", -128, 4);
+    test_parse<uint8_t>("255", 255, 3);
+    test_parse<int64_t>("-9223372036854775808", INT64_MIN, 20);
+    test_parse<uint64_t>("18446744073709551615", UINT64_MAX, 20);
+    test_parse_fails<int8_t>("128");
+    test_parse_fails<int8_t>("-129");
+    test_parse_fails<uint8_t>("256");
+    test_parse_fails<uint8_t>("-1");
+    test_parse_fails<uint64_t>("18446744073709551616");
+    test_parse_fails<int>("");
+    test_parse_fails<int>("-");
+    test_parse_fails<int>(" 1");
+    test_parse_fails<int>("+1");
+    test_parse_fails<int>("a1");
+}
+
+/* The limits never end with a 9, so incrementing the last digit gives the
+ * first number that is out of range. */
+static std::string increment_last_digit(std::string str)
+{
+    str.back()++;
+    return str;
+}
+
+template<typename T> static void test_parse_limits()
+{
+    T min = std::numeric_limits<T>::min();
+    T max = std::numeric_limits<T>::max();
+    std::string min_str = std::to_string(min);
+    std::string max_str = std::to_string(max);
+    test_parse<T>(min_str, min, min_str.size());
+    test_parse<T>(max_str, max, max_str.size());
+    test_parse_fails<T>(increment_last_digit(max_str));
+    if (min != 0) {
+        test_parse_fails<T>(increment_last_digit(min_str));
+    }
+    test_parse<T>("000000000000000000000000000042", 42, 30);
+}
+
+TEST(string_ref, ParseIntLimits)
+{
+    test_parse_limits<int8_t>();
+    test_parse_limits<uint8_t>();
+    test_parse_limits<int16_t>();
+    test_parse_limits<uint16_t>();
+    test_parse_limits<int32_t>();
+    test_parse_limits<uint32_t>();
+    test_parse_limits<int64_t>();
+    test_parse_limits<uint64_t>();
+}
+
+TEST(string_ref, ParseHex)
+{
+    uint32_t value = 0;
+    EXPECT_EQ(StringRef("ff").parse_hex(value), 2u);
+    EXPECT_EQ(value, 255u);
+    EXPECT_EQ(StringRef("0xDeadBeef").parse_hex(value), 10u);
+    EXPECT_EQ(value, 0xdeadbeefu);
+    EXPECT_EQ(StringRef("0xg").parse_hex(value), 1u);
+    EXPECT_EQ(value, 0u);
+    EXPECT_EQ(StringRef("100000000").parse_hex(value), 0u);
+
+    int16_t signed_value = 0;
+    EXPECT_EQ(StringRef("-0x8000").parse_hex(signed_value), 7u);
+    EXPECT_EQ(signed_value, INT16_MIN);
+    EXPECT_EQ(StringRef("8000").parse_hex(signed_value), 0u);
+}
+
+TEST(string_ref, ParseFloat)
+{
+    test_parse<float>("1.5", 1.5f, 3);
+    test_parse<float>("-2.5e-3 ", -2.5e-3f, 7);
+    test_parse<float>(".5", 0.5f, 2);
+    test_parse<double>("0.1", 0.1, 3);
+    test_parse<double>("1e308", 1e308, 5);
+    test_parse<double>(
+        "123456789012345678901234567890", 1.2345678901234568e29, 30);
+    test_parse_fails<float>("1e39");
+    test_parse_fails<double>("");
+    test_parse_fails<double>("e5");
+    test_parse_fails<double>("+1");
+    test_parse_fails<double>(" 1");
+}
+
+TEST(string_ref, ParseFloatRounding)
+{
+    /* Halfway between 1 and the next float, so it rounds to even. */
+    test_parse<float>("1.00000005960464477539062500", 1.0f, 28);
+    /* Slightly above halfway, so it rounds up. */
+    test_parse<float>(
+        "1.00000005960464477539062501", 1.00000011920928955078125f, 28);
+    test_parse<double>("2.2250738585072011e-308", 2.225073858507201e-308, 23);
+}
+
+TEST(string_ref, ParseSplit)
+{
+    Vector<int> values = {7};
+    EXPECT_TRUE(StringRef("1,-2, 3 ,4\r\n").parse_split(',', values));
+    EXPECT_EQ(values.size(), 5u);
+    EXPECT_EQ(values[0], 7);
+    EXPECT_EQ(values[1], 1);
+    EXPECT_EQ(values[2], -2);
+    EXPECT_EQ(values[3], 3);
+    EXPECT_EQ(values[4], 4);
+
+    Vector<double> doubles;
+    EXPECT_TRUE(StringRef("0.5;1e3").parse_split(';', doubles));
+    EXPECT_EQ(doubles.size(), 2u);
+    EXPECT_EQ(doubles[1], 1000.0);
+}
+
+TEST(string_ref, ParseSplitInvalid)
+{
+    Vector<int> values;
+    EXPECT_FALSE(StringRef("1,2x,3").parse_split(',', values));
+    EXPECT_EQ(values.size(), 1u);
+    values.clear();
+    EXPECT_FALSE(StringRef("1,,3").parse_split(',', values));
+    values.clear();
+    EXPECT_FALSE(StringRef("").parse_split(',', values));
+    EXPECT_FALSE(StringRef("1 2").parse_split(',', values));
+}
+
 TEST(string_ref, Copy)
 {
     StringRef ref("hello");
@@ -0,0 +1,107 @@
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "bas/parallel_for.h"
+#include "bas/task_pool.h"
+
+using namespace bas;
+
+TEST(task_pool, SpawnAndWait)
+{
+    TaskPool pool(3);
+    EXPECT_EQ(pool.worker_amount(), 3u);
+    std::atomic<uint32_t> counter{0};
+    auto increment = [&]() { counter++; };
+    TaskGroup group(pool);
+    for (uint32_t i = 0; i < 1000; i++) {
+        group.spawn(increment);
+    }
+    group.wait();
+    EXPECT_EQ(counter.load(), 1000u);
+}
+
+TEST(task_pool, NoWorkers)
+{
+    /* The waiting thread runs all tasks itself. */
+    TaskPool pool(0);
+    uint32_t counter = 0;
+    auto increment = [&]() { counter++; };
+    TaskGroup group(pool);
+    group.spawn(increment);
+    group.spawn(increment);
+    group.wait();
+    EXPECT_EQ(counter, 2u);
+}
+
+TEST(task_pool, WaitInsideTask)
+{
+    TaskPool pool(2);
+    std::atomic<uint32_t> counter{0};
+    auto outer = [&]() {
+        TaskGroup inner_group(pool);
+        auto inner = [&]() { counter++; };
+        for (uint32_t i = 0; i < 10; i++) {
+            inner_group.spawn(inner);
+        }
+        inner_group.wait();
+    };
+    TaskGroup group(pool);
+    for (uint32_t i = 0; i < 10; i++) {
+        group.spawn(outer);
+    }
+    group.wait();
+    EXPECT_EQ(counter.load(), 100u);
+}
+
+TEST(parallel_for, CoversRangeOnce)
+{
+    TaskPool pool(3);
+    std::atomic<uint32_t> counts[1000] = {};
+    std::atomic<size_t> max_chunk_size{0};
+    parallel_for(
+        IndexRange(100, 800),
+        7,
+        [&](IndexRange range) {
+            size_t size = range.size();
+            size_t old_max = max_chunk_size.load();
+            while (size > old_max &&
+                   !max_chunk_size.compare_exchange_weak(old_max, size)) {
+            }
+            for (size_t i : range) {
+                counts[i]++;
+            }
+        },
+        pool);
+    EXPECT_LE(max_chunk_size.load(), 7u);
+    for (size_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(counts[i].load(), (i >= 100 && i < 900) ? 1u : 0u);
+    }
+}
+
+TEST(parallel_for, EmptyAndSmallRanges)
+{
+    uint32_t calls = 0;
+    parallel_for(IndexRange(), 10, [&](IndexRange /*range*/) { calls++; });
+    EXPECT_EQ(calls, 0u);
+    parallel_for(IndexRange(5, 3), 10, [&](IndexRange range) {
+        EXPECT_EQ(range, IndexRange(5, 3));
+        calls++;
+    });
+    EXPECT_EQ(calls, 1u);
+}
+
+TEST(parallel_for, Nested)
+{
+    std::atomic<uint64_t> sum{0};
+    parallel_for(IndexRange(100), 3, [&](IndexRange outer) {
+        for (size_t i : outer) {
+            parallel_for(IndexRange(100), 10, [&](IndexRange inner) {
+                for (size_t j : inner) {
+                    sum += i * j;
+                }
+            });
+        }
+    });
+    EXPECT_EQ(sum.load(), 4950ull * 4950ull);
+}
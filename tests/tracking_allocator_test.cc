@@ -0,0 +1,82 @@
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "bas/map.h"
+#include "bas/tracking_allocator.h"
+#include "bas/vector.h"
+
+using namespace bas;
+
+struct TestVectorTag {
+    static constexpr const char *name = "test vectors";
+};
+
+struct TestMapTag {
+    static constexpr const char *name = "test maps";
+};
+
+TEST(tracking_allocator, CountsBytes)
+{
+    using Allocator = TrackingAllocator<TestVectorTag>;
+    AllocationStats &stats = Allocator::stats();
+    uint64_t allocations_before = stats.allocation_count();
+    uint64_t live_before = stats.live_bytes();
+
+    Allocator allocator;
+    void *a = allocator.allocate(100, 8);
+    void *b = allocator.allocate(1000, 64);
+    EXPECT_TRUE(is_aligned(b, 64));
+    EXPECT_EQ(stats.live_bytes(), live_before + 1100);
+    EXPECT_EQ(stats.allocation_count(), allocations_before + 2);
+    EXPECT_GE(stats.size_histogram(6), 1u);
+    EXPECT_GE(stats.size_histogram(9), 1u);
+
+    allocator.free(a);
+    EXPECT_EQ(stats.live_bytes(), live_before + 1000);
+    EXPECT_GE(stats.peak_bytes(), live_before + 1100);
+    stats.reset_peak();
+    EXPECT_EQ(stats.peak_bytes(), stats.live_bytes());
+    allocator.free(b);
+    EXPECT_EQ(stats.live_bytes(), live_before);
+    EXPECT_EQ(stats.live_allocation_count(),
+              allocations_before + 2 - (stats.free_count()));
+}
+
+TEST(tracking_allocator, Containers)
+{
+    AllocationStats &stats = TrackingAllocator<TestMapTag>::stats();
+    uint64_t live_before = stats.live_bytes();
+    {
+        Map<int, int, TrackingAllocator<TestMapTag>> map;
+        for (int i = 0; i < 1000; i++) {
+            map.add_new(i, i);
+        }
+        EXPECT_GE(stats.live_bytes(),
+                  live_before + map.compute_stats().bytes_allocated);
+        EXPECT_GT(stats.peak_bytes(), stats.live_bytes() - live_before);
+    }
+    EXPECT_EQ(stats.live_bytes(), live_before);
+
+    Vector<int, 4, TrackingAllocator<TestVectorTag>> vector;
+    for (int i = 0; i < 100; i++) {
+        vector.append(i);
+    }
+    EXPECT_GE(TrackingAllocator<TestVectorTag>::stats().live_bytes(),
+              100 * sizeof(int));
+}
+
+TEST(tracking_allocator, Registry)
+{
+    TrackingAllocator<TestMapTag>::stats();
+    AllocationRegistry &registry = AllocationRegistry::global();
+    const AllocationStats *stats = registry.lookup("test maps");
+    ASSERT_NE(stats, nullptr);
+    EXPECT_EQ(stats, &TrackingAllocator<TestMapTag>::stats());
+    EXPECT_EQ(registry.lookup("unknown"), nullptr);
+
+    std::stringstream stream;
+    registry.print(stream);
+    EXPECT_NE(stream.str().find("Allocation Stats: test maps"),
+              std::string::npos);
+}
@@ -102,6 +102,31 @@ TEST(vector_set, Remove)
     EXPECT_EQ(set.size(), 0u);
 }
 
+TEST(vector_set, AddMultiple)
+{
+    VectorSet<int> set = {1, 2};
+    Vector<int> values;
+    for (int i = 0; i < 1000; i++) {
+        values.append(1000 - i);
+    }
+    set.add_multiple(values);
+    EXPECT_EQ(set.size(), 1000u);
+    EXPECT_EQ(set[0], 1);
+    EXPECT_EQ(set[1], 2);
+    EXPECT_EQ(set[2], 1000);
+    EXPECT_EQ(set.index(3), 999u);
+}
+
+TEST(vector_set, AddMultipleNew)
+{
+    VectorSet<int> set;
+    set.add_multiple_new({5, 3, 8});
+    set.add_multiple_new({4, 9});
+    EXPECT_EQ(set.size(), 5u);
+    EXPECT_EQ(set[2], 8);
+    EXPECT_EQ(set[4], 9);
+}
+
 TEST(vector_set, UniquePtrValue)
 {
     VectorSet<std::unique_ptr<int>> set;
@@ -112,3 +137,78 @@ TEST(vector_set, UniquePtrValue)
 
     BAS_UNUSED_VAR(value);
 }
+
+TEST(vector_set, StringValues)
+{
+    VectorSet<std::string> set;
+    for (int i = 0; i < 100; i++) {
+        set.add(std::to_string(i));
+    }
+    EXPECT_EQ(set.size(), 100u);
+    EXPECT_EQ(set.index("42"), 42u);
+    EXPECT_EQ(set.index_try("100"), -1);
+    set.remove("42");
+    EXPECT_EQ(set.index_try("42"), -1);
+    EXPECT_EQ(set.index("99"), 42u);
+}
+
+TEST(vector_set, SizeT64)
+{
+    VectorSet<int, RawAllocator, DefaultHash<int>, uint64_t> set;
+    for (int i = 0; i < 100; i++) {
+        set.add(i * 3);
+    }
+    uint64_t index = set.index(30);
+    EXPECT_EQ(index, 10u);
+    int64_t missing = set.index_try(31);
+    EXPECT_EQ(missing, -1);
+    set.remove(0);
+    EXPECT_EQ(set.index(297), 0u);
+}
+
+TEST(vector_set, MaxLoadFactor)
+{
+    VectorSet<int> set;
+    set.set_max_load_factor(0.8f);
+    for (int i = 0; i < 1000; i++) {
+        set.add_new(i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(set.index(i), (uint32_t)i);
+    }
+    set.set_max_load_factor(0.3f);
+    EXPECT_EQ(set.index(500), 500u);
+}
+
+TEST(vector_set, RaiseMaxLoadFactorWhenPopulated)
+{
+    VectorSet<int> set;
+    for (int i = 0; i < 1000; i++) {
+        set.add_new(i);
+    }
+    set.set_max_load_factor(0.95f);
+    for (int i = 1000; i < 5000; i++) {
+        set.add_new(i);
+    }
+    EXPECT_EQ(set.size(), 5000u);
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQ(set.index(i), (uint32_t)i);
+    }
+}
+
+TEST(vector_set, ComputeStats)
+{
+    VectorSet<int> set;
+    for (int i = 0; i < 100; i++) {
+        set.add_new(i);
+    }
+    HashTableStats stats = set.compute_stats();
+    EXPECT_EQ(stats.size, 100u);
+    EXPECT_GE(stats.bytes_allocated,
+              stats.capacity * sizeof(int) + 100 * sizeof(int));
+    uint64_t histogram_sum = 0;
+    for (uint64_t amount : stats.probe_length_histogram) {
+        histogram_sum += amount;
+    }
+    EXPECT_EQ(histogram_sum, 100u);
+}
@@ -419,3 +419,93 @@ TEST(vector, UniquePtrValue)
     BAS_UNUSED_VAR(a);
     BAS_UNUSED_VAR(b);
 }
+
+/* Counts how often it is moved. */
+template<bool Relocatable> struct MoveCounter {
+    static constexpr bool trivially_relocatable = Relocatable;
+    static inline int moves = 0;
+
+    int value;
+
+    MoveCounter(int value) : value(value)
+    {
+    }
+
+    MoveCounter(MoveCounter &&other) noexcept : value(other.value)
+    {
+        moves++;
+    }
+
+    ~MoveCounter()
+    {
+    }
+};
+
+struct OptInRelocatable {
+    std::unique_ptr<int> pointer;
+};
+
+namespace bas {
+template<>
+struct is_trivially_relocatable<OptInRelocatable> : std::true_type {
+};
+}  // namespace bas
+
+TEST(vector, TriviallyRelocatableTrait)
+{
+    EXPECT_TRUE(is_trivially_relocatable<int>::value);
+    EXPECT_TRUE(is_trivially_relocatable<int *>::value);
+    EXPECT_TRUE(is_trivially_relocatable<std::unique_ptr<int>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<std::unique_ptr<int[]>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<std::shared_ptr<int>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<MoveCounter<true>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<OptInRelocatable>::value);
+    EXPECT_FALSE(is_trivially_relocatable<MoveCounter<false>>::value);
+    EXPECT_FALSE(is_trivially_relocatable<Vector<int>>::value);
+}
+
+TEST(vector, GrowRelocatesWithoutMoving)
+{
+    MoveCounter<true>::moves = 0;
+    MoveCounter<false>::moves = 0;
+    Vector<MoveCounter<true>> relocatable;
+    Vector<MoveCounter<false>> movable;
+    for (int i = 0; i < 100; i++) {
+        relocatable.append(MoveCounter<true>(i));
+        movable.append(MoveCounter<false>(i));
+    }
+    /* Only the append itself moves. */
+    EXPECT_EQ(MoveCounter<true>::moves, 100);
+    EXPECT_GT(MoveCounter<false>::moves, 200);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(relocatable[i].value, i);
+        EXPECT_EQ(movable[i].value, i);
+    }
+}
+
+TEST(vector, GrowUniquePtrs)
+{
+    Vector<std::unique_ptr<int>, 2> vec;
+    for (int i = 0; i < 100; i++) {
+        vec.append(std::unique_ptr<int>(new int(i)));
+    }
+    Vector<std::unique_ptr<int>, 2> moved = std::move(vec);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(*moved[i], i);
+    }
+}
+
+TEST(vector, GrowOverAligned)
+{
+    struct alignas(64) Aligned {
+        int value;
+    };
+    Vector<Aligned, 2> vec;
+    for (int i = 0; i < 1000; i++) {
+        vec.append({i});
+        EXPECT_TRUE(is_aligned(vec.begin(), 64));
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(vec[i].value, i);
+    }
+}